@@ -24,13 +24,16 @@
 
 #import "ViKernel.h"
 #import "ViContext.h"
+#import "ViUploadQueue.h"
 #import "ViScene.h"
 #import "ViSceneNode.h"
 #import "ViSprite.h"
 #import "ViSpriteFactory.h"
 #import "ViSpriteBatch.h"
+#import "ViNineSliceSprite.h"
 #import "ViTMXNode.h"
 #import "ViTMXLayer.h"
+#import "ViTextNode.h"
 #import "ViParticleEmitter.h"
 #import "ViParticle.h"
 
@@ -44,6 +47,13 @@
 
 #import "ViTexture.h"
 #import "ViTexturePVR.h"
+#import "ViTextureAtlas.h"
+#import "ViAlphaHull.h"
+#import "ViTextureArray.h"
+#import "ViPixelReadback.h"
+#import "ViResolutionController.h"
+#import "ViDebugDraw.h"
+#import "ViFont.h"
 #import "ViColor.h"
 #import "ViMesh.h"
 
@@ -53,7 +63,14 @@
 #import "ViBridge.h"
 
 #import "ViRenderer.h"
+#import "ViRenderCommand.h"
+#import "ViRenderTarget.h"
+#import "ViFrameStats.h"
+#import "ViCommandRenderer.h"
 #import "ViRendererOSX.h"
+#import "ViRendererNull.h"
+#import "ViRendererSoftware.h"
+#import "ViRenderTrace.h"
 
 #import "ViViewProtocol.h"
 #import "ViViewOSX.h"
@@ -115,6 +132,61 @@ namespace vi
 
 /**
  * @page changelog Changelog
+ * <b>Upcoming version</b><br />
+ * Added vertex array object caching per mesh and shader to the renderer when running on an OpenGL 3.2 Core Profile context<br />
+ * Changed the renderer to only enable and disable vertex attributes that actually changed between two draw calls<br />
+ * Added vi::graphic::renderCommandList and vi::graphic::commandRenderer, the scene traversal is now separated from the OpenGL backend<br />
+ * Added vi::graphic::rendererNull, a renderer that only records the commands of a frame<br />
+ * Added vi::scene::camera::update()<br />
+ * Added vi::graphic::renderTarget, a pool of framebuffers and textures that is used by cameras rendering into textures<br />
+ * Added vi::scene::camera::renderOnDemand to only render offscreen cameras when something they see changed<br />
+ * Added packed vertex formats to vi::common::mesh, particle emitters and sprite batches now send 16 instead of 32 bytes per vertex to the GPU<br />
+ * Changed the renderer to cull UI nodes against the screen<br />
+ * Added vi::scene::sceneNodeFlagCacheContent to render static UI subtrees into a cached texture<br />
+ * Added vi::graphic::frameStats, the counters and timings of the last frame can be read with vi::common::kernel::getFrameStats()<br />
+ * Added vi::graphic::textureAtlas, which packs textures into pages at runtime, and vi::graphic::textureRegion for sprites and sprite batches<br />
+ * Fixed that textures created from a handle or as empty texture had an uninitialized scale factor<br />
+ * Added vi::common::uploadQueue, which decodes textures on worker threads and uploads them on a shared context without blocking the rendering<br />
+ * Added vi::graphic::texture::upload() and constructors for textures and PVR textures that only decode the file<br />
+ * Fixed that PVR textures never deleted their OpenGL texture<br />
+ * Added vi::graphic::commandRenderer::depthSorting, which draws opaque scene nodes front to back with a depth buffer to reduce overdraw<br />
+ * Added vi::graphic::material::isOpaque() and vi::graphic::texture::hasAlphaChannel()<br />
+ * Added a usesDepthBuffer property to ViViewOSX and ViViewiOS, and a matching parameter to the vi::common::context constructor<br />
+ * Added vi::graphic::rendererSoftware, a multithreaded tile based software rasterizer backend for headless reference image and throughput tests<br />
+ * Added vi::graphic::texture::setKeepsPixelData() and vi::graphic::texture::getPixelData()<br />
+ * Added vi::graphic::font and vi::scene::textNode, which render text with BMFont bitmap fonts using one mesh per string and a material per font<br />
+ * Added vi::scene::nineSliceSprite, which stretches a texture region with fixed borders using a single mesh, and vi::scene::spriteBatch::addNineSliceSprite()<br />
+ * Added vi::graphic::alphaHull, which generates a convex polygon around the visible pixels of an image<br />
+ * Added vi::graphic::textureRegion::hull, texture atlases generate it for textures that keep their pixel data, see vi::graphic::textureAtlas::setHullGeneration()<br />
+ * Added vi::scene::sprite::setHull(), sprites with a texture region now draw its hull instead of the quad to skip transparent pixels<br />
+ * Added vi::scene::sceneNodeFlagStaticLayer, which draws static scene layers into a cached texture around the camera, and vi::scene::sceneNode::setNeedsContentUpdate()<br />
+ * Added vi::graphic::commandRenderer::partialRedraw, which only redraws the changed region of a view and skips views that didn't change<br />
+ * Added a preservesBackbuffer property to ViViewOSX and ViViewiOS, and a matching parameter to the vi::common::context constructor<br />
+ * Fixed that ViViewOSX never stored the value of allowsCoreProfile<br />
+ * Added vi::scene::sceneNodeFlagHidden to skip nodes and their childs while rendering<br />
+ * vi::scene::tmxNode now hides tiles that are covered by opaque tiles of upper layers<br />
+ * Added vi::scene::tmxLayer::setTile() and vi::scene::tmxLayer::getTile()<br />
+ * Added vi::graphic::texture::purgePixelData(), vi::graphic::texture::getScaleFactor() and vi::graphic::texture::getKeepsPixelData()<br />
+ * Fixed that tilesets other than the first of a TMX map were never found<br />
+ * Added vi::graphic::renderTrace and vi::graphic::commandRenderer::captureTrace() to record the submitted command lists into a file<br />
+ * Added the TraceReplay tool which replays render traces with per draw timings<br />
+ * Added vi::graphic::renderer::finishFrame()<br />
+ * Added vi::graphic::shader::getVertexFile() and vi::graphic::shader::getFragmentFile()<br />
+ * Added vi::graphic::textureArray, which combines equally sized textures into the layers of a GL_TEXTURE_2D_ARRAY on OpenGL 3.2 Core Profile contexts<br />
+ * Added vi::graphic::defaultShaderTextureArray and vi::graphic::texture::getTarget()<br />
+ * Sprite batches using a texture array draw sprites of different textures with one draw call, see vi::scene::sprite::setTextureLayer()<br />
+ * TMX maps share a texture array between equally sized tilesets, layers can now use tiles from every tileset<br />
+ * Added vi::graphic::pixelReadback, which reads framebuffers back through a ring of pixel pack buffers without stalling the rendering<br />
+ * Added vi::scene::camera::readPixels() and vi::scene::camera::streamPixels(), streamed frames are handed to a worker thread<br />
+ * Added vi::scene::camera::setResolutionScale(), view cameras can render their scene nodes into a smaller texture that is upscaled into the view<br />
+ * Added vi::graphic::resolutionController, which adjusts the resolution scale of a camera to keep the frame time within a budget<br />
+ * Added vi::scene::camera::renderInterval, the scene staggers cameras that only render every n-th frame across the frames<br />
+ * Added vi::scene::sceneNode::getSubtreeBounds(), the quadtree and the renderer reject whole subtrees with a single test and childs are no longer clipped with their parent<br />
+ * Added vi::scene::sceneNode::getBounds(), the quadtree, the renderer and vi::scene::scene::trace() use bounds that cover the rotation and scale of the nodes<br />
+ * Added vi::scene::sceneNode::freeze() and unfreeze(), frozen subtrees are baked into static meshes that are merged by material and drawn without visiting the subtree<br />
+ * Added vi::graphic::debugDraw, an immediate mode debug draw for lines and shapes with visualizers for the quadtree, traces and the physical space, see vi::common::kernel::getDebugDraw()<br />
+ * <br />
+ * <br />
  * <b>Version 0.4.0</b><br />
  * Added chipmunk support<br />
  * Added support for animations<br />
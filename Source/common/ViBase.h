@@ -7,9 +7,31 @@
 //
 
 #ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+#define GL_DO_NOT_WARN_IF_MULTI_GL_VERSION_HEADERS_INCLUDED
 #import <OpenGL/OpenGL.h>
 #import <OpenGL/gl.h>
 #import <OpenGL/glext.h>
+/**
+ * Defined if pixel buffer objects are available, cameras then read their pixels back asynchronously.
+ **/
+#define ViPixelBufferObjects
+#if __MAC_OS_X_VERSION_MAX_ALLOWED >= __MAC_10_7
+#import <OpenGL/gl3.h>
+/**
+ * Defined if the OpenGL 3.2 Core Profile entry points are available (Mac OS X 10.7+), the renderer then uses vertex array objects on core profile contexts.
+ **/
+#define ViVertexArrayObjects
+/**
+ * Defined if sync objects are available, the upload queue then publishes uploads with fences on core profile contexts.
+ **/
+#define ViSyncObjects
+#endif
+#ifdef GL_EXT_timer_query
+/**
+ * Defined if the EXT_timer_query entry points are available, the renderer then measures the GPU time of a frame if the context supports the extension.
+ **/
+#define ViTimerQueries
+#endif
 #endif
 
 #ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
@@ -18,6 +40,9 @@
 #import <OpenGLES/ES2/gl.h>
 #import <OpenGLES/ES2/glext.h>
 #import <QuartzCore/QuartzCore.h>
+#ifdef GL_APPLE_sync
+#define ViSyncObjects
+#endif
 #endif
 
 #ifdef __ARM_NEON__
@@ -33,10 +33,13 @@ namespace vi
              * @brief Constructor
              * @details Constructor for a context which doesn't share its data with another context.
              * @param glslVersion The desired GSlang version you want, without the dot. Eg. 120 for GLSL 1.20. Currently supported are 120 and 150 (10.7 only!).
+             * @param preserveBackbuffer True if the content of the back buffer should be preserved when the buffers are swapped, required for partial redraws.
+             * @param depthBuffer True if the pixel format should have a 16 bit depth buffer, required for depth sorting.
              * @remark The passed GLSL Version is just a hint for the context, if the desired version isn't available, the context will fallback to a working version.
-             * @note Only Mac OS X makes use of the GLSL Version, on iOS the passed version is ignored.
+             * @note Only Mac OS X makes use of the GLSL Version, preserveBackbuffer and depthBuffer, on iOS they are ignored and the view decides whether its
+             * back buffer is preserved and whether it has a depth buffer.
              **/
-            context(GLuint glslVersion=120);
+            context(GLuint glslVersion=120, bool preserveBackbuffer=false, bool depthBuffer=false);
             /**
              * @brief Constructor for a shared context
              * @details Creates a new context that shares data with the given context
@@ -85,6 +88,11 @@ namespace vi
              * @note Only useful on OS X, since iOS doesn't support multiple GLSL Versions.
              **/
             GLuint getGLSLVersion();
+            /**
+             * @brief Returns true if the context was created with a depth buffer.
+             * @note Only useful on OS X, on iOS the view decides whether it has a depth buffer.
+             **/
+            bool hasDepthBuffer();
             
             /**
              * @brief Returns a shared shader object.
@@ -122,6 +130,7 @@ namespace vi
             context     *sharedContext;
             
             GLuint glsl; // Only used on OS X
+            bool usesDepthBuffer; // Only used on OS X
             std::map<vi::graphic::defaultShader, vi::graphic::shader *> defaultShaders;
             
 #ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
@@ -8,6 +8,7 @@
 
 #include <vector>
 #import "ViContext.h"
+#import "ViRenderTarget.h"
 
 namespace vi
 {
@@ -19,8 +20,8 @@ namespace vi
         static std::vector<vi::common::context *> contextList; // List containing all active contexts.
         
 #ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
-        NSOpenGLPixelFormat *contextCreatePixelFormat(GLuint glslVersion, GLuint *resultGlsl);
-        NSOpenGLPixelFormat *contextCreatePixelFormat(GLuint glslVersion, GLuint *resultGlsl)
+        NSOpenGLPixelFormat *contextCreatePixelFormat(GLuint glslVersion, bool preserveBackbuffer, bool depthBuffer, GLuint *resultGlsl);
+        NSOpenGLPixelFormat *contextCreatePixelFormat(GLuint glslVersion, bool preserveBackbuffer, bool depthBuffer, GLuint *resultGlsl)
         {
             // This variable holds the actual used GLSL version.
             GLuint usedGlsl = 120;
@@ -31,9 +32,35 @@ namespace vi
                 NSOpenGLPFAOpenGLProfile, NSOpenGLProfileVersionLegacy, // We start with the old OpenGL 2.0 profile and GLSL 1.20
                 NSOpenGLPFADoubleBuffer,
                 NSOpenGLPFAColorSize, 24,
+                0, 0, 0, // Reserved for NSOpenGLPFADepthSize and NSOpenGLPFABackingStore
                 0
             };
             
+            uint32_t index = 5;
+#else
+            // Well, looks like we are on a old Mac OS X version, so we are forced to use the legacy profile:
+            NSOpenGLPixelFormatAttribute attributes[] =
+            {
+                NSOpenGLPFADoubleBuffer,
+                NSOpenGLPFAColorSize, 24,
+                0, 0, 0, // Reserved for NSOpenGLPFADepthSize and NSOpenGLPFABackingStore
+                0
+            };
+            
+            uint32_t index = 3;
+#endif
+            
+            // The depth buffer is only used by the depth sorting of the renderer, so it's only requested when asked for
+            if(depthBuffer)
+            {
+                attributes[index ++] = NSOpenGLPFADepthSize;
+                attributes[index ++] = 16;
+            }
+            
+            if(preserveBackbuffer)
+                attributes[index ++] = NSOpenGLPFABackingStore;
+            
+#if __MAC_OS_X_VERSION_MAX_ALLOWED >= __MAC_10_7
             if(glslVersion == 150)
             {
                 // If the user requested GLSL 1.50, we determine if the App is currently running on at least 10.7...
@@ -51,14 +78,6 @@ namespace vi
                     }
                 }
             }
-#else
-            // Well, looks like we are on a old Mac OS X version, so we are forced to use the legacy profile:
-            NSOpenGLPixelFormatAttribute attributes[] =
-            {
-                NSOpenGLPFADoubleBuffer,
-                NSOpenGLPFAColorSize, 24,
-                0
-            };
 #endif
             
             // Create the pixelformat
@@ -74,19 +93,20 @@ namespace vi
         
         
         
-        context::context(GLuint glslVersion)
+        context::context(GLuint glslVersion, bool preserveBackbuffer, bool depthBuffer)
         {
             // Set up everything for the context
             glsl    = glslVersion;
             active  = false;
             shared  = false;
+            usesDepthBuffer = depthBuffer;
             
             
 #ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
             nativeContext = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES2];
 #endif
 #ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
-            pixelFormat     = [vi::common::contextCreatePixelFormat(glslVersion, &glsl) retain]; // Request a new NSOpenGLPixelFormat which is appropriate for our use
+            pixelFormat     = [vi::common::contextCreatePixelFormat(glslVersion, preserveBackbuffer, depthBuffer, &glsl) retain]; // Request a new NSOpenGLPixelFormat which is appropriate for our use
             nativeContext   = [[NSOpenGLContext alloc] initWithFormat:pixelFormat shareContext:nil];
 #endif
         }
@@ -100,6 +120,7 @@ namespace vi
             active  = false;
             shared  = true;
             sharedContext = otherContext;
+            usesDepthBuffer = otherContext->usesDepthBuffer;
             
             
 #ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
@@ -114,6 +135,10 @@ namespace vi
         
         context::~context()
         {
+            // Framebuffers aren't shared, so the render targets of the context can't be reused by a context that is created at the same address later
+            activateContext();
+            vi::graphic::renderTarget::purgeRenderTargets(this);
+            
             deactivateContext(); // This flushes the context automatically
             
             // Delete all created shader objects.
@@ -284,6 +309,11 @@ namespace vi
             return glsl;
         }
         
+        bool context::hasDepthBuffer()
+        {
+            return usesDepthBuffer;
+        }
+        
         vi::graphic::shader *context::getShader(vi::graphic::defaultShader type)
         {
             if(shared)
@@ -15,6 +15,8 @@
 #import "ViRenderer.h"
 #import "ViBridge.h"
 #import "ViContext.h"
+#import "ViUploadQueue.h"
+#import "ViDebugDraw.h"
 
 namespace vi
 {
@@ -113,6 +115,24 @@ namespace vi
              * Returns a pointer to the context used by the kernel.
              **/
             vi::common::context *getContext();
+            /**
+             * Returns the statistics of the last completely rendered frame.
+             **/
+            vi::graphic::frameStats const& getFrameStats();
+            /**
+             * Returns the upload queue of the kernel, which is created with the kernels context on the first call.
+             * @remark The kernel publishes the finished uploads of the queue at the beginning of every frame.
+             **/
+            vi::common::uploadQueue *getUploadQueue();
+            /**
+             * Returns the debug draw of the kernel, which is created on the first call.
+             * @remark The kernel removes the shapes of the debug draw at the end of every frame.
+             **/
+            vi::graphic::debugDraw *getDebugDraw();
+            /**
+             * Returns true if the debug draw was requested with getDebugDraw(). Renderers use this to skip the debug draw without creating it.
+             **/
+            bool hasDebugDraw();
             
             
             /**
@@ -130,11 +150,17 @@ namespace vi
             float scaleFactor;
             
         private:
+            void updateResolutionControllers(vi::scene::scene *scene);
+            
             ALCdevice *device;
             std::vector<vi::scene::scene *> scenes;
             
             vi::graphic::renderer   *renderer;
             vi::common::context     *context;
+            vi::graphic::frameStats lastFrameStats;
+            uint32_t frame;
+            vi::common::uploadQueue *uploads;
+            vi::graphic::debugDraw *debug;
             bool ownsContext;
             
             id timer;
@@ -7,6 +7,7 @@
 //
 
 #include <tr1/functional>
+#include <algorithm>
 #import "ViKernel.h"
 #import "ViRenderer.h"
 #import "ViEvent.h"
@@ -32,10 +33,13 @@ namespace vi
             timestep = 0.0;
             lastDraw = 0.0;
             scaleFactor = 1.0f;
+            frame = 0;
             
             device = alcOpenDevice(NULL);
             timer  = nil;
             bridge = nil;
+            uploads = NULL;
+            debug   = NULL;
             _sharedKernel = this;
             
             
@@ -71,6 +75,8 @@ namespace vi
             alcCloseDevice(device);
             
             delete renderer;
+            delete uploads;
+            delete debug;
             
             if(ownsContext)
                 delete context;
@@ -107,12 +113,33 @@ namespace vi
             event.timestep = timestep;
             event.raise();
             
+            vi::graphic::frameStats *stats = renderer->getFrameStats();
+            double frameBegin = vi::graphic::frameStats::timestamp();
+            
+            stats->reset();
+            stats->frame = frame ++;
+            
+            if(uploads)
+                uploads->publish();
+            
+            vi::graphic::pixelReadback::collectAll();
+            
             if(scenes.size() > 0)
             {
                 vi::scene::scene *scene = scenes.back();
+                
+                updateResolutionControllers(scene);
                 scene->draw(renderer, timestep);
             }
             
+            renderer->finishFrame();
+            
+            if(debug)
+                debug->clear();
+            
+            stats->frameTime = vi::graphic::frameStats::timestamp() - frameBegin;
+            lastFrameStats = *stats;
+            
             
             double currentTime = [NSDate timeIntervalSinceReferenceDate];
             
@@ -126,6 +153,33 @@ namespace vi
             event.raise();
         }
         
+        void kernel::updateResolutionControllers(vi::scene::scene *scene)
+        {
+            // The first frame has no stats to go by
+            if(frame <= 1)
+                return;
+            
+            // Every controller sees the last frame exactly once, even if several view cameras share it or a camera skips the frame
+            std::vector<vi::graphic::resolutionController *> updated;
+            std::vector<vi::scene::camera *> cameras = scene->getCameras();
+            
+            std::vector<vi::scene::camera *>::iterator iterator;
+            for(iterator=cameras.begin(); iterator!=cameras.end(); iterator++)
+            {
+                vi::scene::camera *camera = *iterator;
+                if(!camera->view || !camera->controller)
+                    continue;
+                
+                if(std::find(updated.begin(), updated.end(), camera->controller) == updated.end())
+                {
+                    camera->controller->update(lastFrameStats);
+                    updated.push_back(camera->controller);
+                }
+                
+                camera->setResolutionScale(camera->controller->getScale());
+            }
+        }
+        
         void kernel::startRendering(uint32_t maxFPS)
         {
             stopRendering();
@@ -212,6 +266,32 @@ namespace vi
             return renderer;
         }
         
+        vi::graphic::frameStats const& kernel::getFrameStats()
+        {
+            return lastFrameStats;
+        }
+        
+        vi::common::uploadQueue *kernel::getUploadQueue()
+        {
+            if(!uploads)
+                uploads = new vi::common::uploadQueue(context);
+            
+            return uploads;
+        }
+        
+        vi::graphic::debugDraw *kernel::getDebugDraw()
+        {
+            if(!debug)
+                debug = new vi::graphic::debugDraw();
+            
+            return debug;
+        }
+        
+        bool kernel::hasDebugDraw()
+        {
+            return (debug != NULL);
+        }
+        
         
         
         void kernel::checkError()
@@ -13,8 +13,15 @@
 
 namespace vi
 {
+    namespace graphic
+    {
+        class shader;
+    }
+    
     namespace common
-    {      
+    {
+        class context;
+        
         typedef struct
         {
             GLfloat x, y;
@@ -22,6 +29,65 @@ namespace vi
             GLfloat r, g, b, a;
         } vertex;
         
+        /**
+         * Vertex layout of vertexFormatPacked, 16 bytes per vertex
+         **/
+        typedef struct
+        {
+            GLfloat x, y;
+            GLushort u, v;
+            GLubyte r, g, b, a;
+        } packedVertex;
+        
+        /**
+         * Vertex layout of vertexFormatPackedShort, 12 bytes per vertex
+         **/
+        typedef struct
+        {
+            GLshort x, y;
+            GLushort u, v;
+            GLubyte r, g, b, a;
+        } packedShortVertex;
+        
+        /**
+         * The formats in which a mesh stores its vertices and sends them to the GPU. Meshes with a packed format only store the packed vertices, vertices
+         * that are added or changed through the mesh are packed right away, so uploads don't have to convert them.
+         **/
+        typedef enum
+        {
+            /**
+             * 32 bytes per vertex, floating point position, texture coordinates and color. This is the default.
+             **/
+            vertexFormatFloat,
+            /**
+             * 16 bytes per vertex, floating point position, normalized 16 bit texture coordinates and a normalized 8 bit color.
+             * @remark Texture coordinates are clamped to 0.0 - 1.0, so this format can't be used for repeating textures.
+             **/
+            vertexFormatPacked,
+            /**
+             * 12 bytes per vertex, 16 bit integer position, normalized 16 bit texture coordinates and a normalized 8 bit color.
+             * @remark Positions are rounded to whole numbers and must be in the range of -32768 to 32767.
+             **/
+            vertexFormatPackedShort
+        } vertexFormat;
+        
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            GLuint program;
+            uint32_t generation;
+            vi::common::context *context;
+            
+            GLuint vao;
+            GLuint vbo, ivbo;
+            uint32_t revision;
+        } meshVertexArray;
+        /**
+         * @endcond
+         **/
+        
         class mesh
         {
         public:      
@@ -56,6 +122,7 @@ namespace vi
             /**
              * Generates VBOs for the mesh
              * @param dyn If true, the mesh will generate a pair of VBOs for dynamic usage
+             * @remark Don't call this or updateVBO() from within a visit() function, the renderer might have a vertex array object bound at that time.
              **/
             void generateVBO(bool dyn=false);
             /**
@@ -64,8 +131,43 @@ namespace vi
             void updateVBO();
             
             
+            /**
+             * Returns the vertices for writing. Meshes with a packed format convert their vertices back to vi::common::vertex for this, and pack them
+             * again with the next call to getVertexData(), which is called by the renderer and by uploads. Use getVertex() to only read vertices.
+             **/
             vertex   *getVertices();
+            /**
+             * Returns the vertex at the given index, unpacked if the mesh has a packed format.
+             **/
+            vertex getVertex(uint32_t index) const;
             uint16_t *getIndices();
+            const uint16_t *getIndices() const;
+            
+            /**
+             * Sets the format in which the vertices are stored and sent to the GPU. The existing vertices are converted, and if the mesh has VBOs, they
+             * are regenerated.
+             **/
+            void setVertexFormat(vertexFormat format);
+            /**
+             * Returns the format in which the vertices are sent to the GPU.
+             **/
+            vertexFormat getVertexFormat();
+            /**
+             * Returns the size of one vertex in the current vertex format in bytes.
+             **/
+            uint32_t getVertexStride();
+            /**
+             * Returns the vertices in the current vertex format. For packed formats, the vertices are only converted if they were unpacked by getVertices().
+             **/
+            const void *getVertexData();
+            
+            /**
+             * Returns the cached vertex array object for the given shader and context and the current buffers of the mesh. If there is no such vertex array
+             * object yet, an outdated or a new, unspecified one is returned, which has to be specified by the caller. Shaders are told apart by their
+             * program and generation, so a new shader at the address of a deleted one doesn't get its vertex array objects.
+             * @remark Used by renderers that support vertex array objects, vertex array objects are deleted together with the mesh.
+             **/
+            meshVertexArray *vertexArrayForShader(vi::graphic::shader *shader, vi::common::context *context);
             
             
             /**
@@ -93,10 +195,17 @@ namespace vi
              * The handle to the current index VBO
              **/
             GLuint ivbo;
+            /**
+             * Incremented every time the VBOs are regenerated.
+             **/
+            uint32_t revision;
             
         protected:
             void resizeVertices(int32_t appendVertices);
             void resizeIndices(int32_t appendIndices);
+            void packVertices();
+            void unpackVertices();
+            void setVertex(uint32_t index, vertex const& tvertex);
             
             bool vboToggled;
             bool ownsData;
@@ -109,6 +218,11 @@ namespace vi
             
             vertex *vertices;
             uint16_t *indices;
+            
+            vertexFormat format;
+            void *packedVertices;
+            
+            std::vector<meshVertexArray> vertexArrays;
         };
     }
 }
\ No newline at end of file
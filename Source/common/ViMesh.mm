@@ -7,11 +7,98 @@
 //
 
 #import "ViMesh.h"
+#import "ViShader.h"
 
 namespace vi
 {
     namespace common
     {  
+        uint32_t vertexStride(vertexFormat format);
+        uint32_t vertexStride(vertexFormat format)
+        {
+            switch(format)
+            {
+                case vertexFormatPacked:
+                    return sizeof(packedVertex);
+                    
+                case vertexFormatPackedShort:
+                    return sizeof(packedShortVertex);
+                    
+                default:
+                    break;
+            }
+            
+            return sizeof(vertex);
+        }
+        
+        static inline void packVertex(vertex const& source, vertexFormat format, void *data, uint32_t index)
+        {
+#define ViPackUnorm16(value) (GLushort)(MAX(0.0f, MIN(1.0f, (value))) * 65535.0f + 0.5f)
+#define ViPackUnorm8(value) (GLubyte)(MAX(0.0f, MIN(1.0f, (value))) * 255.0f + 0.5f)
+            
+            if(format == vertexFormatPacked)
+            {
+                packedVertex& packed = ((packedVertex *)data)[index];
+                packed.x = source.x;
+                packed.y = source.y;
+                packed.u = ViPackUnorm16(source.u);
+                packed.v = ViPackUnorm16(source.v);
+                packed.r = ViPackUnorm8(source.r);
+                packed.g = ViPackUnorm8(source.g);
+                packed.b = ViPackUnorm8(source.b);
+                packed.a = ViPackUnorm8(source.a);
+            }
+            else
+            {
+                packedShortVertex& packed = ((packedShortVertex *)data)[index];
+                packed.x = (GLshort)lroundf(source.x);
+                packed.y = (GLshort)lroundf(source.y);
+                packed.u = ViPackUnorm16(source.u);
+                packed.v = ViPackUnorm16(source.v);
+                packed.r = ViPackUnorm8(source.r);
+                packed.g = ViPackUnorm8(source.g);
+                packed.b = ViPackUnorm8(source.b);
+                packed.a = ViPackUnorm8(source.a);
+            }
+            
+#undef ViPackUnorm16
+#undef ViPackUnorm8
+        }
+        
+        vertex unpackVertex(vertexFormat format, const void *data, uint32_t index);
+        vertex unpackVertex(vertexFormat format, const void *data, uint32_t index)
+        {
+            vertex result;
+            
+            if(format == vertexFormatPacked)
+            {
+                const packedVertex& packed = ((const packedVertex *)data)[index];
+                result.x = packed.x;
+                result.y = packed.y;
+                result.u = packed.u / 65535.0f;
+                result.v = packed.v / 65535.0f;
+                result.r = packed.r / 255.0f;
+                result.g = packed.g / 255.0f;
+                result.b = packed.b / 255.0f;
+                result.a = packed.a / 255.0f;
+            }
+            else
+            {
+                const packedShortVertex& packed = ((const packedShortVertex *)data)[index];
+                result.x = packed.x;
+                result.y = packed.y;
+                result.u = packed.u / 65535.0f;
+                result.v = packed.v / 65535.0f;
+                result.r = packed.r / 255.0f;
+                result.g = packed.g / 255.0f;
+                result.b = packed.b / 255.0f;
+                result.a = packed.a / 255.0f;
+            }
+            
+            return result;
+        }
+        
+        
         mesh::mesh(uint32_t tcount, uint32_t indcount)
         {
             vbo  = vbo0  = vbo1  = -1;
@@ -20,6 +107,11 @@ namespace vi
             vboToggled  = false;
             dynamic     = false;
             ownsData    = true;
+            revision    = 0;
+            dirty       = true;
+            
+            format         = vertexFormatFloat;
+            packedVertices = NULL;
             
             vertexCount = 0;
 			indexCount  = 0;
@@ -39,6 +131,11 @@ namespace vi
             vboToggled  = false;
             dynamic     = false;
             ownsData    = false;
+            revision    = 0;
+            dirty       = true;
+            
+            format         = vertexFormatFloat;
+            packedVertices = NULL;
             
             vertexCount = vertexCapacity = tcount;
 			indexCount = indexCapacity = indcount;
@@ -55,6 +152,9 @@ namespace vi
             if(indices && ownsData)
                 free(indices);
             
+            if(packedVertices)
+                free(packedVertices);
+            
             if(vbo0 != -1)
                 glDeleteBuffers(1, &vbo0);
             if(ivbo0 != -1)
@@ -64,6 +164,14 @@ namespace vi
                 glDeleteBuffers(1, &vbo1);
             if(ivbo1 != -1)
                 glDeleteBuffers(1, &ivbo1);
+            
+#ifdef ViVertexArrayObjects
+            std::vector<meshVertexArray>::iterator iterator;
+            for(iterator=vertexArrays.begin(); iterator!=vertexArrays.end(); iterator++)
+            {
+                glDeleteVertexArrays(1, &(*iterator).vao);
+            }
+#endif
         }
         
         
@@ -76,6 +184,18 @@ namespace vi
             if(vertexCapacity > vertexCount + appendVertices)
                 return;
             
+            if(!vertices)
+            {
+                void *tpacked = realloc(packedVertices, (vertexCount + appendVertices) * vertexStride(format));
+                if(tpacked)
+                {
+                    packedVertices = tpacked;
+                    vertexCapacity = vertexCount + appendVertices;
+                }
+                
+                return;
+            }
+            
             vertex *tvertices = (vertex *)realloc(vertices, (vertexCount + appendVertices) * sizeof(vertex));
             if(tvertices)
             {
@@ -123,11 +243,14 @@ namespace vi
             
             vboToggled = false;
             
+            const void *data = getVertexData();
+            uint32_t stride  = getVertexStride();
+            
             if(!dynamic)
             {
                 glGenBuffers(1, &vbo0);
                 glBindBuffer(GL_ARRAY_BUFFER, vbo0);
-                glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(vertex), vertices, GL_STATIC_DRAW);
+                glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, data, GL_STATIC_DRAW);
                 glBindBuffer(GL_ARRAY_BUFFER, 0);
                 
                 glGenBuffers(1, &ivbo0);
@@ -139,7 +262,7 @@ namespace vi
             {
                 glGenBuffers(1, &vbo0);
                 glBindBuffer(GL_ARRAY_BUFFER, vbo0);
-                glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(vertex), vertices, GL_DYNAMIC_DRAW);
+                glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, data, GL_DYNAMIC_DRAW);
                 glBindBuffer(GL_ARRAY_BUFFER, 0);
                 
                 glGenBuffers(1, &ivbo0);
@@ -149,7 +272,7 @@ namespace vi
                 
                 glGenBuffers(1, &vbo1);
                 glBindBuffer(GL_ARRAY_BUFFER, vbo1);
-                glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(vertex), vertices, GL_DYNAMIC_DRAW);
+                glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, data, GL_DYNAMIC_DRAW);
                 glBindBuffer(GL_ARRAY_BUFFER, 0);
                 
                 glGenBuffers(1, &ivbo1);
@@ -161,6 +284,7 @@ namespace vi
             vbo = vbo0;
             ivbo = ivbo0;
             
+            revision ++;
             dirty = true;
         }
         
@@ -181,7 +305,7 @@ namespace vi
                 ivbo = ivbo1;
                 
                 glBindBuffer(GL_ARRAY_BUFFER, vbo0);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(vertex), vertices);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * getVertexStride(), getVertexData());
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
                 
                 glBindBuffer(GL_ARRAY_BUFFER, ivbo0);
@@ -194,7 +318,7 @@ namespace vi
                 ivbo = ivbo0;
                 
                 glBindBuffer(GL_ARRAY_BUFFER, vbo1);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(vertex), vertices);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * getVertexStride(), getVertexData());
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
                 
                 glBindBuffer(GL_ARRAY_BUFFER, ivbo1);
@@ -206,22 +330,183 @@ namespace vi
         
         vertex *mesh::getVertices()
         {
+            unpackVertices();
             return vertices;
         }
         
+        vertex mesh::getVertex(uint32_t index) const
+        {
+            if(vertices)
+                return vertices[index];
+            
+            return unpackVertex(format, packedVertices, index);
+        }
+        
         uint16_t *mesh::getIndices()
         {
             return indices;
         }
         
+        const uint16_t *mesh::getIndices() const
+        {
+            return indices;
+        }
+        
+        
+        void mesh::setVertexFormat(vertexFormat tformat)
+        {
+            if(format == tformat)
+                return;
+            
+            // The vertices are converted through floats, so packed vertices of the old format never stay around next to the new ones
+            unpackVertices();
+            
+            if(packedVertices)
+            {
+                free(packedVertices);
+                packedVertices = NULL;
+            }
+            
+            format = tformat;
+            dirty  = true;
+            
+            packVertices();
+            
+            if(vbo0 != -1)
+                generateVBO(dynamic);
+        }
+        
+        vertexFormat mesh::getVertexFormat()
+        {
+            return format;
+        }
+        
+        uint32_t mesh::getVertexStride()
+        {
+            return vertexStride(format);
+        }
+        
+        const void *mesh::getVertexData()
+        {
+            if(format == vertexFormatFloat)
+                return vertices;
+            
+            packVertices();
+            return packedVertices;
+        }
+        
+        void mesh::packVertices()
+        {
+            // Meshes own either float vertices or packed vertices. Meshes that don't own their vertices can't drop them and keep a packed copy instead
+            if(format == vertexFormatFloat || !vertices || (!ownsData && packedVertices))
+                return;
+            
+            void *tpacked = malloc(MAX(vertexCapacity, 1) * vertexStride(format));
+            if(!tpacked)
+                return;
+            
+            for(uint32_t i=0; i<vertexCount; i++)
+                packVertex(vertices[i], format, tpacked, i);
+            
+            packedVertices = tpacked;
+            
+            if(ownsData)
+            {
+                free(vertices);
+                vertices = NULL;
+            }
+        }
+        
+        void mesh::unpackVertices()
+        {
+            if(vertices)
+                return;
+            
+            vertex *tvertices = (vertex *)malloc(MAX(vertexCapacity, 1) * sizeof(vertex));
+            assert(tvertices);
+            
+            for(uint32_t i=0; i<vertexCount; i++)
+                tvertices[i] = unpackVertex(format, packedVertices, i);
+            
+            free(packedVertices);
+            
+            vertices = tvertices;
+            packedVertices = NULL;
+        }
+        
+        void mesh::setVertex(uint32_t index, vertex const& tvertex)
+        {
+            if(vertices)
+            {
+                vertices[index] = tvertex;
+                return;
+            }
+            
+            packVertex(tvertex, format, packedVertices, index);
+        }
+        
+                meshVertexArray *mesh::vertexArrayForShader(vi::graphic::shader *shader, vi::common::context *context)
+        {
+            // Dynamic meshes toggle between two pairs of buffers, so each pair gets its own vertex array object
+            meshVertexArray *outdated = NULL;
+            
+            std::vector<meshVertexArray>::iterator iterator;
+            for(iterator=vertexArrays.begin(); iterator!=vertexArrays.end(); iterator++)
+            {
+                if((*iterator).program != shader->program || (*iterator).generation != shader->generation || (*iterator).context != context)
+                    continue;
+                
+                if((*iterator).revision != revision)
+                {
+                    if(!outdated)
+                        outdated = &(*iterator);
+                    
+                    continue;
+                }
+                
+                if((*iterator).vbo == vbo && (*iterator).ivbo == ivbo)
+                    return &(*iterator);
+            }
+            
+            // Vertex array objects of buffers that were deleted by generateVBO() are reused and respecified by the renderer
+            if(outdated)
+                return outdated;
+            
+            meshVertexArray vertexArray;
+            vertexArray.program    = shader->program;
+            vertexArray.generation = shader->generation;
+            vertexArray.context    = context;
+            vertexArray.vao     = -1;
+            vertexArray.vbo     = -1;
+            vertexArray.ivbo    = -1;
+            vertexArray.revision = 0;
+            
+#ifdef ViVertexArrayObjects
+            glGenVertexArrays(1, &vertexArray.vao);
+#endif
+            
+            vertexArrays.push_back(vertexArray);
+            return &vertexArrays.back();
+        }
+        
         
         
         void mesh::translate(vi::common::vector2 const& offset)
         {
             for(uint32_t i=0; i<vertexCount; i++)
             {
-                vertices[i].x += offset.x;
-                vertices[i].y += offset.y;
+                vertex tvertex = getVertex(i);
+                tvertex.x += offset.x;
+                tvertex.y += offset.y;
+                
+                setVertex(i, tvertex);
+            }
+            
+            // The packed copy of vertices that aren't owned by the mesh is outdated now
+            if(!ownsData && packedVertices)
+            {
+                free(packedVertices);
+                packedVertices = NULL;
             }
             
             dirty = true;
@@ -231,8 +516,17 @@ namespace vi
         {
             for(uint32_t i=0; i<vertexCount; i++)
             {
-                vertices[i].x *= scale.x;
-                vertices[i].y *= scale.y;
+                vertex tvertex = getVertex(i);
+                tvertex.x *= scale.x;
+                tvertex.y *= scale.y;
+                
+                setVertex(i, tvertex);
+            }
+            
+            if(!ownsData && packedVertices)
+            {
+                free(packedVertices);
+                packedVertices = NULL;
             }
             
             dirty = true;
@@ -246,20 +540,23 @@ namespace vi
             
             resizeVertices(1);
             
-            vertices[vertexCount].x = x;
-            vertices[vertexCount].y = y;
-            vertices[vertexCount].u = u;
-            vertices[vertexCount].v = v;
-            vertices[vertexCount].r = 1.0;
-            vertices[vertexCount].g = 1.0;
-            vertices[vertexCount].b = 1.0;
-            vertices[vertexCount].a = 1.0;
+            vertex tvertex;
+            tvertex.x = x;
+            tvertex.y = y;
+            tvertex.u = u;
+            tvertex.v = v;
+            tvertex.r = 1.0;
+            tvertex.g = 1.0;
+            tvertex.b = 1.0;
+            tvertex.a = 1.0;
+            
+            setVertex(vertexCount, tvertex);
             
             vertexCount ++;
             dirty = true;
         }
         
-        void mesh::addIndex(uint16_t index)
+                void mesh::addIndex(uint16_t index)
         {
             if(!ownsData)
                 return;
@@ -278,12 +575,14 @@ namespace vi
         {
             if(!ownsData || index >= vertexCount)
                 return;
-
-            vertices[index].x = x;
-            vertices[index].y = y;
-            vertices[index].u = u;
-            vertices[index].v = v;
             
+            vertex tvertex = getVertex(index);
+            tvertex.x = x;
+            tvertex.y = y;
+            tvertex.u = u;
+            tvertex.v = v;
+            
+            setVertex(index, tvertex);
             dirty = true;
         }
         
@@ -292,15 +591,17 @@ namespace vi
             if(!ownsData || index >= vertexCount)
                 return;
             
-            vertices[index].r = color.r;
-            vertices[index].g = color.g;
-            vertices[index].b = color.b;
-            vertices[index].a = color.a;
+            vertex tvertex = getVertex(index);
+            tvertex.r = color.r;
+            tvertex.g = color.g;
+            tvertex.b = color.b;
+            tvertex.a = color.a;
             
+            setVertex(index, tvertex);
             dirty = true;
         }
         
-        void mesh::updateIndex(uint32_t index, uint16_t newIndex)
+                void mesh::updateIndex(uint32_t index, uint16_t newIndex)
         {
             if(!ownsData || index >= indexCount)
                 return;
@@ -323,15 +624,71 @@ namespace vi
                 indexCount ++;
             }
             
+            // Packed batches of meshes with the same format copy the packed vertices and only move their position
+            if(!vertices && appendMesh->format == format)
+            {
+                const void *source = appendMesh->getVertexData();
+                
+                if(format == vertexFormatPacked)
+                {
+                    const packedVertex *tsource = (const packedVertex *)source;
+                    packedVertex *target = (packedVertex *)packedVertices + vertexCount;
+                    
+                    for(uint32_t i=0; i<appendMesh->vertexCount; i++)
+                    {
+                        target[i] = tsource[i];
+                        target[i].x = target[i].x * scale.x + translation.x;
+                        target[i].y = target[i].y * scale.y + translation.y;
+                    }
+                }
+                else
+                {
+                    const packedShortVertex *tsource = (const packedShortVertex *)source;
+                    packedShortVertex *target = (packedShortVertex *)packedVertices + vertexCount;
+                    
+                    for(uint32_t i=0; i<appendMesh->vertexCount; i++)
+                    {
+                        target[i] = tsource[i];
+                        target[i].x = (GLshort)lroundf(target[i].x * scale.x + translation.x);
+                        target[i].y = (GLshort)lroundf(target[i].y * scale.y + translation.y);
+                    }
+                }
+                
+                vertexCount += appendMesh->vertexCount;
+                dirty = true;
+                
+                return;
+            }
+            
+            // Float meshes are packed while they are appended, which writes half the bytes of a float batch
+            if(!vertices && appendMesh->vertices)
+            {
+                for(uint32_t i=0; i<appendMesh->vertexCount; i++)
+                {
+                    vertex tvertex = appendMesh->vertices[i];
+                    
+                    tvertex.x = tvertex.x * scale.x + translation.x;
+                    tvertex.y = tvertex.y * scale.y + translation.y;
+                    
+                    packVertex(tvertex, format, packedVertices, vertexCount + i);
+                }
+                
+                vertexCount += appendMesh->vertexCount;
+                dirty = true;
+                
+                return;
+            }
+            
             for(uint32_t i=0; i<appendMesh->vertexCount; i++)
             {
-                vertices[vertexCount] = appendMesh->vertices[i];
+                vertex tvertex = appendMesh->getVertex(i);
                 
-                vertices[vertexCount].x *= scale.x;
-                vertices[vertexCount].y *= scale.y;
-                vertices[vertexCount].x += translation.x;
-                vertices[vertexCount].y += translation.y;
+                tvertex.x *= scale.x;
+                tvertex.y *= scale.y;
+                tvertex.x += translation.x;
+                tvertex.y += translation.y;
                 
+                setVertex(vertexCount, tvertex);
                 vertexCount ++;
             }            
             
@@ -21,7 +21,8 @@ namespace vi
         /**
          * A quadtree manages a number of scene nodes. A quadtree has a fixed size and subdivision count, so be sure to create one that really
          * fits the bounds of your scene. A scene node that is inserted out of a quadtrees bound won't be added unless the node has parent node with a
-         * larger frame.
+         * larger frame. Nodes are placed by the bounds of their whole subtree, including rotation and scale, so a node without size still ends up where its childs are.
+         * @sa vi::scene::sceneNode::getSubtreeBounds()
          **/
         class quadtree
         {
@@ -46,6 +47,10 @@ namespace vi
              * Returns the frame of the node.
              **/ 
             vi::common::rect getFrame();
+            /**
+             * Returns one of the four subnodes in clockwise order, 0 is the upper left one, or NULL if the node isn't subdivided.
+             **/
+            quadtree *getSubnode(uint32_t index);
             
             /**
              * Adds the objects of the quadtree that are inside the rect to the vector.
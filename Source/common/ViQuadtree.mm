@@ -26,6 +26,21 @@ namespace vi
             return nodeA->layer < nodeB->layer;
         }
         
+        vi::common::rect objectBounds(vi::scene::sceneNode *node);
+        vi::common::rect objectBounds(vi::scene::sceneNode *node)
+        {
+            vi::common::rect bounds = node->getSubtreeBounds();
+            if(bounds.size.length() > kViEpsilonFloat)
+                return bounds;
+            
+            // The subtree can't be bounded, fall back to the node on its own
+            bounds = node->getBounds();
+            if(bounds.size.length() > kViEpsilonFloat)
+                return bounds;
+            
+            return vi::common::rect(node->getPosition(), node->getSize());
+        }
+        
         quadtree::quadtree(vi::common::rect const& rect, uint32_t subdivision)
         {
             frame = rect;
@@ -76,6 +91,11 @@ namespace vi
             return frame;
         }
         
+        quadtree *quadtree::getSubnode(uint32_t index)
+        {
+            return (index < 4) ? subnodes[index] : NULL;
+        }
+        
         
         void quadtree::_objectsInRect(vi::common::rect const& rect, std::vector<vi::scene::sceneNode *> *vector)
         {
@@ -139,7 +159,7 @@ namespace vi
             }
             
             
-            vi::common::rect quad = vi::common::rect(object->getPosition(), object->getSize());
+            vi::common::rect quad = objectBounds(object);
             if(!frame.containsRect(quad))
             {
                 if(parent)
@@ -185,7 +205,7 @@ namespace vi
             }
             
             
-            vi::common::rect quad = vi::common::rect(object->getPosition(), object->getSize());
+            vi::common::rect quad = objectBounds(object);
             if(!frame.containsRect(quad))
             {
                 if(parent)
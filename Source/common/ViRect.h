@@ -46,6 +46,10 @@ namespace vi
              * Returns true if the rect contains the other rect.
              **/
             bool containsRect(vi::common::rect const& otherRect);
+            /**
+             * Returns the smallest rect that contains the rect and the other rect.
+             **/
+            vi::common::rect unionRect(vi::common::rect const& otherRect);
             
             /**
              * Returns the position of the left side of the rect
@@ -90,6 +90,16 @@ namespace vi
             return (containsPoint(otherRect.origin) && containsPoint(point));
         }
         
+        vi::common::rect rect::unionRect(vi::common::rect const& otherRect)
+        {
+            float x1 = MIN(left(), otherRect.left());
+            float y1 = MIN(top(), otherRect.top());
+            float x2 = MAX(right(), otherRect.right());
+            float y2 = MAX(bottom(), otherRect.bottom());
+            
+            return vi::common::rect(x1, y1, x2 - x1, y2 - y1);
+        }
+        
         
 
         float rect::left() const
@@ -0,0 +1,147 @@
+//
+//  ViUploadQueue.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <tr1/functional>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <deque>
+#import "ViBase.h"
+#import "ViContext.h"
+#import "ViTexture.h"
+#import "ViTexturePVR.h"
+#import "ViMesh.h"
+
+namespace vi
+{
+    namespace common
+    {
+        /**
+         * @brief A job that is executed by a vi::common::uploadQueue
+         *
+         * Every task passes through three stages. decode() does the CPU work on a worker thread, upload() issues the OpenGL commands on the upload thread
+         * and publish() hands the result over once the GPU finished the upload.
+         **/
+        class uploadTask
+        {
+        public:
+            /**
+             * Destructor
+             **/
+            virtual ~uploadTask();
+
+            /**
+             * Invoked on a worker thread without an OpenGL context. The default implementation does nothing.
+             **/
+            virtual void decode();
+            /**
+             * Invoked on the upload thread, which has the shared context of the queue active.
+             **/
+            virtual void upload() = 0;
+            /**
+             * Invoked by vi::common::uploadQueue::publish() when the uploaded data is available to the other contexts. The default implementation does nothing.
+             **/
+            virtual void publish();
+        };
+
+        /**
+         * @brief Decodes and uploads assets in the background
+         *
+         * The upload queue owns a number of worker threads that decode images and files, and one upload thread with a context that shares its data with
+         * the context passed to the constructor. Finished uploads are fenced and handed back to the caller by publish(), which checks the fences without
+         * blocking. New textures and meshes therefore become available without stalling the rendering, and without the caller having to manage contexts.
+         * @remark Fences are used on OpenGL 3.2 Core Profile contexts and on iOS if GL_APPLE_sync is available. Otherwise the upload thread waits for
+         * the GPU with glFinish() before the task can be published.
+         * @sa vi::common::kernel::getUploadQueue()
+         **/
+        class uploadQueue
+        {
+        public:
+            /**
+             * Constructor
+             * @param context The context the uploaded data should be shared with. Must not be NULL!
+             * @param workers The number of worker threads that decode the tasks.
+             **/
+            uploadQueue(vi::common::context *context, uint32_t workers=1);
+            /**
+             * Destructor, stops all threads. Tasks which weren't published yet are deleted without being published.
+             **/
+            ~uploadQueue();
+
+            /**
+             * Adds a task to the queue, the queue takes ownership of the task and deletes it after it was published.
+             **/
+            void addTask(vi::common::uploadTask *task);
+
+            /**
+             * Loads the texture with the given name in the background and invokes the callback with the texture once it is usable.
+             * @remark The callback is invoked from publish() and receives ownership of the texture. If the texture couldn't be loaded, the callback gets NULL.
+             **/
+            void loadTexture(std::string const& name, std::tr1::function<void (vi::graphic::texture *)> callback);
+            /**
+             * Loads the PVR texture with the given name in the background and invokes the callback with the texture once it is usable.
+             * @remark The callback is invoked from publish() and receives ownership of the texture. If the texture couldn't be loaded, the callback gets NULL.
+             **/
+            void loadTexturePVR(std::string const& name, std::tr1::function<void (vi::graphic::texturePVR *)> callback);
+            /**
+             * Generates the VBOs of the given mesh in the background and invokes the callback once they are usable.
+             * @remark The mesh must neither be altered nor rendered until the callback was invoked.
+             **/
+            void uploadMesh(vi::common::mesh *mesh, bool dynamic, std::tr1::function<void (vi::common::mesh *)> callback);
+
+            /**
+             * Publishes all tasks whose uploads are finished on the GPU. Must be invoked on the thread of the context passed to the constructor.
+             * @remark Automatically invoked by the kernel at the beginning of every frame if the queue was created with vi::common::kernel::getUploadQueue().
+             * @return The number of published tasks.
+             **/
+            uint32_t publish();
+            /**
+             * Returns the number of tasks that were added but not published yet.
+             **/
+            uint32_t getPendingTasks();
+
+        private:
+            /**
+             * @cond
+             **/
+            typedef struct
+            {
+                vi::common::uploadTask *task;
+#ifdef ViSyncObjects
+                GLsync fence;
+#endif
+            } uploadedTask;
+            /**
+             * @endcond
+             **/
+
+            static void *decodeThread(void *queue);
+            static void *uploadThread(void *queue);
+
+            void runDecoder();
+            void runUploader();
+
+            vi::common::context *context;
+            vi::common::context *uploadContext;
+            bool useFences;
+            bool running;
+
+            pthread_mutex_t mutex;
+            pthread_cond_t decodeCondition;
+            pthread_cond_t uploadCondition;
+
+            std::vector<pthread_t> decoders;
+            pthread_t uploader;
+
+            std::deque<vi::common::uploadTask *> decodeTasks;
+            std::deque<vi::common::uploadTask *> uploadTasks;
+            std::vector<uploadedTask> uploadedTasks;
+            uint32_t pendingTasks;
+        };
+    }
+}
@@ -0,0 +1,420 @@
+//
+//  ViUploadQueue.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViUploadQueue.h"
+#import "ViKernel.h"
+
+namespace vi
+{
+    namespace common
+    {
+#ifdef ViSyncObjects
+        static inline GLsync uploadFenceCreate()
+        {
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+            return glFenceSyncAPPLE(GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE, 0);
+#else
+            return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+        }
+
+        static inline bool uploadFenceSignaled(GLsync fence)
+        {
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+            GLenum result = glClientWaitSyncAPPLE(fence, 0, 0);
+            return (result == GL_ALREADY_SIGNALED_APPLE || result == GL_CONDITION_SATISFIED_APPLE);
+#else
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            return (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+#endif
+        }
+
+        static inline void uploadFenceDelete(GLsync fence)
+        {
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+            glDeleteSyncAPPLE(fence);
+#else
+            glDeleteSync(fence);
+#endif
+        }
+#endif
+
+
+
+        uploadTask::~uploadTask()
+        {
+        }
+
+        void uploadTask::decode()
+        {
+        }
+
+        void uploadTask::publish()
+        {
+        }
+
+
+
+        void decodeTexture(std::string const& name, bool keepPixelData, vi::graphic::texture **texture);
+        void decodeTexture(std::string const& name, bool keepPixelData, vi::graphic::texturePVR **texture);
+        
+        void decodeTexture(std::string const& name, bool keepPixelData, vi::graphic::texture **texture)
+        {
+            *texture = new vi::graphic::texture(name, false, keepPixelData);
+        }
+        
+        void decodeTexture(std::string const& name, bool keepPixelData, vi::graphic::texturePVR **texture)
+        {
+            // PVR textures never keep their pixels
+            *texture = new vi::graphic::texturePVR(name, false);
+        }
+        
+        
+        template <class T>
+        class textureUploadTask : public uploadTask
+        {
+        public:
+            textureUploadTask(std::string const& tname, std::tr1::function<void (T *)> tcallback)
+            {
+                name = tname;
+                callback = tcallback;
+                texture  = NULL;
+                
+                // The setting is read on the thread that adds the task, the worker threads only get a copy
+                keepPixelData = vi::graphic::texture::getKeepsPixelData();
+            }
+
+            ~textureUploadTask()
+            {
+                delete texture;
+            }
+
+            void decode()
+            {
+                try
+                {
+                    decodeTexture(name, keepPixelData, &texture);
+                }
+                catch(const char *exception)
+                {
+                    ViLog(@"Couldn't load texture %s, %s", name.c_str(), exception);
+                    texture = NULL;
+                }
+            }
+
+            void upload()
+            {
+                if(texture)
+                    texture->upload();
+            }
+
+            void publish()
+            {
+                T *result = texture;
+                texture = NULL;
+
+                if(callback)
+                    callback(result);
+                else
+                    delete result;
+            }
+
+        private:
+            std::string name;
+            std::tr1::function<void (T *)> callback;
+            T *texture;
+            bool keepPixelData;
+        };
+
+        class meshUploadTask : public uploadTask
+        {
+        public:
+            meshUploadTask(vi::common::mesh *tmesh, bool tdynamic, std::tr1::function<void (vi::common::mesh *)> tcallback)
+            {
+                mesh = tmesh;
+                dynamic  = tdynamic;
+                callback = tcallback;
+            }
+
+            void upload()
+            {
+                mesh->generateVBO(dynamic);
+            }
+
+            void publish()
+            {
+                if(callback)
+                    callback(mesh);
+            }
+
+        private:
+            vi::common::mesh *mesh;
+            bool dynamic;
+            std::tr1::function<void (vi::common::mesh *)> callback;
+        };
+
+
+
+        uploadQueue::uploadQueue(vi::common::context *tcontext, uint32_t workers)
+        {
+            assert(tcontext);
+
+            context = tcontext;
+            uploadContext = new vi::common::context(context);
+            running = true;
+            pendingTasks = 0;
+
+#ifdef ViSyncObjects
+#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+            useFences = (context->getGLSLVersion() >= 150);
+#endif
+#ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
+            useFences = vi::common::kernel::checkOpenGLExtension("GL_APPLE_sync");
+#endif
+#else
+            useFences = false;
+#endif
+
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&decodeCondition, NULL);
+            pthread_cond_init(&uploadCondition, NULL);
+
+            for(uint32_t i=0; i<MAX(workers, 1); i++)
+            {
+                pthread_t thread;
+                pthread_create(&thread, NULL, &uploadQueue::decodeThread, this);
+
+                decoders.push_back(thread);
+            }
+
+            pthread_create(&uploader, NULL, &uploadQueue::uploadThread, this);
+        }
+
+        uploadQueue::~uploadQueue()
+        {
+            pthread_mutex_lock(&mutex);
+            running = false;
+
+            pthread_cond_broadcast(&decodeCondition);
+            pthread_cond_broadcast(&uploadCondition);
+            pthread_mutex_unlock(&mutex);
+
+            std::vector<pthread_t>::iterator thread;
+            for(thread=decoders.begin(); thread!=decoders.end(); thread++)
+                pthread_join(*thread, NULL);
+
+            pthread_join(uploader, NULL);
+
+
+            // Get rid of everything that didn't make it through the queue
+            std::deque<vi::common::uploadTask *>::iterator iterator;
+            for(iterator=decodeTasks.begin(); iterator!=decodeTasks.end(); iterator++)
+                delete *iterator;
+
+            for(iterator=uploadTasks.begin(); iterator!=uploadTasks.end(); iterator++)
+                delete *iterator;
+
+            std::vector<uploadedTask>::iterator uploaded;
+            for(uploaded=uploadedTasks.begin(); uploaded!=uploadedTasks.end(); uploaded++)
+            {
+#ifdef ViSyncObjects
+                if(uploaded->fence)
+                    uploadFenceDelete(uploaded->fence);
+#endif
+                delete uploaded->task;
+            }
+
+            pthread_cond_destroy(&decodeCondition);
+            pthread_cond_destroy(&uploadCondition);
+            pthread_mutex_destroy(&mutex);
+
+            delete uploadContext;
+        }
+
+
+
+        void uploadQueue::addTask(vi::common::uploadTask *task)
+        {
+            pthread_mutex_lock(&mutex);
+
+            decodeTasks.push_back(task);
+            pendingTasks ++;
+
+            pthread_cond_signal(&decodeCondition);
+            pthread_mutex_unlock(&mutex);
+        }
+
+        void uploadQueue::loadTexture(std::string const& name, std::tr1::function<void (vi::graphic::texture *)> callback)
+        {
+            addTask(new textureUploadTask<vi::graphic::texture>(name, callback));
+        }
+
+        void uploadQueue::loadTexturePVR(std::string const& name, std::tr1::function<void (vi::graphic::texturePVR *)> callback)
+        {
+            addTask(new textureUploadTask<vi::graphic::texturePVR>(name, callback));
+        }
+
+        void uploadQueue::uploadMesh(vi::common::mesh *mesh, bool dynamic, std::tr1::function<void (vi::common::mesh *)> callback)
+        {
+            addTask(new meshUploadTask(mesh, dynamic, callback));
+        }
+
+
+
+        uint32_t uploadQueue::publish()
+        {
+            std::vector<vi::common::uploadTask *> finished;
+
+            pthread_mutex_lock(&mutex);
+
+            // The upload thread signals the fences in order, so the first pending fence ends the search
+            std::vector<uploadedTask>::iterator iterator;
+            for(iterator=uploadedTasks.begin(); iterator!=uploadedTasks.end(); iterator++)
+            {
+#ifdef ViSyncObjects
+                if(iterator->fence)
+                {
+                    if(!uploadFenceSignaled(iterator->fence))
+                        break;
+
+                    uploadFenceDelete(iterator->fence);
+                }
+#endif
+
+                finished.push_back(iterator->task);
+            }
+
+            uploadedTasks.erase(uploadedTasks.begin(), iterator);
+            pthread_mutex_unlock(&mutex);
+
+
+            // The tasks are published without holding the lock, so that callbacks can add new tasks
+            std::vector<vi::common::uploadTask *>::iterator task;
+            for(task=finished.begin(); task!=finished.end(); task++)
+            {
+                (*task)->publish();
+                delete *task;
+            }
+
+            pthread_mutex_lock(&mutex);
+            pendingTasks -= (uint32_t)finished.size();
+            pthread_mutex_unlock(&mutex);
+
+            return (uint32_t)finished.size();
+        }
+
+        uint32_t uploadQueue::getPendingTasks()
+        {
+            pthread_mutex_lock(&mutex);
+            uint32_t count = pendingTasks;
+            pthread_mutex_unlock(&mutex);
+
+            return count;
+        }
+
+
+
+        void *uploadQueue::decodeThread(void *queue)
+        {
+            ((uploadQueue *)queue)->runDecoder();
+            return NULL;
+        }
+
+        void *uploadQueue::uploadThread(void *queue)
+        {
+            ((uploadQueue *)queue)->runUploader();
+            return NULL;
+        }
+
+        void uploadQueue::runDecoder()
+        {
+            while(1)
+            {
+                pthread_mutex_lock(&mutex);
+
+                while(running && decodeTasks.empty())
+                    pthread_cond_wait(&decodeCondition, &mutex);
+
+                if(!running)
+                {
+                    pthread_mutex_unlock(&mutex);
+                    break;
+                }
+
+                vi::common::uploadTask *task = decodeTasks.front();
+                decodeTasks.pop_front();
+
+                pthread_mutex_unlock(&mutex);
+
+
+                @autoreleasepool
+                {
+                    task->decode();
+                }
+
+
+                pthread_mutex_lock(&mutex);
+
+                uploadTasks.push_back(task);
+
+                pthread_cond_signal(&uploadCondition);
+                pthread_mutex_unlock(&mutex);
+            }
+        }
+
+        void uploadQueue::runUploader()
+        {
+            uploadContext->activateContext();
+
+            while(1)
+            {
+                pthread_mutex_lock(&mutex);
+
+                while(running && uploadTasks.empty())
+                    pthread_cond_wait(&uploadCondition, &mutex);
+
+                if(!running)
+                {
+                    pthread_mutex_unlock(&mutex);
+                    break;
+                }
+
+                vi::common::uploadTask *task = uploadTasks.front();
+                uploadTasks.pop_front();
+
+                pthread_mutex_unlock(&mutex);
+
+
+                uploadedTask uploaded;
+                uploaded.task = task;
+
+                @autoreleasepool
+                {
+                    task->upload();
+                }
+
+#ifdef ViSyncObjects
+                uploaded.fence = useFences ? uploadFenceCreate() : NULL;
+#endif
+
+                // The fence must reach the GPU before other contexts can wait for it, without fences the upload thread waits for the GPU itself
+                if(useFences)
+                    glFlush();
+                else
+                    glFinish();
+
+
+                pthread_mutex_lock(&mutex);
+                uploadedTasks.push_back(uploaded);
+                pthread_mutex_unlock(&mutex);
+            }
+
+            uploadContext->deactivateContext();
+        }
+    }
+}
@@ -0,0 +1,42 @@
+//
+//  ViAlphaHull.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#import "ViBase.h"
+#import "ViVector2.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief Generates tight polygons around the visible pixels of images
+         *
+         * Sprites with large transparent areas still blend every pixel of their quad. An alpha hull is a convex polygon with a small number of vertices
+         * that contains every pixel above an alpha threshold, drawing it instead of the quad skips most of the transparent pixels.
+         * @sa vi::graphic::textureRegion::hull
+         **/
+        class alphaHull
+        {
+        public:
+            /**
+             * Generates the hull of the given RGBA pixels.
+             * @param pixels The RGBA pixels, the first row is the top of the image.
+             * @param width The width of the image in pixels
+             * @param height The height of the image in pixels
+             * @param rowLength The number of pixels per row in pixels, used to generate the hull of a part of a larger image.
+             * @param hull Receives the vertices of the hull normalized to the size of the image, with y pointing down and ordered so that the polygon
+             * can be triangulated as a fan.
+             * @param maxVertices The maximum number of vertices, must be at least 3. More vertices result in a tighter hull but also in more triangles.
+             * @param maxCoverage The hull is only generated if it covers less than this fraction of the image.
+             * @return True if a hull was generated, false if the image is completely transparent or the hull wouldn't save enough pixels.
+             **/
+            static bool generate(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t rowLength, std::vector<vi::common::vector2>& hull, uint32_t maxVertices=8, float maxCoverage=0.8f);
+        };
+    }
+}
@@ -0,0 +1,183 @@
+//
+//  ViAlphaHull.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <algorithm>
+#import "ViAlphaHull.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        static inline float hullCross(vi::common::vector2 const& origin, vi::common::vector2 const& a, vi::common::vector2 const& b)
+        {
+            return (a.x - origin.x) * (b.y - origin.y) - (a.y - origin.y) * (b.x - origin.x);
+        }
+
+        static inline bool hullCompare(vi::common::vector2 const& a, vi::common::vector2 const& b)
+        {
+            return (a.x < b.x || (a.x == b.x && a.y < b.y));
+        }
+
+        static float hullArea(std::vector<vi::common::vector2> const& polygon)
+        {
+            float area = 0.0f;
+            for(size_t i=0; i<polygon.size(); i++)
+            {
+                vi::common::vector2 const& a = polygon[i];
+                vi::common::vector2 const& b = polygon[(i + 1) % polygon.size()];
+
+                area += a.x * b.y - b.x * a.y;
+            }
+
+            return area * 0.5f;
+        }
+
+
+
+        bool alphaHull::generate(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t rowLength, std::vector<vi::common::vector2>& hull, uint32_t maxVertices, float maxCoverage)
+        {
+            hull.clear();
+
+            if(!pixels || width == 0 || height == 0)
+                return false;
+
+            maxVertices = MAX(maxVertices, 3);
+
+
+            // Collect the corners of the visible span of every row, grown by one pixel to account for bilinear filtering
+            std::vector<vi::common::vector2> points;
+
+            for(uint32_t y=0; y<height; y++)
+            {
+                const uint8_t *row = pixels + (size_t)y * rowLength * 4;
+                int32_t first = -1;
+                int32_t last  = -1;
+
+                for(uint32_t x=0; x<width; x++)
+                {
+                    if(row[x * 4 + 3] > 0)
+                    {
+                        if(first == -1)
+                            first = x;
+
+                        last = x;
+                    }
+                }
+
+                if(first == -1)
+                    continue;
+
+                float left   = (float)MAX(first - 1, 0);
+                float right  = (float)MIN(last + 2, (int32_t)width);
+                float top    = (float)MAX((int32_t)y - 1, 0);
+                float bottom = (float)MIN(y + 2, height);
+
+                points.push_back(vi::common::vector2(left, top));
+                points.push_back(vi::common::vector2(right, top));
+                points.push_back(vi::common::vector2(left, bottom));
+                points.push_back(vi::common::vector2(right, bottom));
+            }
+
+            if(points.size() == 0)
+                return false;
+
+
+            // Convex hull using the monotone chain algorithm, the result has a positive area
+            std::sort(points.begin(), points.end(), hullCompare);
+
+            std::vector<vi::common::vector2> polygon(points.size() * 2);
+            size_t count = 0;
+
+            for(size_t i=0; i<points.size(); i++)
+            {
+                while(count >= 2 && hullCross(polygon[count - 2], polygon[count - 1], points[i]) <= 0.0f)
+                    count --;
+
+                polygon[count ++] = points[i];
+            }
+
+            for(size_t i=points.size() - 1, lower=count + 1; i>0; i--)
+            {
+                while(count >= lower && hullCross(polygon[count - 2], polygon[count - 1], points[i - 1]) <= 0.0f)
+                    count --;
+
+                polygon[count ++] = points[i - 1];
+            }
+
+            polygon.resize(count - 1);
+
+
+            // Reduce the number of vertices by replacing an edge with the intersection of its neighbouring edges. This only ever grows the
+            // polygon, so it still contains every visible pixel, and the edge which adds the least area is removed first.
+            while(polygon.size() > maxVertices)
+            {
+                size_t size = polygon.size();
+                size_t best = size;
+                float bestArea = 0.0f;
+                vi::common::vector2 bestPoint;
+
+                for(size_t i=0; i<size; i++)
+                {
+                    vi::common::vector2 const& p = polygon[(i + size - 1) % size];
+                    vi::common::vector2 const& a = polygon[i];
+                    vi::common::vector2 const& b = polygon[(i + 1) % size];
+                    vi::common::vector2 const& n = polygon[(i + 2) % size];
+
+                    float dx1 = a.x - p.x;
+                    float dy1 = a.y - p.y;
+                    float dx2 = b.x - n.x;
+                    float dy2 = b.y - n.y;
+
+                    float denominator = dx1 * dy2 - dy1 * dx2;
+                    if(fabsf(denominator) <= kViEpsilonFloat)
+                        continue;
+
+                    float t = ((n.x - p.x) * dy2 - (n.y - p.y) * dx2) / denominator;
+                    float s = ((n.x - p.x) * dy1 - (n.y - p.y) * dx1) / denominator;
+
+                    // The intersection must lie beyond both ends of the removed edge
+                    if(t <= 1.0f || s <= 1.0f)
+                        continue;
+
+                    vi::common::vector2 point(p.x + dx1 * t, p.y + dy1 * t);
+                    if(point.x < 0.0f || point.y < 0.0f || point.x > width || point.y > height)
+                        continue;
+
+                    float area = fabsf(hullCross(point, a, b)) * 0.5f;
+                    if(best == size || area < bestArea)
+                    {
+                        best = i;
+                        bestArea  = area;
+                        bestPoint = point;
+                    }
+                }
+
+                if(best == size)
+                    break;
+
+                polygon[best] = bestPoint;
+                polygon.erase(polygon.begin() + (best + 1) % size);
+            }
+
+            if(polygon.size() < 3 || polygon.size() > maxVertices)
+                return false;
+
+            if(hullArea(polygon) >= maxCoverage * width * height)
+                return false;
+
+
+            std::vector<vi::common::vector2>::iterator iterator;
+            for(iterator=polygon.begin(); iterator!=polygon.end(); iterator++)
+            {
+                hull.push_back(vi::common::vector2(iterator->x / width, iterator->y / height));
+            }
+
+            return true;
+        }
+    }
+}
@@ -0,0 +1,235 @@
+//
+//  ViCommandRenderer.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <string>
+#import "ViBase.h"
+#import "ViRenderer.h"
+#import "ViRenderCommand.h"
+#import "ViRenderTarget.h"
+#import "ViScene.h"
+#import "ViCamera.h"
+#import "ViMesh.h"
+#import "ViVector3.h"
+#import "ViColor.h"
+#import "ViRenderTrace.h"
+#import "ViDebugDraw.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            vi::graphic::renderTarget *target;
+            vi::graphic::material *material;
+            vi::common::mesh *mesh;
+            
+            std::vector<std::pair<vi::graphic::texture *, uint32_t> > textures;
+            vi::common::vector2 size;
+            uint32_t revision;
+            uint32_t lastUsed;
+            bool valid;
+        } nodeCache;
+        
+        typedef struct
+        {
+            vi::graphic::renderTarget *target;
+            vi::graphic::material *material;
+            vi::common::mesh *mesh;
+            
+            vi::common::rect frame;
+            vi::common::vector2 position;
+            vi::common::vector2 translation;
+            vi::common::vector2 size;
+            
+            uint32_t revision;
+            uint32_t lastUsed;
+            bool valid;
+        } staticLayerCache;
+        
+        typedef struct
+        {
+            uint32_t signature;
+            vi::common::rect bounds;
+            bool dirty;
+        } drawRecord;
+        
+        typedef struct
+        {
+            std::vector<drawRecord> records;
+            vi::common::vector2 size;
+            vi::common::color clearColor;
+            uint32_t lastUsed;
+        } partialRedrawState;
+        
+        typedef struct
+        {
+            vi::graphic::renderTarget *target;
+            vi::graphic::material *material;
+            vi::common::mesh *mesh;
+            
+            vi::common::vector2 size;
+            uint32_t lastUsed;
+        } scaledFrameCache;
+        /**
+         * @endcond
+         **/
+        
+        /**
+         * @brief Renderer base class that separates the scene traversal from the graphics API
+         *
+         * The command renderer traverses the scene (culling, visiting the nodes and concatenating sprite batches) and records everything that has to be
+         * drawn into a vi::graphic::renderCommandList. The list is then handed to executeCommandList(), which is the only thing a backend has to implement.
+         **/
+        class commandRenderer : public renderer
+        {
+            friend class renderTrace;
+        public:
+            /**
+             * Constructor
+             **/
+            commandRenderer();
+            /**
+             * Destructor, releases the cached textures of UI nodes.
+             **/
+            virtual ~commandRenderer();
+
+            /**
+             * Generates the command list for the scene and camera and executes it. If the camera renders on demand, the scene isn't traversed as long
+             * as nothing was flagged as changed, and the execution is skipped if the command list has the same signature as the last executed one.
+             **/
+            virtual void renderSceneWithCamera(vi::scene::scene *scene, vi::scene::camera *camera, double timestep);
+
+            /**
+             * Returns the command list that was generated for the last rendered camera.
+             * @remark The list is reused for every camera, the commands are only valid until the next call to renderSceneWithCamera().
+             **/
+            vi::graphic::renderCommandList *getCommandList();
+            
+            /**
+             * Finishes the current frame, and writes the trace to disk if a capture was running and captured all its frames.
+             **/
+            virtual void finishFrame();
+            
+            /**
+             * Records the command lists of the next frames into a vi::graphic::renderTrace, which is written to the given path once all frames
+             * were captured. Only lists that are actually executed are recorded, cameras that are skipped because nothing changed aren't part of the trace.
+             * @param path The path of the trace file.
+             * @param frames The number of frames to capture.
+             * @remark Recording copies every mesh that is drawn and compares it to the already recorded ones, so captured frames are slower than usual.
+             **/
+            void captureTrace(std::string const& path, uint32_t frames=1);
+            /**
+             * Returns true while a trace is captured.
+             **/
+            bool isCapturingTrace();
+            
+            /**
+             * If true, the scene nodes of cameras rendering into a view are drawn with a depth buffer. Opaque draws are executed front to back with
+             * depth writes, so that the pixels they cover aren't shaded again by the draws behind them, and the remaining draws follow in their original order.
+             * The depth of a draw is derived from its position in the draw order, which is sorted by layer, so the result looks the same as without depth sorting.
+             * @remark UI nodes and cameras rendering into textures are always drawn without depth buffer. The view needs a depth buffer, which ViViewOSX and
+             * ViViewiOS only create if their usesDepthBuffer property is YES, otherwise the camera is drawn without depth sorting.
+             * @sa vi::graphic::material::isOpaque()
+             * @default false
+             **/
+            bool depthSorting;
+            /**
+             * The margin in points around the camera that is drawn into the cached texture of nodes with the vi::scene::sceneNodeFlagStaticLayer flag.
+             * The texture is redrawn when the camera moves further than the margin, so a larger margin means fewer redraws but more pixels per redraw.
+             * @default 128
+             **/
+            float staticLayerMargin;
+            /**
+             * If true, cameras rendering into a view only redraw the parts of the view that changed since the last frame. The renderer compares the draws
+             * of the frame with the draws of the last frame and unites the bounds of all draws that appeared, disappeared or changed. Only this region is
+             * cleared and redrawn with the scissor test over the preserved back buffer, and the view isn't redrawn at all if nothing changed.
+             * @remark Requires a view that preserves its back buffer, otherwise the view is only skipped if nothing changed. Frames that render into
+             * textures, eg. cached UI nodes or static layers, and frames in which the size or clear color of the camera changed are always fully redrawn.
+             * @remark Draws are compared by their mesh, material, uniforms and the content revision of their textures. Textures that are changed outside
+             * of Vinter must be marked with vi::graphic::texture::setNeedsContentUpdate().
+             * @sa partialRedrawThreshold
+             * @default false
+             **/
+            bool partialRedraw;
+            /**
+             * The fraction of the view that may be dirty before the renderer falls back to redraw the whole view.
+             * @default 0.5
+             **/
+            float partialRedrawThreshold;
+
+        protected:
+            /**
+             * Generates the commands for the given scene and camera into the given list.
+             * @remark The camera is updated but not bound.
+             **/
+            void generateCommandList(vi::graphic::renderCommandList *list, vi::scene::scene *scene, vi::scene::camera *camera, double timestep);
+            /**
+             * Must be implemented by subclasses to execute the commands. The camera isn't bound when this function is invoked and must be unbound before leaving it.
+             **/
+            virtual void executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera) = 0;
+            
+            /**
+             * If not NULL, backends should wait for every draw command to finish and append the time it took in seconds. Set by
+             * vi::graphic::renderTrace::replay() to measure the draws of a trace.
+             **/
+            std::vector<double> *drawTimes;
+
+        private:
+            void renderNodeList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes);
+            void renderBatchList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes, vi::scene::sceneNode *parent);
+            void visitNode(vi::scene::sceneNode *node, double timestep);
+            bool isCulled(vi::common::rect bounds, bool uiNodes);
+            void renderChilds(vi::scene::sceneNode *node, double timestep, bool uiNodes);
+            void renderCachedNode(vi::scene::sceneNode *node, double timestep);
+            void renderStaticLayer(vi::scene::sceneNode *node, double timestep);
+            void renderFrozenNode(vi::scene::sceneNode *node, bool uiNodes);
+            void renderDebugDraw(vi::graphic::debugDraw *debug);
+            void renderNode(vi::scene::sceneNode *node, bool isUINode);
+            void renderMesh(vi::common::mesh *mesh, bool isUIMesh, vi::common::matrix4x4 const& matrix);
+            void setMaterial(vi::graphic::material *material);
+            bool hasChangesForCamera(vi::scene::scene *scene, vi::scene::camera *camera);
+            bool preparePartialRedraw(vi::scene::camera *camera);
+            scaledFrameCache& scaledFrameForCamera(vi::scene::camera *camera);
+
+            vi::graphic::renderCommandList commands;
+            vi::graphic::renderCommandList *currentList;
+
+            vi::scene::camera *currentCamera;
+            vi::graphic::material *currentMaterial;
+            vi::common::vector3 translation;
+            
+            vi::common::matrix4x4 projectionMatrix;
+            vi::common::matrix4x4 viewMatrix;
+            vi::common::matrix4x4 uiMatrix;
+            vi::common::rect uiFrame;
+            vi::common::rect cullFrame;
+            
+            bool depthPass;
+            uint32_t depthIndex;
+            bool hasContext;
+            
+            std::map<vi::scene::sceneNode *, nodeCache> nodeCaches;
+            std::map<std::pair<vi::scene::sceneNode *, vi::scene::camera *>, staticLayerCache> staticLayerCaches;
+            std::map<vi::scene::camera *, partialRedrawState> partialRedrawStates;
+            std::map<vi::scene::camera *, scaledFrameCache> scaledFrames;
+            std::vector<drawRecord> drawRecords;
+            uint32_t generation;
+            
+            vi::graphic::renderTrace *trace;
+            std::string tracePath;
+            uint32_t traceFrames;
+        };
+    }
+}
@@ -0,0 +1,1119 @@
+//
+//  ViCommandRenderer.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import <Foundation/Foundation.h>
+#import "ViCommandRenderer.h"
+#import "ViQuadtree.h"
+#import "ViSceneNode.h"
+#import "ViVector3.h"
+#import "ViKernel.h"
+#import "ViContext.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        float rendererScaleFactor();
+        float rendererScaleFactor()
+        {
+            // The null and software backends may run without a kernel
+            vi::common::kernel *kernel = vi::common::kernel::sharedKernel();
+            return kernel ? kernel->scaleFactor : 1.0f;
+        }
+        
+        
+        commandRenderer::commandRenderer()
+        {
+            currentList     = NULL;
+            currentCamera   = NULL;
+            currentMaterial = NULL;
+            generation      = 0;
+            
+            depthSorting = false;
+            depthPass    = false;
+            depthIndex   = 0;
+            hasContext   = false;
+            
+            staticLayerMargin = 128.0f;
+            
+            partialRedraw = false;
+            partialRedrawThreshold = 0.5f;
+            
+            drawTimes   = NULL;
+            trace       = NULL;
+            traceFrames = 0;
+        }
+        
+        commandRenderer::~commandRenderer()
+        {
+            std::map<vi::scene::sceneNode *, nodeCache>::iterator iterator;
+            for(iterator=nodeCaches.begin(); iterator!=nodeCaches.end(); iterator++)
+            {
+                nodeCache& cache = iterator->second;
+                
+                vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                delete cache.material;
+                delete cache.mesh;
+            }
+            
+            std::map<std::pair<vi::scene::sceneNode *, vi::scene::camera *>, staticLayerCache>::iterator layerIterator;
+            for(layerIterator=staticLayerCaches.begin(); layerIterator!=staticLayerCaches.end(); layerIterator++)
+            {
+                staticLayerCache& cache = layerIterator->second;
+                
+                vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                delete cache.material;
+                delete cache.mesh;
+            }
+            
+            std::map<vi::scene::camera *, scaledFrameCache>::iterator frameIterator;
+            for(frameIterator=scaledFrames.begin(); frameIterator!=scaledFrames.end(); frameIterator++)
+            {
+                scaledFrameCache& cache = frameIterator->second;
+                
+                vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                delete cache.material;
+                delete cache.mesh;
+            }
+            
+            // The caches were the only users of most of the pooled render targets, keeping them around would just hold on to their memory
+            if(vi::common::context::getActiveContext())
+                vi::graphic::renderTarget::purgeUnusedRenderTargets();
+            
+            delete trace;
+        }
+
+
+        void commandRenderer::renderSceneWithCamera(vi::scene::scene *scene, vi::scene::camera *camera, double timestep)
+        {
+            if(camera->renderOnDemand && !hasChangesForCamera(scene, camera))
+            {
+                stats.camerasSkipped ++;
+                return;
+            }
+            
+            double timestamp = vi::graphic::frameStats::timestamp();
+            
+            generateCommandList(&commands, scene, camera, timestep);
+            
+            stats.generationTime += vi::graphic::frameStats::timestamp() - timestamp;
+            stats.commands += (uint32_t)commands.commands.size();
+            
+            camera->scissor = false;
+            
+            if(partialRedraw && camera->view)
+            {
+                if(camera->resolutionScale < 1.0f)
+                {
+                    // Scaled frames are always redrawn completely, and the next unscaled frame must not be compared against an outdated frame
+                    partialRedrawStates.erase(camera);
+                }
+                else if(!preparePartialRedraw(camera))
+                {
+                    stats.camerasSkipped ++;
+                    return;
+                }
+            }
+            
+            if(camera->renderOnDemand)
+            {
+                // Something was flagged as changed, but the texture of the camera is still kept if the frame would look the same
+                uint32_t signature = commands.signature();
+                signature ^= (uint32_t)(camera->clearColor.r * 255.0f) | ((uint32_t)(camera->clearColor.g * 255.0f) << 8) | ((uint32_t)(camera->clearColor.b * 255.0f) << 16) | ((uint32_t)(camera->clearColor.a * 255.0f) << 24);
+                
+                if(!camera->needsRender && signature == camera->lastSignature)
+                {
+                    stats.camerasSkipped ++;
+                    return;
+                }
+                
+                camera->lastSignature = signature;
+                camera->needsRender   = false;
+            }
+            
+            if(trace)
+                trace->record(&commands, camera);
+            
+            timestamp = vi::graphic::frameStats::timestamp();
+            
+            executeCommandList(&commands, camera);
+            
+            stats.submissionTime += vi::graphic::frameStats::timestamp() - timestamp;
+            stats.camerasRendered ++;
+            
+            // Views that show the texture of the camera have to redraw it
+            if(camera->getTexture())
+                camera->getTexture()->setNeedsContentUpdate();
+        }
+
+        vi::graphic::renderCommandList *commandRenderer::getCommandList()
+        {
+            return &commands;
+        }
+        
+        void commandRenderer::finishFrame()
+        {
+            if(!trace)
+                return;
+            
+            trace->endFrame();
+            
+            if(trace->getFrameCount() >= traceFrames)
+            {
+                if(trace->save(tracePath))
+                    ViLog(@"Captured %u frames with %u command lists into %s", trace->getFrameCount(), trace->getListCount(), tracePath.c_str());
+                
+                delete trace;
+                trace = NULL;
+            }
+        }
+        
+        void commandRenderer::captureTrace(std::string const& path, uint32_t frames)
+        {
+            delete trace;
+            
+            trace       = new vi::graphic::renderTrace();
+            tracePath   = path;
+            traceFrames = MAX(frames, 1);
+        }
+        
+        bool commandRenderer::isCapturingTrace()
+        {
+            return (trace != NULL);
+        }
+
+
+        void commandRenderer::generateCommandList(vi::graphic::renderCommandList *list, vi::scene::scene *scene, vi::scene::camera *camera, double timestep)
+        {
+            camera->update();
+            list->reset();
+
+            currentList     = list;
+            currentCamera   = camera;
+            currentMaterial = NULL;
+            translation     = vi::common::vector3();
+            
+            // Cached nodes, static layers and scaled frames need render targets, without a context they are drawn directly
+            hasContext = (vi::common::context::getActiveContext() != NULL);
+            
+            projectionMatrix = camera->projectionMatrix;
+            viewMatrix = camera->viewMatrix;
+            cullFrame  = camera->frame;
+            uiMatrix.makeTranslate(vi::common::vector3(0.0, camera->frame.size.y, 0.0));
+            uiFrame = vi::common::rect(vi::common::vector2(), camera->frame.size);
+            
+            generation ++;
+
+            double timestamp = vi::graphic::frameStats::timestamp();
+            std::vector<vi::scene::sceneNode *> *nodes = scene->nodesInRect(camera->frame);
+            stats.cullTime += vi::graphic::frameStats::timestamp() - timestamp;
+            
+            scaledFrameCache *scaledFrame = NULL;
+            if(camera->view && camera->resolutionScale < 1.0f && hasContext)
+            {
+                scaledFrame = &scaledFrameForCamera(camera);
+                list->beginTarget(scaledFrame->target);
+            }
+            
+            size_t first = list->commands.size();
+            
+            depthPass  = (depthSorting && camera->view && !scaledFrame && [camera->view respondsToSelector:@selector(usesDepthBuffer)] && [camera->view usesDepthBuffer]);
+            depthIndex = 0;
+            
+            this->renderNodeList(nodes, timestep, false);
+            
+            if(depthPass)
+            {
+                depthPass = false;
+                
+                // The sorted commands set their own pipeline state, so the UI nodes must not rely on the last material
+                if(list->sortOpaqueFrontToBack(first))
+                    currentMaterial = NULL;
+            }
+            
+            if(scaledFrame)
+            {
+                list->endTarget();
+                
+                // Upscale the scene into the view. The target was cleared to transparent black and is blended over the clear color of the camera,
+                // which gives the same result as drawing the scene directly for premultiplied blending
+                vi::common::matrix4x4 matrix;
+                matrix.makeTranslate(vi::common::vector3(0.0, -camera->frame.size.y, 0.0));
+                
+                setMaterial(scaledFrame->material);
+                renderMesh(scaledFrame->mesh, true, matrix);
+            }
+            
+            // The shapes are in world space and only meant for the window, cameras that render into textures would bake them into the scene
+            vi::common::kernel *kernel = vi::common::kernel::sharedKernel();
+            if(camera->view && hasContext && kernel && kernel->hasDebugDraw())
+                renderDebugDraw(kernel->getDebugDraw());
+            
+            this->renderNodeList(scene->UINodes(), timestep, true);
+
+            currentList = NULL;
+            
+            // Forget about caches of nodes that weren't rendered for a while, they were most likely removed or deleted
+            std::map<vi::scene::sceneNode *, nodeCache>::iterator iterator;
+            for(iterator=nodeCaches.begin(); iterator!=nodeCaches.end();)
+            {
+                nodeCache& cache = iterator->second;
+                if(generation - cache.lastUsed > 120)
+                {
+                    vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                    delete cache.material;
+                    delete cache.mesh;
+                    
+                    nodeCaches.erase(iterator++);
+                    continue;
+                }
+                
+                iterator ++;
+            }
+            
+            std::map<std::pair<vi::scene::sceneNode *, vi::scene::camera *>, staticLayerCache>::iterator layerIterator;
+            for(layerIterator=staticLayerCaches.begin(); layerIterator!=staticLayerCaches.end();)
+            {
+                staticLayerCache& cache = layerIterator->second;
+                if(generation - cache.lastUsed > 120)
+                {
+                    vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                    delete cache.material;
+                    delete cache.mesh;
+                    
+                    staticLayerCaches.erase(layerIterator++);
+                    continue;
+                }
+                
+                layerIterator ++;
+            }
+            
+            std::map<vi::scene::camera *, partialRedrawState>::iterator stateIterator;
+            for(stateIterator=partialRedrawStates.begin(); stateIterator!=partialRedrawStates.end();)
+            {
+                if(generation - stateIterator->second.lastUsed > 120)
+                {
+                    partialRedrawStates.erase(stateIterator++);
+                    continue;
+                }
+                
+                stateIterator ++;
+            }
+            
+            std::map<vi::scene::camera *, scaledFrameCache>::iterator frameIterator;
+            for(frameIterator=scaledFrames.begin(); frameIterator!=scaledFrames.end();)
+            {
+                scaledFrameCache& cache = frameIterator->second;
+                if(generation - cache.lastUsed > 120)
+                {
+                    vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                    delete cache.material;
+                    delete cache.mesh;
+                    
+                    scaledFrames.erase(frameIterator++);
+                    continue;
+                }
+                
+                frameIterator ++;
+            }
+        }
+        
+        scaledFrameCache& commandRenderer::scaledFrameForCamera(vi::scene::camera *camera)
+        {
+            float scaleFactor = rendererScaleFactor() * camera->resolutionScale;
+            vi::common::vector2 size = camera->frame.size;
+            
+            uint32_t width  = MAX((uint32_t)ceilf(size.x * scaleFactor), 1);
+            uint32_t height = MAX((uint32_t)ceilf(size.y * scaleFactor), 1);
+            
+            std::map<vi::scene::camera *, scaledFrameCache>::iterator iterator = scaledFrames.find(camera);
+            if(iterator == scaledFrames.end())
+            {
+                scaledFrameCache cache;
+                cache.target   = NULL;
+                cache.material = NULL;
+                cache.mesh     = NULL;
+                
+                iterator = scaledFrames.insert(std::pair<vi::scene::camera *, scaledFrameCache>(camera, cache)).first;
+            }
+            
+            scaledFrameCache& cache = iterator->second;
+            cache.lastUsed = generation;
+            
+            if(!cache.target || cache.target->getWidth() != width || cache.target->getHeight() != height || cache.size != size)
+            {
+                // The targets come from the pool, so going back and forth between the steps of a resolution controller doesn't allocate new ones
+                vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                delete cache.material;
+                delete cache.mesh;
+                
+                vi::common::context *context = vi::common::context::getActiveContext();
+                
+                cache.target = vi::graphic::renderTarget::acquireRenderTarget(width, height);
+                cache.size   = size;
+                
+                cache.material = new vi::graphic::material(cache.target->getTexture(), context->getShader(vi::graphic::defaultShaderTexture));
+                cache.material->blending = true;
+                cache.material->blendSource = GL_ONE;
+                cache.material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+                
+                cache.mesh = new vi::common::mesh(4, 6);
+                cache.mesh->addVertex(0.0, size.y, 0.0, 1.0);
+                cache.mesh->addVertex(size.x, size.y, 1.0, 1.0);
+                cache.mesh->addVertex(size.x, 0.0, 1.0, 0.0);
+                cache.mesh->addVertex(0.0, 0.0, 0.0, 0.0);
+                
+                cache.mesh->addIndex(0);
+                cache.mesh->addIndex(3);
+                cache.mesh->addIndex(1);
+                cache.mesh->addIndex(2);
+                cache.mesh->addIndex(1);
+                cache.mesh->addIndex(3);
+            }
+            
+            return cache;
+        }
+
+
+        void commandRenderer::renderBatchList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes, vi::scene::sceneNode *parent)
+        {
+            vi::common::vector2 tsize = parent->getSize();
+            vi::graphic::material *material = parent->material;
+            
+            // Texture arrays store the layer in the integer part of the texture coordinates, which the packed formats would clamp
+            bool usesArray = (material && material->textures.size() > 0 && material->textures[0] && material->textures[0]->getTarget() != GL_TEXTURE_2D);
+            vi::common::mesh *batchMesh = currentList->transientMesh(usesArray ? vi::common::vertexFormatFloat : vi::common::vertexFormatPacked);
+
+            std::vector<vi::scene::sceneNode *>::iterator iterator;
+
+            for(iterator=nodes->begin(); iterator!=nodes->end(); iterator++)
+            {
+                vi::scene::sceneNode *node = *iterator;
+
+                if(node->noPass == currentCamera || (node->getFlags() & vi::scene::sceneNodeFlagHidden))
+                    continue;
+
+                if(isCulled(node->getSubtreeBounds(), uiNodes))
+                {
+                    stats.nodesCulled ++;
+                    continue;
+                }
+
+
+                visitNode(node, timestep);
+
+                vi::common::vector2 position = node->getPosition();
+                position.y = -position.y;
+                position.y += tsize.y - node->getSize().y;
+
+                // Only the subtree was tested, a node with childs might still be outside on its own
+                if(node->mesh && (!node->hasChilds() || !isCulled(node->getBounds(), uiNodes)))
+                    batchMesh->addMesh(node->mesh, position);
+
+                renderChilds(node, timestep, uiNodes);
+            }
+
+            setMaterial(material);
+            renderMesh(batchMesh, uiNodes, parent->matrix);
+        }
+
+        void commandRenderer::renderNodeList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes)
+        {
+            std::vector<vi::scene::sceneNode *>::iterator iterator;
+
+            for(iterator=nodes->begin(); iterator!=nodes->end(); iterator++)
+            {
+                vi::scene::sceneNode *node = *iterator;
+
+                if(node->noPass == currentCamera || (node->getFlags() & vi::scene::sceneNodeFlagHidden))
+                    continue;
+
+
+                if(isCulled(node->getSubtreeBounds(), uiNodes))
+                {
+                    stats.nodesCulled ++;
+                    continue;
+                }
+
+#ifndef NDEBUG
+                currentList->pushMarker(node->debugName ? node->debugName->c_str() : "scene node");
+#endif
+
+                if(node->isFrozen())
+                {
+                    renderFrozenNode(node, uiNodes);
+                }
+                else if(uiNodes && hasContext && (node->getFlags() & vi::scene::sceneNodeFlagCacheContent) && node->getSize().length() > kViEpsilonFloat)
+                {
+                    renderCachedNode(node, timestep);
+                }
+                else if(!uiNodes && hasContext && (node->getFlags() & vi::scene::sceneNodeFlagStaticLayer))
+                {
+                    renderStaticLayer(node, timestep);
+                }
+                else
+                {
+                    visitNode(node, timestep);
+                    
+                    // Only the subtree was tested, a node with childs might still be outside on its own
+                    if(!node->hasChilds() || !isCulled(node->getBounds(), uiNodes))
+                    {
+                        this->setMaterial(node->material);
+                        this->renderNode(node, uiNodes);
+                    }
+                    
+                    this->renderChilds(node, timestep, uiNodes);
+                }
+
+#ifndef NDEBUG
+                currentList->popMarker();
+#endif
+            }
+        }
+        
+        void commandRenderer::visitNode(vi::scene::sceneNode *node, double timestep)
+        {
+            double timestamp = vi::graphic::frameStats::timestamp();
+            
+            node->visit(timestep);
+            
+            stats.visitTime += vi::graphic::frameStats::timestamp() - timestamp;
+            stats.nodesVisited ++;
+        }
+        
+        bool commandRenderer::isCulled(vi::common::rect bounds, bool uiNodes)
+        {
+            // Nodes without size can't be culled, neither can subtrees that contain one with a mesh
+            if(bounds.size.length() <= kViEpsilonFloat)
+                return false;
+            
+            // The bounds are relative to the parent, the translation moves them into world or UI space
+            bounds.origin += vi::common::vector2(translation.x, translation.y);
+            return !bounds.intersectsRect(uiNodes ? uiFrame : cullFrame);
+        }
+        
+        void commandRenderer::renderChilds(vi::scene::sceneNode *node, double timestep, bool uiNodes)
+        {
+            if(!node->hasChilds())
+                return;
+            
+            vi::common::vector2 nodePos = node->getPosition();
+            translation += nodePos;
+            
+            if(node->getFlags() & vi::scene::sceneNodeFlagConcatenateChildren)
+            {
+                renderBatchList(node->getChilds(), timestep, uiNodes, node);
+            }
+            else
+            {
+                renderNodeList(node->getChilds(), timestep, uiNodes);
+            }
+            
+            translation -= nodePos;
+        }
+        
+        void commandRenderer::renderCachedNode(vi::scene::sceneNode *node, double timestep)
+        {
+            float scaleFactor = rendererScaleFactor();
+            
+            vi::common::vector2 size   = node->getSize();
+            vi::common::vector2 origin = node->getPosition() + vi::common::vector2(translation.x, translation.y);
+            
+            uint32_t width  = (uint32_t)ceilf(size.x * scaleFactor);
+            uint32_t height = (uint32_t)ceilf(size.y * scaleFactor);
+            
+            std::map<vi::scene::sceneNode *, nodeCache>::iterator iterator = nodeCaches.find(node);
+            if(iterator == nodeCaches.end())
+            {
+                nodeCache cache;
+                cache.target   = NULL;
+                cache.material = NULL;
+                cache.mesh     = NULL;
+                cache.valid    = false;
+                cache.revision = 0;
+                
+                iterator = nodeCaches.insert(std::pair<vi::scene::sceneNode *, nodeCache>(node, cache)).first;
+            }
+            
+            nodeCache& cache = iterator->second;
+            cache.lastUsed = generation;
+            
+            // The size isn't part of the content revision of the node, and the quad is built for it
+            if(!cache.target || cache.size != size || cache.target->getWidth() != width || cache.target->getHeight() != height)
+            {
+                vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                delete cache.material;
+                delete cache.mesh;
+                
+                vi::common::context *context = vi::common::context::getActiveContext();
+                
+                cache.target = vi::graphic::renderTarget::acquireRenderTarget(width, height);
+                cache.size   = size;
+                cache.valid  = false;
+                
+                // The cached content is premultiplied because it was blended onto a transparent texture
+                cache.material = new vi::graphic::material(cache.target->getTexture(), context->getShader(vi::graphic::defaultShaderTexture));
+                cache.material->blending = true;
+                cache.material->blendSource = GL_ONE;
+                cache.material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+                
+                // Framebuffer textures start at the bottom, so unlike the sprite mesh, v grows with y
+                cache.mesh = new vi::common::mesh(4, 6);
+                cache.mesh->addVertex(0.0, size.y, 0.0, 1.0);
+                cache.mesh->addVertex(size.x, size.y, 1.0, 1.0);
+                cache.mesh->addVertex(size.x, 0.0, 1.0, 0.0);
+                cache.mesh->addVertex(0.0, 0.0, 0.0, 0.0);
+                
+                cache.mesh->addIndex(0);
+                cache.mesh->addIndex(3);
+                cache.mesh->addIndex(1);
+                cache.mesh->addIndex(2);
+                cache.mesh->addIndex(1);
+                cache.mesh->addIndex(3);
+            }
+            
+            
+            // The cache only depends on the content of the subtree, so moving, rotating or scaling the node doesn't invalidate it
+            bool valid = (cache.valid && cache.revision == node->getContentRevision());
+            
+            std::vector<std::pair<vi::graphic::texture *, uint32_t> >::iterator texture;
+            for(texture=cache.textures.begin(); valid && texture!=cache.textures.end(); texture++)
+                valid = (texture->first->getContentRevision() == texture->second);
+            
+            if(!valid)
+            {
+                // Render the subtree with a camera that looks exactly at the node
+                vi::common::matrix4x4 tprojectionMatrix = projectionMatrix;
+                vi::common::matrix4x4 tuiMatrix = uiMatrix;
+                vi::common::rect tuiFrame = uiFrame;
+                
+                projectionMatrix.makeProjectionOrtho(0.0, size.x, 0.0, size.y, -1.0, 1.0);
+                uiMatrix.makeTranslate(vi::common::vector3(-origin.x, size.y + origin.y, 0.0));
+                uiFrame = vi::common::rect(origin, size);
+                
+                // Changes made while visiting the subtree are picked up in the next frame
+                cache.revision = node->getContentRevision();
+                
+                size_t first = currentList->commands.size();
+                currentList->beginTarget(cache.target);
+                
+                visitNode(node, timestep);
+                
+                if(node->mesh)
+                {
+                    // The rotation and scale of the node are applied to the cached texture, so they are taken out of the matrix of the node again
+                    vi::common::vector2 scale = node->getScale();
+                    vi::common::vector3 offset = vi::common::vector3(node->getPosition().x, -node->getPosition().y - size.y, 0.0);
+                    
+                    vi::common::matrix4x4 matrix;
+                    matrix.makeTranslate(offset);
+                    matrix.scale(vi::common::vector3(fabsf(scale.x) > kViEpsilonFloat ? 1.0f / scale.x : 1.0f, fabsf(scale.y) > kViEpsilonFloat ? 1.0f / scale.y : 1.0f, 1.0f));
+                    matrix.translate(vi::common::vector3(size.x * 0.5f, size.y * 0.5f, 0.0f));
+                    matrix.rotate(-node->rotation, vi::common::vector3(0.0f, 0.0f, 1.0f));
+                    matrix.translate(vi::common::vector3(-size.x * 0.5f, -size.y * 0.5f, 0.0f));
+                    matrix.translate(vi::common::vector3(-offset.x, -offset.y, 0.0));
+                    matrix *= node->matrix;
+                    
+                    this->setMaterial(node->material);
+                    this->renderMesh(node->mesh, true, matrix);
+                }
+                
+                this->renderChilds(node, timestep, true);
+                
+                currentList->endTarget();
+                
+                // Textures can change without the subtree knowing about it, eg. the texture of another camera
+                cache.textures.clear();
+                for(size_t i=first; i<currentList->commands.size(); i++)
+                {
+                    vi::graphic::renderCommand& command = currentList->commands[i];
+                    if(command.type != vi::graphic::renderCommandTypeBindTextures)
+                        continue;
+                    
+                    std::vector<vi::graphic::texture *>::iterator binding;
+                    for(binding=command.material->textures.begin(); binding!=command.material->textures.end(); binding++)
+                        cache.textures.push_back(std::pair<vi::graphic::texture *, uint32_t>(*binding, (*binding)->getContentRevision()));
+                }
+                
+                cache.valid = true;
+                
+                projectionMatrix = tprojectionMatrix;
+                uiMatrix = tuiMatrix;
+                uiFrame  = tuiFrame;
+            }
+            
+            
+            // Composite the cached texture with the transform of the node, the same way the node itself would be drawn
+            vi::common::vector2 scale = node->getScale();
+            
+            vi::common::matrix4x4 matrix;
+            matrix.makeTranslate(vi::common::vector3(origin.x, -origin.y - size.y, 0.0));
+            
+            if(node->rotation > kViEpsilonFloat || node->rotation < -kViEpsilonFloat)
+            {
+                matrix.translate(vi::common::vector3(size.x * 0.5f, size.y * 0.5f, 0.0f));
+                matrix.rotate(node->rotation, vi::common::vector3(0.0f, 0.0f, 1.0f));
+                matrix.translate(vi::common::vector3(-size.x * 0.5f, -size.y * 0.5f, 0.0f));
+            }
+            
+            matrix.scale(vi::common::vector3(scale.x, scale.y, 1.0));
+            
+            setMaterial(cache.material);
+            
+            if(currentMaterial == cache.material)
+            {
+                currentList->setUniforms(cache.material, projectionMatrix, uiMatrix, matrix);
+                currentList->draw(cache.material, cache.mesh, 0, cache.mesh->indexCount);
+            }
+        }
+
+        bool commandRenderer::hasChangesForCamera(vi::scene::scene *scene, vi::scene::camera *camera)
+        {
+            camera->update();
+            
+            uint32_t sceneRevision   = scene->getContentRevision();
+            uint32_t textureRevision = vi::graphic::texture::getGlobalContentRevision();
+            
+            // Nothing the camera could see was flagged as changed since its last traversal, so the scene doesn't need to be traversed at all
+            if(!camera->needsRender && camera->lastScene == scene && camera->lastSceneRevision == sceneRevision && camera->lastTextureRevision == textureRevision &&
+               camera->lastFrame.origin == camera->frame.origin && camera->lastFrame.size == camera->frame.size && camera->lastClearColor == camera->clearColor)
+                return false;
+            
+            // The revisions are taken before the traversal, changes made while visiting the nodes are picked up in the next frame
+            camera->lastScene = scene;
+            camera->lastSceneRevision   = sceneRevision;
+            camera->lastTextureRevision = textureRevision;
+            camera->lastFrame      = camera->frame;
+            camera->lastClearColor = camera->clearColor;
+            
+            return true;
+        }
+        
+        bool commandRenderer::preparePartialRedraw(vi::scene::camera *camera)
+        {
+            float scaleFactor = rendererScaleFactor();
+            vi::common::vector2 size = camera->frame.size;
+            
+            std::map<vi::scene::camera *, partialRedrawState>::iterator iterator = partialRedrawStates.find(camera);
+            if(iterator == partialRedrawStates.end())
+            {
+                partialRedrawState state;
+                iterator = partialRedrawStates.insert(std::pair<vi::scene::camera *, partialRedrawState>(camera, state)).first;
+                
+                // A new camera might live at the address of a deleted one
+                camera->needsRender = true;
+            }
+            
+            partialRedrawState& state = iterator->second;
+            state.lastUsed = generation;
+            
+            
+            // Record the draws that end up in the view
+            bool fullRedraw = (camera->needsRender || state.size != size || !(state.clearColor == camera->clearColor));
+            uint32_t uniformIndex = 0;
+            
+            drawRecords.clear();
+            
+            std::vector<vi::graphic::renderCommand>::iterator command;
+            for(command=commands.commands.begin(); command!=commands.commands.end(); command++)
+            {
+                switch(command->type)
+                {
+                    case renderCommandTypeSetUniforms:
+                        uniformIndex = command->uniforms;
+                        break;
+                        
+                    case renderCommandTypeDraw:
+                    {
+                        drawRecord record;
+                        record.signature = commands.drawSignature(*command, uniformIndex);
+                        record.bounds    = commands.drawBounds(*command, uniformIndex, size);
+                        record.dirty     = false;
+                        
+                        drawRecords.push_back(record);
+                    }
+                        break;
+                        
+                    case renderCommandTypeBeginTarget:
+                        // The scissor test would also clip the render targets
+                        fullRedraw = true;
+                        break;
+                        
+                    default:
+                        break;
+                }
+            }
+            
+            
+            // Draws with the same signature cover the same pixels, so only draws whose signature isn't in both frames equally often can make the view dirty
+            std::map<uint32_t, int32_t> balance;
+            std::vector<drawRecord>::iterator record;
+            
+            for(record=drawRecords.begin(); record!=drawRecords.end(); record++)
+                balance[record->signature] ++;
+            
+            for(record=state.records.begin(); record!=state.records.end(); record++)
+                balance[record->signature] --;
+            
+            for(int pass=0; pass<2; pass++)
+            {
+                std::vector<drawRecord>& records = (pass == 0) ? drawRecords : state.records;
+                for(record=records.begin(); record!=records.end(); record++)
+                    record->dirty = (balance[record->signature] != 0);
+            }
+            
+            // The draws that are in both frames must also be in the same order, otherwise overlapping draws would be composited differently.
+            // Wherever the two sequences of unchanged draws differ, the draws on both sides are dirty as well
+            std::vector<drawRecord>::iterator current  = drawRecords.begin();
+            std::vector<drawRecord>::iterator previous = state.records.begin();
+            
+            while(true)
+            {
+                while(current != drawRecords.end() && current->dirty)
+                    current ++;
+                
+                while(previous != state.records.end() && previous->dirty)
+                    previous ++;
+                
+                if(current == drawRecords.end() || previous == state.records.end())
+                    break;
+                
+                if(current->signature != previous->signature)
+                {
+                    current->dirty  = true;
+                    previous->dirty = true;
+                }
+                
+                current ++;
+                previous ++;
+            }
+            
+            float left = 0.0f, right = 0.0f, bottom = 0.0f, top = 0.0f;
+            bool dirty = false;
+            
+            for(int pass=0; pass<2; pass++)
+            {
+                std::vector<drawRecord>& records = (pass == 0) ? drawRecords : state.records;
+                for(record=records.begin(); record!=records.end(); record++)
+                {
+                    vi::common::rect& bounds = record->bounds;
+                    if(!record->dirty || bounds.size.x <= 0.0f || bounds.size.y <= 0.0f)
+                        continue;
+                    
+                    left   = dirty ? MIN(left, bounds.left()) : bounds.left();
+                    right  = dirty ? MAX(right, bounds.right()) : bounds.right();
+                    bottom = dirty ? MIN(bottom, bounds.origin.y) : bounds.origin.y;
+                    top    = dirty ? MAX(top, bounds.origin.y + bounds.size.y) : bounds.origin.y + bounds.size.y;
+                    
+                    dirty = true;
+                }
+            }
+            
+            state.records.swap(drawRecords);
+            state.size = size;
+            state.clearColor = camera->clearColor;
+            
+            if(fullRedraw)
+            {
+                camera->needsRender = false;
+                return true;
+            }
+            
+            if(!dirty)
+                return false;
+            
+            
+            // Without a preserved back buffer, the rest of the view would contain garbage
+            id<ViViewProtocol> view = camera->view;
+            if(![view respondsToSelector:@selector(preservesBackbuffer)] || ![view preservesBackbuffer])
+                return true;
+            
+            // Grow the region by a point to account for filtering and snap it to whole pixels
+            GLint width  = (GLint)(size.x * scaleFactor);
+            GLint height = (GLint)(size.y * scaleFactor);
+            
+            GLint x0 = MAX((GLint)floorf((left - 1.0f) * scaleFactor), 0);
+            GLint y0 = MAX((GLint)floorf((bottom - 1.0f) * scaleFactor), 0);
+            GLint x1 = MIN((GLint)ceilf((right + 1.0f) * scaleFactor), width);
+            GLint y1 = MIN((GLint)ceilf((top + 1.0f) * scaleFactor), height);
+            
+            if(x1 <= x0 || y1 <= y0)
+                return false;
+            
+            if((float)(x1 - x0) * (float)(y1 - y0) > partialRedrawThreshold * (float)width * (float)height)
+                return true;
+            
+            camera->scissor = true;
+            camera->scissorRect[0] = x0;
+            camera->scissorRect[1] = y0;
+            camera->scissorRect[2] = x1 - x0;
+            camera->scissorRect[3] = y1 - y0;
+            
+            
+            // Drop the draws that are completely outside of the region, together with their uniforms
+            vi::common::rect region = vi::common::rect(x0 / scaleFactor, y0 / scaleFactor, (x1 - x0) / scaleFactor, (y1 - y0) / scaleFactor);
+            std::vector<vi::graphic::renderCommand>::iterator kept = commands.commands.begin();
+            size_t drawIndex = 0;
+            
+            for(command=commands.commands.begin(); command!=commands.commands.end(); command++)
+            {
+                if(command->type == renderCommandTypeDraw)
+                {
+                    vi::common::rect& bounds = state.records[drawIndex ++].bounds;
+                    if(!bounds.intersectsRect(region))
+                    {
+                        if(kept != commands.commands.begin() && (kept - 1)->type == renderCommandTypeSetUniforms)
+                            kept --;
+                        
+                        continue;
+                    }
+                }
+                
+                *kept = *command;
+                kept ++;
+            }
+            
+            commands.commands.erase(kept, commands.commands.end());
+            stats.partialRedraws ++;
+            
+            return true;
+        }
+        
+        void commandRenderer::renderStaticLayer(vi::scene::sceneNode *node, double timestep)
+        {
+            float scaleFactor = rendererScaleFactor();
+            vi::common::rect frame = currentCamera->frame;
+            
+            uint32_t width  = (uint32_t)ceilf((frame.size.x + staticLayerMargin * 2.0f) * scaleFactor);
+            uint32_t height = (uint32_t)ceilf((frame.size.y + staticLayerMargin * 2.0f) * scaleFactor);
+            
+            vi::common::vector2 size = vi::common::vector2(width / scaleFactor, height / scaleFactor);
+            
+            // Every camera sees a different part of the layer, so each of them gets its own cache
+            std::pair<vi::scene::sceneNode *, vi::scene::camera *> key(node, currentCamera);
+            std::map<std::pair<vi::scene::sceneNode *, vi::scene::camera *>, staticLayerCache>::iterator iterator = staticLayerCaches.find(key);
+            if(iterator == staticLayerCaches.end())
+            {
+                staticLayerCache cache;
+                cache.target   = NULL;
+                cache.material = NULL;
+                cache.mesh     = NULL;
+                cache.valid    = false;
+                cache.revision = 0;
+                
+                iterator = staticLayerCaches.insert(std::pair<std::pair<vi::scene::sceneNode *, vi::scene::camera *>, staticLayerCache>(key, cache)).first;
+            }
+            
+            staticLayerCache& cache = iterator->second;
+            cache.lastUsed = generation;
+            
+            if(!cache.target || cache.target->getWidth() != width || cache.target->getHeight() != height)
+            {
+                vi::graphic::renderTarget::releaseRenderTarget(cache.target);
+                delete cache.material;
+                delete cache.mesh;
+                
+                vi::common::context *context = vi::common::context::getActiveContext();
+                
+                cache.target = vi::graphic::renderTarget::acquireRenderTarget(width, height);
+                cache.valid  = false;
+                
+                cache.material = new vi::graphic::material(cache.target->getTexture(), context->getShader(vi::graphic::defaultShaderTexture));
+                cache.material->blending = true;
+                cache.material->blendSource = GL_ONE;
+                cache.material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+                
+                cache.mesh = new vi::common::mesh(4, 6);
+                cache.mesh->addVertex(0.0, size.y, 0.0, 1.0);
+                cache.mesh->addVertex(size.x, size.y, 1.0, 1.0);
+                cache.mesh->addVertex(size.x, 0.0, 1.0, 0.0);
+                cache.mesh->addVertex(0.0, 0.0, 0.0, 0.0);
+                
+                cache.mesh->addIndex(0);
+                cache.mesh->addIndex(3);
+                cache.mesh->addIndex(1);
+                cache.mesh->addIndex(2);
+                cache.mesh->addIndex(1);
+                cache.mesh->addIndex(3);
+            }
+            
+            
+            // The layer is drawn with the translation of its parents, so moving a parent invalidates the cache as well
+            vi::common::vector2 parentTranslation = vi::common::vector2(translation.x, translation.y);
+            
+            if(!cache.valid || !cache.frame.containsRect(frame) || cache.revision != node->getContentRevision() || cache.position != node->getPosition() || cache.translation != parentTranslation || cache.size != node->getSize())
+            {
+                // Center the cached area around the camera, snapped to whole pixels so that the cached texels line up with the ones drawn directly
+                vi::common::vector2 origin = frame.origin - staticLayerMargin;
+                origin.x = floorf(origin.x * scaleFactor) / scaleFactor;
+                origin.y = floorf(origin.y * scaleFactor) / scaleFactor;
+                
+                cache.frame = vi::common::rect(origin, size);
+                
+                vi::common::matrix4x4 tprojectionMatrix = projectionMatrix;
+                vi::common::matrix4x4 tviewMatrix = viewMatrix;
+                vi::common::rect tcullFrame = cullFrame;
+                bool tdepthPass = depthPass;
+                
+                projectionMatrix.makeProjectionOrtho(0.0, size.x, 0.0, size.y, -1.0, 1.0);
+                viewMatrix.makeTranslate(vi::common::vector3(-origin.x, size.y + origin.y, 0.0));
+                cullFrame = cache.frame;
+                depthPass = false;
+                
+                currentList->beginTarget(cache.target);
+                
+                visitNode(node, timestep);
+                
+                this->setMaterial(node->material);
+                this->renderNode(node, false);
+                this->renderChilds(node, timestep, false);
+                
+                currentList->endTarget();
+                
+                projectionMatrix = tprojectionMatrix;
+                viewMatrix = tviewMatrix;
+                cullFrame  = tcullFrame;
+                depthPass  = tdepthPass;
+                
+                cache.revision = node->getContentRevision();
+                cache.position = node->getPosition();
+                cache.translation = parentTranslation;
+                cache.size  = node->getSize();
+                cache.valid = true;
+                
+                stats.staticLayersRedrawn ++;
+            }
+            else
+            {
+                stats.staticLayersReused ++;
+            }
+            
+            
+            // Composite the cached texture, the cached area is in world space so the translation of the parents doesn't apply
+            vi::common::matrix4x4 matrix;
+            matrix.makeTranslate(vi::common::vector3(cache.frame.origin.x, -cache.frame.origin.y - size.y, 0.0));
+            
+            vi::common::vector3 ttranslation = translation;
+            translation = vi::common::vector3();
+            
+            setMaterial(cache.material);
+            renderMesh(cache.mesh, false, matrix);
+            
+            translation = ttranslation;
+        }
+
+        void commandRenderer::renderFrozenNode(vi::scene::sceneNode *node, bool uiNodes)
+        {
+            // The baked meshes are relative to the node and already contain the transforms of the subtree, so nothing is visited
+            vi::common::vector2 position = node->getPosition();
+            
+            vi::common::matrix4x4 matrix;
+            matrix.makeTranslate(vi::common::vector3(position.x, -position.y, 0.0));
+            
+            std::vector<vi::scene::frozenMesh *> *frozenMeshes = node->getFrozenMeshes();
+            std::vector<vi::scene::frozenMesh *>::iterator iterator;
+            
+            for(iterator=frozenMeshes->begin(); iterator!=frozenMeshes->end(); iterator++)
+            {
+                vi::scene::frozenMesh *frozenMesh = *iterator;
+                
+                vi::common::rect bounds = frozenMesh->bounds;
+                bounds.origin += position;
+                
+                if(isCulled(bounds, uiNodes))
+                    continue;
+                
+                setMaterial(frozenMesh->material);
+                renderMesh(frozenMesh->mesh, uiNodes, matrix);
+            }
+        }
+
+        void commandRenderer::renderDebugDraw(vi::graphic::debugDraw *debug)
+        {
+            if(debug->isEmpty())
+                return;
+            
+            // The shapes are in world space and drawn at full resolution above the scene, usually this is a single draw
+            vi::common::matrix4x4 matrix;
+            uint32_t first = 0;
+            
+            do {
+                vi::common::mesh *mesh = currentList->transientMesh();
+                first = debug->generateMesh(mesh, first);
+                
+                setMaterial(debug->getMaterial());
+                renderMesh(mesh, false, matrix);
+            } while(first > 0);
+        }
+
+        void commandRenderer::renderNode(vi::scene::sceneNode *node, bool isUINode)
+        {
+            if(!node->mesh)
+                return;
+
+            renderMesh(node->mesh, isUINode, node->matrix);
+        }
+
+        void commandRenderer::renderMesh(vi::common::mesh *mesh, bool isUIMesh, vi::common::matrix4x4 const& matrix)
+        {
+            if(!currentMaterial || mesh->indexCount == 0)
+                return;
+
+            vi::common::matrix4x4 cameraMatrix = !isUIMesh ? viewMatrix : uiMatrix;
+
+            vi::common::matrix4x4 nodeMatrix = matrix;
+            if(translation.length() >= kViEpsilonFloat)
+            {
+                // The translation of the parents is applied in world space, so the rotation and scale of the node don't affect it
+                nodeMatrix.makeTranslate(vi::common::vector3(translation.x, -translation.y, 0.0));
+                nodeMatrix *= matrix;
+            }
+            
+            if(depthPass && !isUIMesh)
+            {
+                // Later draws are moved towards the viewer. The default shaders place vertices at z 1 and the orthographic projection maps -1 to 1
+                // onto the whole depth range, two steps of a 16 bit depth buffer per draw keep neighbouring draws apart
+                uint32_t index = MIN(depthIndex, 32766);
+                nodeMatrix.matrix[14] += -2.0f + (index + 1) / 16384.0f;
+                
+                depthIndex ++;
+            }
+
+            currentList->setUniforms(currentMaterial, projectionMatrix, cameraMatrix, nodeMatrix);
+            currentList->draw(currentMaterial, mesh, 0, mesh->indexCount);
+        }
+
+        void commandRenderer::setMaterial(vi::graphic::material *material)
+        {
+            if(!material)
+                return;
+
+            if(!material->shader)
+            {
+                static bool complaintAboutShader = false;
+                if(!complaintAboutShader)
+                {
+                    ViLog(@"Tried to enable a material in a shader based renderer but the material had no shader! This error will be reported once");
+                    complaintAboutShader = true;
+                }
+
+                return;
+            }
+
+            if(currentMaterial != material)
+            {
+                currentList->setPipeline(material);
+
+                if(!currentMaterial || (currentMaterial->textures != material->textures || currentMaterial->texlocations != material->texlocations))
+                    currentList->bindTextures(material);
+
+                currentMaterial = material;
+            }
+        }
+    }
+}
@@ -0,0 +1,143 @@
+//
+//  ViDebugDraw.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#import "ViBase.h"
+#import "ViVector2.h"
+#import "ViColor.h"
+#import "ViRect.h"
+#import "ViMesh.h"
+#import "ViScene.h"
+
+namespace vi
+{
+    namespace common
+    {
+        class quadtree;
+    }
+
+    namespace graphic
+    {
+        class material;
+
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            vi::common::vector2 position;
+            vi::common::color color;
+        } debugVertex;
+        /**
+         * @endcond
+         **/
+
+        /**
+         * @brief Immediate mode drawing of lines and shapes for debugging
+         *
+         * The debug draw collects lines, rects, circles and polygons in world space for the current frame. Every camera that renders the scene
+         * into a view draws everything that was collected on top of the scene nodes, below the UI nodes, with a single draw call into a streaming mesh. After
+         * the frame, the kernel throws the collected shapes away, so shapes have to be added again every frame.<br />
+         * <br />
+         * Unlike scene nodes, the shapes aren't culled, visited or batched, so they don't distort the numbers of the vi::graphic::frameStats
+         * much. There are also visualizers for the quadtree of a scene, trace results and the shapes of the physical space.
+         * @sa vi::common::kernel::getDebugDraw()
+         **/
+        class debugDraw
+        {
+        public:
+            /**
+             * Constructor
+             **/
+            debugDraw();
+            /**
+             * Destructor
+             **/
+            ~debugDraw();
+
+            /**
+             * Adds a line from the start to the end point.
+             **/
+            void drawLine(vi::common::vector2 const& from, vi::common::vector2 const& to, vi::common::color const& color);
+            /**
+             * Adds the outline of the rect, or the filled rect.
+             **/
+            void drawRect(vi::common::rect const& rect, vi::common::color const& color, bool filled=false);
+            /**
+             * Adds the outline of the circle, or the filled circle.
+             * @sa circleSegments
+             **/
+            void drawCircle(vi::common::vector2 const& center, float radius, vi::common::color const& color, bool filled=false);
+            /**
+             * Adds the closed outline of the polygon, or the filled polygon.
+             * @remark Filled polygons must be convex.
+             **/
+            void drawPolygon(std::vector<vi::common::vector2> const& points, vi::common::color const& color, bool filled=false);
+
+            /**
+             * Adds the frames of all subdivisions of the quadtree.
+             * @sa vi::scene::scene::getQuadtree()
+             **/
+            void drawQuadtree(vi::common::quadtree *quadtree, vi::common::color const& color);
+            /**
+             * Adds the line of a trace, and if something was hit, the bounds of the hit node and a marker at the hit position.
+             * @sa vi::scene::scene::trace()
+             **/
+            void drawTrace(vi::common::vector2 const& from, vi::common::vector2 const& to, vi::scene::hitInfo const& info, vi::common::color const& color);
+            /**
+             * Adds the rect of a trace, and if something was hit, the bounds of the hit node and a marker at the hit position.
+             * @sa vi::scene::scene::trace()
+             **/
+            void drawTrace(vi::common::rect const& rect, vi::scene::hitInfo const& info, vi::common::color const& color);
+#ifdef ViPhysicsChipmunk
+            /**
+             * Adds the outlines of all shapes of the physical space. Circles also get a line that shows the rotation of their body.
+             * @sa vi::scene::scene::getSpace()
+             **/
+            void drawSpace(cpSpace *space, vi::common::color const& color);
+#endif
+
+            /**
+             * Removes all shapes, invoked by the kernel at the end of every frame.
+             **/
+            void clear();
+            /**
+             * Returns true if no shapes were added since the last clear().
+             **/
+            bool isEmpty();
+
+            /**
+             * Fills the mesh with triangles, starting at the given vertex of the collected shapes. The vertices are converted into the y up space of
+             * the renderer.
+             * @return The vertex to continue with if the shapes didn't fit into the 16 bit indices of the mesh, or 0 if all vertices were added.
+             **/
+            uint32_t generateMesh(vi::common::mesh *mesh, uint32_t first=0);
+            /**
+             * Returns the material the meshes are drawn with, which is created on the first call.
+             **/
+            vi::graphic::material *getMaterial();
+
+            /**
+             * The width of lines and outlines in points. The width is applied when a shape is added.
+             * @default 1
+             **/
+            float lineWidth;
+            /**
+             * The number of line segments that make up a circle.
+             * @default 24
+             **/
+            uint32_t circleSegments;
+
+        private:
+            void addTriangle(vi::common::vector2 const& a, vi::common::vector2 const& b, vi::common::vector2 const& c, vi::common::color const& color);
+
+            std::vector<vi::graphic::debugVertex> vertices;
+            vi::graphic::material *material;
+        };
+    }
+}
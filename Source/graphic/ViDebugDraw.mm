@@ -0,0 +1,275 @@
+//
+//  ViDebugDraw.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViDebugDraw.h"
+#import "ViMaterial.h"
+#import "ViContext.h"
+#import "ViQuadtree.h"
+#import "ViSceneNode.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        debugDraw::debugDraw()
+        {
+            lineWidth = 1.0f;
+            circleSegments = 24;
+
+            material = NULL;
+        }
+
+        debugDraw::~debugDraw()
+        {
+            delete material;
+        }
+
+
+
+        void debugDraw::addTriangle(vi::common::vector2 const& a, vi::common::vector2 const& b, vi::common::vector2 const& c, vi::common::color const& color)
+        {
+            vi::graphic::debugVertex vertex;
+            vertex.color = color;
+
+            vertex.position = a;
+            vertices.push_back(vertex);
+
+            vertex.position = b;
+            vertices.push_back(vertex);
+
+            vertex.position = c;
+            vertices.push_back(vertex);
+        }
+
+        void debugDraw::drawLine(vi::common::vector2 const& from, vi::common::vector2 const& to, vi::common::color const& color)
+        {
+            vi::common::vector2 start = from;
+            vi::common::vector2 end   = to;
+
+            vi::common::vector2 direction = end - start;
+            if(direction.length() <= kViEpsilonFloat)
+                return;
+
+            // Lines are quads, so that they can be drawn together with the filled shapes
+            direction.normalize();
+            vi::common::vector2 normal = vi::common::vector2(-direction.y, direction.x) * (lineWidth * 0.5f);
+
+            addTriangle(start - normal, end - normal, end + normal, color);
+            addTriangle(start - normal, end + normal, start + normal, color);
+        }
+
+        void debugDraw::drawRect(vi::common::rect const& rect, vi::common::color const& color, bool filled)
+        {
+            vi::common::vector2 topLeft     = vi::common::vector2(rect.left(), rect.top());
+            vi::common::vector2 topRight    = vi::common::vector2(rect.right(), rect.top());
+            vi::common::vector2 bottomRight = vi::common::vector2(rect.right(), rect.bottom());
+            vi::common::vector2 bottomLeft  = vi::common::vector2(rect.left(), rect.bottom());
+
+            if(filled)
+            {
+                addTriangle(topLeft, topRight, bottomRight, color);
+                addTriangle(topLeft, bottomRight, bottomLeft, color);
+                return;
+            }
+
+            drawLine(topLeft, topRight, color);
+            drawLine(topRight, bottomRight, color);
+            drawLine(bottomRight, bottomLeft, color);
+            drawLine(bottomLeft, topLeft, color);
+        }
+
+        void debugDraw::drawCircle(vi::common::vector2 const& center, float radius, vi::common::color const& color, bool filled)
+        {
+            uint32_t segments = MAX(circleSegments, 3);
+
+            std::vector<vi::common::vector2> points;
+            points.reserve(segments);
+
+            for(uint32_t i=0; i<segments; i++)
+            {
+                float angle = (i / (float)segments) * 2.0f * (float)M_PI;
+                points.push_back(vi::common::vector2(center.x + cosf(angle) * radius, center.y + sinf(angle) * radius));
+            }
+
+            drawPolygon(points, color, filled);
+        }
+
+        void debugDraw::drawPolygon(std::vector<vi::common::vector2> const& points, vi::common::color const& color, bool filled)
+        {
+            if(points.size() < 2)
+                return;
+
+            if(filled)
+            {
+                for(size_t i=2; i<points.size(); i++)
+                    addTriangle(points[0], points[i - 1], points[i], color);
+
+                return;
+            }
+
+            for(size_t i=0; i<points.size(); i++)
+                drawLine(points[i], points[(i + 1) % points.size()], color);
+        }
+
+
+
+        void debugDraw::drawQuadtree(vi::common::quadtree *quadtree, vi::common::color const& color)
+        {
+            if(!quadtree)
+                return;
+
+            drawRect(quadtree->getFrame(), color);
+
+            for(uint32_t i=0; i<4; i++)
+                drawQuadtree(quadtree->getSubnode(i), color);
+        }
+
+        void debugDraw::drawTrace(vi::common::vector2 const& from, vi::common::vector2 const& to, vi::scene::hitInfo const& info, vi::common::color const& color)
+        {
+            if(!info.node)
+            {
+                drawLine(from, to, color);
+                return;
+            }
+
+            // The part behind the hit is drawn faded out
+            vi::common::vector2 position = info.position;
+            vi::common::color faded = color;
+            faded.a *= 0.3f;
+
+            drawLine(from, position, color);
+            drawLine(position, to, faded);
+
+            drawRect(info.node->getBounds(), color);
+            drawRect(vi::common::rect(position - (lineWidth * 2.0f), vi::common::vector2(lineWidth * 4.0f, lineWidth * 4.0f)), color, true);
+        }
+
+        void debugDraw::drawTrace(vi::common::rect const& rect, vi::scene::hitInfo const& info, vi::common::color const& color)
+        {
+            drawRect(rect, color);
+
+            if(info.node)
+            {
+                vi::common::vector2 position = info.position;
+
+                drawRect(info.node->getBounds(), color);
+                drawRect(vi::common::rect(position - (lineWidth * 2.0f), vi::common::vector2(lineWidth * 4.0f, lineWidth * 4.0f)), color, true);
+            }
+        }
+
+#ifdef ViPhysicsChipmunk
+        void debugDrawShape(cpShape *shape, void *data);
+        void debugDrawShape(cpShape *shape, void *data)
+        {
+            std::pair<debugDraw *, vi::common::color *> *context = (std::pair<debugDraw *, vi::common::color *> *)data;
+            debugDraw *draw = context->first;
+            vi::common::color color = *context->second;
+
+            cpBody *body = shape->body;
+
+            switch(shape->CP_PRIVATE(klass)->type)
+            {
+                case CP_CIRCLE_SHAPE:
+                {
+                    cpVect center = cpBodyLocal2World(body, cpCircleShapeGetOffset(shape));
+                    cpFloat radius = cpCircleShapeGetRadius(shape);
+                    cpVect edge = cpvadd(center, cpvmult(cpBodyGetRot(body), radius));
+
+                    draw->drawCircle(vi::common::vector2(center.x, center.y), radius, color);
+                    draw->drawLine(vi::common::vector2(center.x, center.y), vi::common::vector2(edge.x, edge.y), color);
+                    break;
+                }
+
+                case CP_SEGMENT_SHAPE:
+                {
+                    cpVect a = cpBodyLocal2World(body, cpSegmentShapeGetA(shape));
+                    cpVect b = cpBodyLocal2World(body, cpSegmentShapeGetB(shape));
+
+                    draw->drawLine(vi::common::vector2(a.x, a.y), vi::common::vector2(b.x, b.y), color);
+                    break;
+                }
+
+                case CP_POLY_SHAPE:
+                {
+                    std::vector<vi::common::vector2> points;
+                    int count = cpPolyShapeGetNumVerts(shape);
+
+                    for(int i=0; i<count; i++)
+                    {
+                        cpVect vertex = cpBodyLocal2World(body, cpPolyShapeGetVert(shape, i));
+                        points.push_back(vi::common::vector2(vertex.x, vertex.y));
+                    }
+
+                    draw->drawPolygon(points, color);
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        void debugDraw::drawSpace(cpSpace *space, vi::common::color const& color)
+        {
+            if(!space)
+                return;
+
+            vi::common::color tcolor = color;
+            std::pair<debugDraw *, vi::common::color *> context(this, &tcolor);
+
+            cpSpaceEachShape(space, debugDrawShape, &context);
+        }
+#endif
+
+
+
+        void debugDraw::clear()
+        {
+            vertices.clear();
+        }
+
+        bool debugDraw::isEmpty()
+        {
+            return (vertices.size() == 0);
+        }
+
+        uint32_t debugDraw::generateMesh(vi::common::mesh *mesh, uint32_t first)
+        {
+            // Whole triangles only, and the indices of a mesh are 16 bit
+            uint32_t count = MIN((uint32_t)vertices.size() - first, 65535 - (65535 % 3));
+
+            for(uint32_t i=0; i<count; i++)
+            {
+                vi::graphic::debugVertex& vertex = vertices[first + i];
+
+                mesh->addVertex(vertex.position.x, -vertex.position.y, 0.0f, 0.0f);
+                mesh->updateColor(mesh->vertexCount - 1, vertex.color);
+                mesh->addIndex(i);
+            }
+
+            first += count;
+            return (first < vertices.size()) ? first : 0;
+        }
+
+        vi::graphic::material *debugDraw::getMaterial()
+        {
+            if(!material)
+            {
+                vi::common::context *context = vi::common::context::getActiveContext();
+
+                material = new vi::graphic::material(NULL, context->getShader(vi::graphic::defaultShaderColor));
+                material->blending = true;
+                material->blendSource = GL_ONE;
+                material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+                material->culling = false;
+            }
+
+            return material;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+//
+//  ViFont.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <string>
+#include <map>
+#import <Foundation/Foundation.h>
+#import "ViBase.h"
+#import "ViAsset.h"
+#import "ViTexture.h"
+#import "ViMaterial.h"
+#import "ViVector2.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief The metrics of a single character of a font
+         **/
+        typedef struct
+        {
+            /**
+             * The origin of the glyph in the font texture in points
+             **/
+            vi::common::vector2 origin;
+            /**
+             * The size of the glyph in points
+             **/
+            vi::common::vector2 size;
+            /**
+             * The offset from the pen position to the top left corner of the glyph in points
+             **/
+            vi::common::vector2 offset;
+            /**
+             * The number of points the pen advances after the glyph
+             **/
+            float advance;
+        } fontGlyph;
+
+        /**
+         * @brief A bitmap font created from a BMFont file
+         *
+         * A font loads the glyph metrics and kerning pairs from an AngelCode BMFont file in text or XML format ( http://www.angelcode.com/products/bmfont/ ),
+         * together with the glyph texture. All text that is rendered with the font shares the same texture and material, so text nodes using the same
+         * font can be drawn without state changes.
+         * @remark Only fonts with a single texture page are supported.
+         * @sa vi::scene::textNode
+         **/
+        class font : public vi::common::asset
+        {
+        public:
+            /**
+             * Constructor, loads the font and its texture.
+             * @param file The name of the BMFont file, eg. "Arial.fnt"
+             * @sa vi::common::dataPool::pathForFile()
+             **/
+            font(std::string const& file);
+            /**
+             * Destructor, deletes the texture and the material of the font.
+             **/
+            virtual ~font();
+
+            /**
+             * Returns the glyph for the given unicode character, or NULL if the font doesn't contain it.
+             **/
+            const vi::graphic::fontGlyph *getGlyph(uint32_t character);
+            /**
+             * Returns the additional advance in points between the two given characters.
+             **/
+            float getKerning(uint32_t first, uint32_t second);
+
+            /**
+             * Returns the distance between two lines of text in points.
+             **/
+            float getLineHeight();
+            /**
+             * Returns the distance from the top of a line to the base line of the glyphs in points.
+             **/
+            float getBase();
+
+            /**
+             * Returns the texture containing the glyphs.
+             **/
+            vi::graphic::texture *getTexture();
+            /**
+             * Returns the material that is shared by everything that is rendered with the font. The material uses the sprite shader with premultiplied alpha blending.
+             **/
+            vi::graphic::material *getMaterial();
+
+        private:
+            void parseText(const char *bytes, size_t length);
+            void parseXML(NSData *data);
+            void parseEntry(std::string const& tag, std::map<std::string, std::string>& values);
+
+            std::map<uint32_t, vi::graphic::fontGlyph> glyphs;
+            std::map<uint64_t, float> kernings;
+
+            std::string pageFile;
+            uint32_t pageCount;
+            float pageWidth;
+
+            float lineHeight;
+            float base;
+
+            vi::graphic::texture *texture;
+            vi::graphic::material *material;
+
+            GLfloat atlasTranslation[4];
+        };
+    }
+}
@@ -0,0 +1,318 @@
+//
+//  ViFont.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViFont.h"
+#import "ViXML.h"
+#import "ViDataPool.h"
+#import "ViContext.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        static inline float fontValue(std::map<std::string, std::string>& values, const char *key)
+        {
+            return (float)atof(values[key].c_str());
+        }
+
+        static inline uint64_t fontKerningKey(uint32_t first, uint32_t second)
+        {
+            return ((uint64_t)first << 32) | second;
+        }
+
+
+
+        font::font(std::string const& file)
+        {
+            texture  = NULL;
+            material = NULL;
+
+            pageCount  = 0;
+            pageWidth  = 0.0f;
+            lineHeight = 0.0f;
+            base       = 0.0f;
+
+            std::string path = vi::common::dataPool::pathForFile(file);
+            if(path.length() == 0)
+                throw "Couldn't find font file!";
+
+            @autoreleasepool
+            {
+                NSString *nspath = [NSString stringWithUTF8String:path.c_str()];
+                NSData *data = [NSData dataWithContentsOfFile:nspath];
+
+                if(!data || [data length] == 0)
+                    throw "Couldn't read font file!";
+
+                const char *bytes = (const char *)[data bytes];
+                size_t length = [data length];
+                size_t start  = 0;
+
+                while(start < length && isspace(bytes[start]))
+                    start ++;
+
+                if(start < length && bytes[start] == '<')
+                {
+                    parseXML(data);
+                }
+                else
+                {
+                    parseText(bytes, length);
+                }
+
+
+                if(pageCount != 1 || pageFile.length() == 0)
+                    throw "Fonts must have exactly one texture page!";
+
+                // The page is looked up next to the font file first and in the bundles otherwise
+                NSString *pagePath = [[nspath stringByDeletingLastPathComponent] stringByAppendingPathComponent:[NSString stringWithUTF8String:pageFile.c_str()]];
+                if([[NSFileManager defaultManager] fileExistsAtPath:pagePath])
+                {
+                    texture = new vi::graphic::texture(std::string([pagePath UTF8String]));
+                }
+                else
+                {
+                    texture = new vi::graphic::texture(std::string([[pagePath lastPathComponent] UTF8String]));
+                }
+            }
+
+
+            // The metrics are in pixels of the texture page, a @2x texture with a @2x font has twice as many pixels per point
+            float factor = (pageWidth > 0.0f && texture->getWidth() > 0) ? pageWidth / texture->getWidth() : 1.0f;
+
+            lineHeight /= factor;
+            base /= factor;
+
+            std::map<uint32_t, vi::graphic::fontGlyph>::iterator iterator;
+            for(iterator=glyphs.begin(); iterator!=glyphs.end(); iterator++)
+            {
+                vi::graphic::fontGlyph& glyph = iterator->second;
+
+                glyph.origin  = glyph.origin / factor;
+                glyph.size    = glyph.size / factor;
+                glyph.offset  = glyph.offset / factor;
+                glyph.advance = glyph.advance / factor;
+            }
+
+            std::map<uint64_t, float>::iterator kerning;
+            for(kerning=kernings.begin(); kerning!=kernings.end(); kerning++)
+            {
+                kerning->second /= factor;
+            }
+
+
+            vi::common::context *context = vi::common::context::getActiveContext();
+            assert(context);
+
+            atlasTranslation[0] = atlasTranslation[1] = 0.0f;
+            atlasTranslation[2] = atlasTranslation[3] = 1.0f;
+
+            material = new vi::graphic::material(texture, context->getShader(vi::graphic::defaultShaderSprite));
+            material->blending = true;
+            material->blendSource = GL_ONE;
+            material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+            material->addParameter("atlasTranslation", atlasTranslation, vi::graphic::materialParameterTypeFloat, 4, 1);
+        }
+
+        font::~font()
+        {
+            delete material;
+            delete texture;
+        }
+
+
+
+        void font::parseText(const char *bytes, size_t length)
+        {
+            std::string data(bytes, length);
+            size_t lineStart = 0;
+
+            while(lineStart < data.length())
+            {
+                size_t lineEnd = data.find('\n', lineStart);
+                if(lineEnd == std::string::npos)
+                    lineEnd = data.length();
+
+                std::string line = data.substr(lineStart, lineEnd - lineStart);
+                lineStart = lineEnd + 1;
+
+                // Every line is a tag followed by key=value pairs, values with spaces are quoted
+                std::map<std::string, std::string> values;
+                std::string tag;
+                size_t position = 0;
+
+                while(position < line.length())
+                {
+                    while(position < line.length() && isspace(line[position]))
+                        position ++;
+
+                    if(position >= line.length())
+                        break;
+
+                    size_t keyStart = position;
+                    while(position < line.length() && !isspace(line[position]) && line[position] != '=')
+                        position ++;
+
+                    std::string key = line.substr(keyStart, position - keyStart);
+
+                    if(position >= line.length() || line[position] != '=')
+                    {
+                        if(tag.length() == 0)
+                            tag = key;
+
+                        continue;
+                    }
+
+                    position ++;
+
+                    std::string value;
+                    if(position < line.length() && line[position] == '"')
+                    {
+                        size_t valueEnd = line.find('"', position + 1);
+                        if(valueEnd == std::string::npos)
+                            valueEnd = line.length();
+
+                        value = line.substr(position + 1, valueEnd - position - 1);
+                        position = valueEnd + 1;
+                    }
+                    else
+                    {
+                        size_t valueStart = position;
+                        while(position < line.length() && !isspace(line[position]))
+                            position ++;
+
+                        value = line.substr(valueStart, position - valueStart);
+                    }
+
+                    values[key] = value;
+                }
+
+                if(tag.length() > 0)
+                    parseEntry(tag, values);
+            }
+        }
+
+        void font::parseXML(NSData *data)
+        {
+            static const char *commonKeys[]  = { "lineHeight", "base", "scaleW", "scaleH", "pages", NULL };
+            static const char *pageKeys[]    = { "id", "file", NULL };
+            static const char *charKeys[]    = { "id", "x", "y", "width", "height", "xoffset", "yoffset", "xadvance", "page", NULL };
+            static const char *kerningKeys[] = { "first", "second", "amount", NULL };
+
+            vi::common::xmlParser *parser = new vi::common::xmlParser(data);
+            vi::common::xmlElement *root = parser->getRootElement();
+
+            if(!root)
+            {
+                delete parser;
+                throw "Couldn't parse font file!";
+            }
+
+            const char *tags[] = { "common", "pages/page", "chars/char", "kernings/kerning" };
+            const char **keys[] = { commonKeys, pageKeys, charKeys, kerningKeys };
+
+            for(int i=0; i<4; i++)
+            {
+                std::string path = tags[i];
+                size_t separator = path.find('/');
+
+                vi::common::xmlElement *parent = root;
+                std::string name = path;
+
+                if(separator != std::string::npos)
+                {
+                    parent = root->childNamed(path.substr(0, separator));
+                    name = path.substr(separator + 1);
+                }
+
+                vi::common::xmlElement *element = parent ? parent->childNamed(name) : NULL;
+                while(element)
+                {
+                    std::map<std::string, std::string> values;
+                    for(const char **key=keys[i]; *key; key++)
+                        values[*key] = element->valueOfAttributeNamed(*key);
+
+                    parseEntry(name, values);
+                    element = element->siblingNamed(name);
+                }
+            }
+
+            delete parser;
+        }
+
+        void font::parseEntry(std::string const& tag, std::map<std::string, std::string>& values)
+        {
+            if(tag == "common")
+            {
+                lineHeight = fontValue(values, "lineHeight");
+                base       = fontValue(values, "base");
+                pageWidth  = fontValue(values, "scaleW");
+                pageCount  = (uint32_t)atol(values["pages"].c_str());
+            }
+            else if(tag == "page")
+            {
+                if(atol(values["id"].c_str()) == 0)
+                    pageFile = values["file"];
+            }
+            else if(tag == "char")
+            {
+                vi::graphic::fontGlyph glyph;
+                glyph.origin  = vi::common::vector2(fontValue(values, "x"), fontValue(values, "y"));
+                glyph.size    = vi::common::vector2(fontValue(values, "width"), fontValue(values, "height"));
+                glyph.offset  = vi::common::vector2(fontValue(values, "xoffset"), fontValue(values, "yoffset"));
+                glyph.advance = fontValue(values, "xadvance");
+
+                glyphs[(uint32_t)atol(values["id"].c_str())] = glyph;
+            }
+            else if(tag == "kerning")
+            {
+                uint32_t first  = (uint32_t)atol(values["first"].c_str());
+                uint32_t second = (uint32_t)atol(values["second"].c_str());
+
+                kernings[fontKerningKey(first, second)] = fontValue(values, "amount");
+            }
+        }
+
+
+
+        const vi::graphic::fontGlyph *font::getGlyph(uint32_t character)
+        {
+            std::map<uint32_t, vi::graphic::fontGlyph>::iterator iterator = glyphs.find(character);
+            return (iterator != glyphs.end()) ? &iterator->second : NULL;
+        }
+
+        float font::getKerning(uint32_t first, uint32_t second)
+        {
+            if(kernings.empty())
+                return 0.0f;
+
+            std::map<uint64_t, float>::iterator iterator = kernings.find(fontKerningKey(first, second));
+            return (iterator != kernings.end()) ? iterator->second : 0.0f;
+        }
+
+        float font::getLineHeight()
+        {
+            return lineHeight;
+        }
+
+        float font::getBase()
+        {
+            return base;
+        }
+
+        vi::graphic::texture *font::getTexture()
+        {
+            return texture;
+        }
+
+        vi::graphic::material *font::getMaterial()
+        {
+            return material;
+        }
+    }
+}
@@ -0,0 +1,150 @@
+//
+//  ViFrameStats.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViBase.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief Counters and timings of a single frame
+         *
+         * The frame stats are filled by the renderer and the scene while a frame is drawn, the stats of the last complete frame can be read using
+         * vi::common::kernel::getFrameStats(). All times are in seconds.
+         **/
+        class frameStats
+        {
+        public:
+            /**
+             * Constructor, sets everything to zero.
+             **/
+            frameStats();
+            
+            /**
+             * Sets all counters and timings back to zero.
+             **/
+            void reset();
+            
+            /**
+             * Returns a monotonic timestamp in seconds, used to measure the timings.
+             **/
+            static double timestamp();
+            
+            
+            /**
+             * The index of the frame, counted by the kernel
+             **/
+            uint32_t frame;
+            
+            /**
+             * The number of draw calls
+             **/
+            uint32_t drawCalls;
+            /**
+             * The number of times a different shader program was used
+             **/
+            uint32_t programSwitches;
+            /**
+             * The number of textures that were bound
+             **/
+            uint32_t textureBinds;
+            /**
+             * The number of uniform uploads, including the matrices
+             **/
+            uint32_t uniformUploads;
+            /**
+             * The number of vertices referenced by all draws, draws of a range of a mesh only count the vertices of that range
+             **/
+            uint32_t vertices;
+            /**
+             * The number of drawn indices
+             **/
+            uint32_t indices;
+            /**
+             * The number of generated render commands
+             **/
+            uint32_t commands;
+            
+            /**
+             * The number of nodes that were visited
+             **/
+            uint32_t nodesVisited;
+            /**
+             * The number of nodes that were rejected because they were outside of the camera, a rejected subtree counts as a single node
+             **/
+            uint32_t nodesCulled;
+            /**
+             * The number of cameras that rendered
+             **/
+            uint32_t camerasRendered;
+            /**
+             * The number of cameras that rendered on demand, or with partial redraws, and didn't need to render
+             **/
+            uint32_t camerasSkipped;
+            /**
+             * The number of cameras that only redrew the dirty region of their view
+             * @sa vi::graphic::commandRenderer::partialRedraw
+             **/
+            uint32_t partialRedraws;
+            /**
+             * The number of static layers that were drawn into their cached texture
+             **/
+            uint32_t staticLayersRedrawn;
+            /**
+             * The number of static layers that were composited from their cached texture without being redrawn
+             **/
+            uint32_t staticLayersReused;
+            
+            
+            /**
+             * Time spent running the animation server
+             **/
+            double animationTime;
+            /**
+             * Time spent stepping the physical space
+             **/
+            double physicsTime;
+            /**
+             * Time spent querying the quadtree for visible nodes
+             **/
+            double cullTime;
+            /**
+             * Time spent inside of the visit() functions of the nodes
+             **/
+            double visitTime;
+            /**
+             * Time spent traversing the scene and generating the commands, includes the visit time
+             **/
+            double generationTime;
+            /**
+             * Time spent on the CPU to submit the commands to the graphics API
+             **/
+            double submissionTime;
+            /**
+             * Time the GPU spent on all cameras of the frame gpuFrame, only valid if gpuTimeAvailable is true.
+             * @remark GPU times are read back asynchronously, so this is the GPU time of a frame a few frames ago. Only measured by vi::graphic::rendererOSX
+             * on Mac OS X contexts that support EXT_timer_query. There is no GPU timing on OpenGL 3.2 core profile contexts, where the extension can't be
+             * queried and ARB_timer_query with GL_TIME_ELAPSED isn't wired up, and none on iOS.
+             **/
+            double gpuTime;
+            /**
+             * The index of the frame gpuTime was measured in, only valid if gpuTimeAvailable is true.
+             **/
+            uint32_t gpuFrame;
+            /**
+             * True if the result of a timer query became available during this frame and gpuTime contains a valid value
+             **/
+            bool gpuTimeAvailable;
+            /**
+             * Total time of the frame, measured by the kernel
+             **/
+            double frameTime;
+        };
+    }
+}
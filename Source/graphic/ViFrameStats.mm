@@ -0,0 +1,67 @@
+//
+//  ViFrameStats.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <mach/mach_time.h>
+#import "ViFrameStats.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        frameStats::frameStats()
+        {
+            reset();
+        }
+        
+        void frameStats::reset()
+        {
+            frame           = 0;
+            drawCalls       = 0;
+            programSwitches = 0;
+            textureBinds    = 0;
+            uniformUploads  = 0;
+            vertices        = 0;
+            indices         = 0;
+            commands        = 0;
+            
+            nodesVisited    = 0;
+            nodesCulled     = 0;
+            camerasRendered = 0;
+            camerasSkipped  = 0;
+            partialRedraws  = 0;
+            staticLayersRedrawn = 0;
+            staticLayersReused  = 0;
+            
+            animationTime   = 0.0;
+            physicsTime     = 0.0;
+            cullTime        = 0.0;
+            visitTime       = 0.0;
+            generationTime  = 0.0;
+            submissionTime  = 0.0;
+            gpuTime         = 0.0;
+            gpuFrame        = 0;
+            frameTime       = 0.0;
+            
+            gpuTimeAvailable = false;
+        }
+        
+        double frameStats::timestamp()
+        {
+            static double conversion = 0.0;
+            if(conversion <= 0.0)
+            {
+                mach_timebase_info_data_t info;
+                mach_timebase_info(&info);
+                
+                conversion = ((double)info.numer / (double)info.denom) * 1e-9;
+            }
+            
+            return mach_absolute_time() * conversion;
+        }
+    }
+}
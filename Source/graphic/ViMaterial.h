@@ -124,6 +124,13 @@ namespace vi
              * Adds a new vertex attribute
              **/
             bool addAttribute(std::string const& name, void *data, GLenum type, uint32_t size, uint32_t stride);
+            
+            /**
+             * Returns true if everything rendered with the material completely covers what is behind it. This is the case if blending is disabled, or if
+             * the blending only uses the source alpha and none of the textures has an alpha channel.
+             * @remark Vertex colors and shader parameters aren't taken into account, a material with an alpha free texture is opaque even if the mesh is faded out.
+             **/
+            bool isOpaque();
 
             
             /**
@@ -39,6 +39,27 @@ namespace vi
         
         
         
+        bool material::isOpaque()
+        {
+            if(!blending)
+                return true;
+            
+            if(blendDestination != GL_ONE_MINUS_SRC_ALPHA || (blendSource != GL_ONE && blendSource != GL_SRC_ALPHA) || textures.size() == 0)
+                return false;
+            
+            std::vector<vi::graphic::texture *>::iterator iterator;
+            for(iterator=textures.begin(); iterator!=textures.end(); iterator++)
+            {
+                vi::graphic::texture *texture = *iterator;
+                if(!texture || texture->hasAlphaChannel())
+                    return false;
+            }
+            
+            return true;
+        }
+        
+        
+        
         bool material::addParameter(std::string const& name, void *data, materialParameterType type, uint32_t count, uint32_t size)
         {
             if(!shader)
@@ -0,0 +1,182 @@
+//
+//  ViPixelReadback.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <tr1/functional>
+#include <pthread.h>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <string>
+#import "ViBase.h"
+
+#define kViPixelReadbackMaxQueuedImages 8
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief An image that was read back from a camera
+         **/
+        typedef struct
+        {
+            /**
+             * The width of the image in pixels.
+             **/
+            uint32_t width;
+            /**
+             * The height of the image in pixels.
+             **/
+            uint32_t height;
+            /**
+             * The number of the image in its stream, counted from 0. Always 0 for images that were requested with vi::graphic::pixelReadback::request().
+             **/
+            uint32_t index;
+            /**
+             * The time the image was rendered, see vi::graphic::frameStats::timestamp().
+             **/
+            double timestamp;
+            /**
+             * The premultiplied RGBA pixels, with the bottom row first like glReadPixels().
+             **/
+            std::vector<uint8_t> pixels;
+        } readbackImage;
+        
+        /**
+         * Callback that receives a read back image.
+         **/
+        typedef std::tr1::function<void (vi::graphic::readbackImage const&)> readbackCallback;
+        
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            GLuint buffer;
+            size_t size;
+#ifdef ViSyncObjects
+            GLsync fence;
+#endif
+            bool busy;
+            uint32_t frame;
+            
+            uint32_t width, height;
+            uint32_t index;
+            double timestamp;
+            
+            std::vector<vi::graphic::readbackCallback> requests;
+            vi::graphic::readbackCallback stream;
+            vi::graphic::readbackImage *image;
+        } readbackSlot;
+        /**
+         * @endcond
+         **/
+        
+        /**
+         * @brief Reads the pixels of a framebuffer back without stalling the rendering
+         *
+         * A pixel readback copies the bound framebuffer into a ring of pixel pack buffers with glReadPixels(), which returns immediately, and maps
+         * the buffers once the GPU finished the copy, usually one or two frames later. Requests are answered on the render thread, streams
+         * hand their images to a worker thread so that they can be compressed or written to disk without blocking the rendering.
+         * Every camera has a readback, see vi::scene::camera::readPixels() and vi::scene::camera::streamPixels().
+         * @remark Without pixel buffer objects (iOS), the pixels are read synchronously and handed over in the next frame. Fences are used on OpenGL 3.2
+         * Core Profile contexts, otherwise a buffer is mapped when the ring is about to reuse it. Cameras rendered by vi::graphic::rendererSoftware aren't
+         * read back, use vi::graphic::rendererSoftware::getPixels() instead.
+         **/
+        class pixelReadback
+        {
+        public:
+            /**
+             * Constructor
+             * @param buffers The number of pixel pack buffers in the ring, at least 2. More buffers allow the GPU to fall further behind before frames are dropped.
+             **/
+            pixelReadback(uint32_t buffers=3);
+            /**
+             * Destructor, waits for the pending images and delivers them, and stops the worker thread after it handled all queued images.
+             * @remark Requires the context the images were read with to be active.
+             **/
+            ~pixelReadback();
+            
+            /**
+             * Reads back the next captured frame and invokes the callback with it from collect().
+             **/
+            void request(vi::graphic::readbackCallback const& callback);
+            /**
+             * Reads back every captured frame and invokes the callback with them on the worker thread, in the order they were captured.
+             * Replaces a previously set stream callback.
+             * @remark Frames are dropped if all buffers are still in flight or if more than kViPixelReadbackMaxQueuedImages images wait for the worker.
+             **/
+            void stream(vi::graphic::readbackCallback const& callback);
+            /**
+             * Stops the stream, frames that were already captured are still delivered.
+             **/
+            void stopStream();
+            /**
+             * Returns true if a stream is running.
+             **/
+            bool isStreaming();
+            /**
+             * Returns true if the next captured frame is going to be read back.
+             **/
+            bool wantsCapture();
+            /**
+             * Returns true if there are requests that haven't been captured yet, eg. because all buffers were still in flight during the last capture().
+             **/
+            bool hasPendingRequests();
+            /**
+             * Returns the number of frames the stream dropped.
+             **/
+            uint32_t getDroppedFrames();
+            
+            /**
+             * Starts to read the currently bound framebuffer back, if there are requests or a stream.
+             * @param width The width of the framebuffer in pixels.
+             * @param height The height of the framebuffer in pixels.
+             **/
+            void capture(uint32_t width, uint32_t height);
+            /**
+             * Delivers the images whose copies are finished, in the order they were captured.
+             * @param wait If true, all pending images are delivered even if the GPU has to be waited for.
+             **/
+            void collect(bool wait=false);
+            
+            /**
+             * Collects the images of all readbacks, invoked by the kernel at the beginning of every frame.
+             **/
+            static void collectAll();
+            /**
+             * Writes the given image into an uncompressed 32 bit TGA file, which can be done on the worker thread of a stream.
+             * @return False if the file couldn't be written.
+             **/
+            static bool writeTGA(vi::graphic::readbackImage const& image, std::string const& path);
+            
+        private:
+            bool isReady(vi::graphic::readbackSlot& slot);
+            void deliver(vi::graphic::readbackSlot& slot, vi::graphic::readbackImage *image);
+            
+            static void *workerThread(void *readback);
+            void runWorker();
+            
+            std::vector<vi::graphic::readbackSlot> slots;
+            uint32_t nextSlot;
+            bool useFences;
+            
+            std::vector<vi::graphic::readbackCallback> requests;
+            vi::graphic::readbackCallback streamCallback;
+            bool streaming;
+            uint32_t streamIndex;
+            uint32_t droppedFrames;
+            
+            bool workerRunning;
+            pthread_t worker;
+            pthread_mutex_t mutex;
+            pthread_cond_t condition;
+            std::deque<std::pair<vi::graphic::readbackCallback, vi::graphic::readbackImage *> > queue;
+        };
+    }
+}
@@ -0,0 +1,407 @@
+//
+//  ViPixelReadback.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <stdio.h>
+#import "ViPixelReadback.h"
+#import "ViFrameStats.h"
+#import "ViContext.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        static std::vector<vi::graphic::pixelReadback *> readbacks;
+        static uint32_t readbackFrame = 0;
+        
+        pixelReadback::pixelReadback(uint32_t buffers)
+        {
+            readbackSlot slot;
+            slot.buffer = 0;
+            slot.size   = 0;
+#ifdef ViSyncObjects
+            slot.fence  = NULL;
+#endif
+            slot.busy   = false;
+            slot.image  = NULL;
+            
+            slots.resize(MAX(buffers, 2), slot);
+            nextSlot = 0;
+            
+            streaming = false;
+            streamIndex = 0;
+            droppedFrames = 0;
+            workerRunning = false;
+            
+#if defined(ViPixelBufferObjects) && defined(ViSyncObjects)
+            vi::common::context *context = vi::common::context::getActiveContext();
+            useFences = (context && context->getGLSLVersion() >= 150);
+#else
+            useFences = false;
+#endif
+            
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&condition, NULL);
+            
+            readbacks.push_back(this);
+        }
+        
+        pixelReadback::~pixelReadback()
+        {
+            collect(true);
+            
+            std::vector<vi::graphic::pixelReadback *>::iterator iterator;
+            for(iterator=readbacks.begin(); iterator!=readbacks.end(); iterator++)
+            {
+                if(*iterator == this)
+                {
+                    readbacks.erase(iterator);
+                    break;
+                }
+            }
+            
+            if(workerRunning)
+            {
+                pthread_mutex_lock(&mutex);
+                workerRunning = false;
+                
+                pthread_cond_broadcast(&condition);
+                pthread_mutex_unlock(&mutex);
+                
+                pthread_join(worker, NULL);
+            }
+            
+            pthread_cond_destroy(&condition);
+            pthread_mutex_destroy(&mutex);
+            
+#ifdef ViPixelBufferObjects
+            for(uint32_t i=0; i<slots.size(); i++)
+            {
+                if(slots[i].buffer)
+                    glDeleteBuffers(1, &slots[i].buffer);
+            }
+#endif
+        }
+        
+        
+        
+        void pixelReadback::request(vi::graphic::readbackCallback const& callback)
+        {
+            requests.push_back(callback);
+        }
+        
+        void pixelReadback::stream(vi::graphic::readbackCallback const& callback)
+        {
+            streamCallback = callback;
+            streaming = true;
+            
+            if(!workerRunning)
+            {
+                workerRunning = true;
+                pthread_create(&worker, NULL, &pixelReadback::workerThread, this);
+            }
+        }
+        
+        void pixelReadback::stopStream()
+        {
+            streaming = false;
+            streamCallback = vi::graphic::readbackCallback();
+        }
+        
+        bool pixelReadback::isStreaming()
+        {
+            return streaming;
+        }
+        
+        bool pixelReadback::wantsCapture()
+        {
+            return (streaming || requests.size() > 0);
+        }
+        
+        bool pixelReadback::hasPendingRequests()
+        {
+            return (requests.size() > 0);
+        }
+        
+        uint32_t pixelReadback::getDroppedFrames()
+        {
+            return droppedFrames;
+        }
+        
+        
+        
+        void pixelReadback::capture(uint32_t width, uint32_t height)
+        {
+            if(!wantsCapture() || width == 0 || height == 0)
+                return;
+            
+            readbackSlot& slot = slots[nextSlot];
+            if(slot.busy)
+            {
+                collect();
+                
+                if(slot.busy)
+                {
+                    // All buffers are still in flight, skipping the frame is better than waiting for the GPU. Requests are served by the next frame
+                    if(streaming)
+                        droppedFrames ++;
+                    
+                    return;
+                }
+            }
+            
+            if(streaming)
+            {
+                pthread_mutex_lock(&mutex);
+                bool full = (queue.size() >= kViPixelReadbackMaxQueuedImages);
+                pthread_mutex_unlock(&mutex);
+                
+                if(full && requests.size() == 0)
+                {
+                    droppedFrames ++;
+                    return;
+                }
+                
+                slot.stream = full ? vi::graphic::readbackCallback() : streamCallback;
+                slot.index  = full ? 0 : streamIndex ++;
+                
+                if(full)
+                    droppedFrames ++;
+            }
+            else
+            {
+                slot.stream = vi::graphic::readbackCallback();
+                slot.index  = 0;
+            }
+            
+            slot.requests.swap(requests);
+            requests.clear();
+            
+            slot.width  = width;
+            slot.height = height;
+            slot.frame  = readbackFrame;
+            slot.timestamp = vi::graphic::frameStats::timestamp();
+            slot.busy   = true;
+            
+            nextSlot = (nextSlot + 1) % slots.size();
+            
+#ifdef ViPixelBufferObjects
+            size_t size = (size_t)width * height * 4;
+            
+            if(!slot.buffer)
+                glGenBuffers(1, &slot.buffer);
+            
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            
+            if(slot.size != size)
+            {
+                glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+                slot.size = size;
+            }
+            
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            
+#ifdef ViSyncObjects
+            if(useFences)
+                slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+#else
+            slot.image = new vi::graphic::readbackImage();
+            slot.image->pixels.resize((size_t)width * height * 4);
+            
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &slot.image->pixels[0]);
+#endif
+        }
+        
+        bool pixelReadback::isReady(vi::graphic::readbackSlot& slot)
+        {
+#ifdef ViPixelBufferObjects
+#ifdef ViSyncObjects
+            if(useFences)
+            {
+                GLenum result = glClientWaitSync(slot.fence, 0, 0);
+                return (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+            }
+#endif
+            // Without fences the copy is assumed to be done once the ring is about to reuse the buffer
+            return (readbackFrame - slot.frame >= slots.size() - 1);
+#else
+            return true;
+#endif
+        }
+        
+        void pixelReadback::collect(bool wait)
+        {
+            for(uint32_t i=0; i<slots.size(); i++)
+            {
+                // Starting at the next slot, which is the oldest one
+                readbackSlot& slot = slots[(nextSlot + i) % slots.size()];
+                if(!slot.busy)
+                    continue;
+                
+                if(!wait && !isReady(slot))
+                    break;
+                
+#ifdef ViPixelBufferObjects
+                vi::graphic::readbackImage *image = new vi::graphic::readbackImage();
+                image->pixels.resize(slot.size);
+                
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+                
+                void *data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+                if(data)
+                {
+                    memcpy(&image->pixels[0], data, slot.size);
+                    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                }
+                
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                
+#ifdef ViSyncObjects
+                if(slot.fence)
+                {
+                    glDeleteSync(slot.fence);
+                    slot.fence = NULL;
+                }
+#endif
+#else
+                vi::graphic::readbackImage *image = slot.image;
+                slot.image = NULL;
+#endif
+                
+                slot.busy = false;
+                deliver(slot, image);
+            }
+        }
+        
+        void pixelReadback::deliver(vi::graphic::readbackSlot& slot, vi::graphic::readbackImage *image)
+        {
+            image->width  = slot.width;
+            image->height = slot.height;
+            image->index  = 0;
+            image->timestamp = slot.timestamp;
+            
+            std::vector<vi::graphic::readbackCallback> callbacks;
+            callbacks.swap(slot.requests);
+            
+            std::vector<vi::graphic::readbackCallback>::iterator iterator;
+            for(iterator=callbacks.begin(); iterator!=callbacks.end(); iterator++)
+                (*iterator)(*image);
+            
+            if(!slot.stream)
+            {
+                delete image;
+                return;
+            }
+            
+            image->index = slot.index;
+            
+            pthread_mutex_lock(&mutex);
+            queue.push_back(std::make_pair(slot.stream, image));
+            
+            pthread_cond_signal(&condition);
+            pthread_mutex_unlock(&mutex);
+            
+            slot.stream = vi::graphic::readbackCallback();
+        }
+        
+        
+        
+        void *pixelReadback::workerThread(void *readback)
+        {
+            ((pixelReadback *)readback)->runWorker();
+            return NULL;
+        }
+        
+        void pixelReadback::runWorker()
+        {
+            pthread_mutex_lock(&mutex);
+            
+            while(1)
+            {
+                while(queue.size() == 0 && workerRunning)
+                    pthread_cond_wait(&condition, &mutex);
+                
+                // Queued images are handled before the worker stops
+                if(queue.size() == 0)
+                    break;
+                
+                std::pair<vi::graphic::readbackCallback, vi::graphic::readbackImage *> entry = queue.front();
+                queue.pop_front();
+                
+                pthread_mutex_unlock(&mutex);
+                
+                entry.first(*entry.second);
+                delete entry.second;
+                
+                pthread_mutex_lock(&mutex);
+            }
+            
+            pthread_mutex_unlock(&mutex);
+        }
+        
+        
+        
+        void pixelReadback::collectAll()
+        {
+            readbackFrame ++;
+            
+            std::vector<vi::graphic::pixelReadback *>::iterator iterator;
+            for(iterator=readbacks.begin(); iterator!=readbacks.end(); iterator++)
+                (*iterator)->collect();
+        }
+        
+        bool pixelReadback::writeTGA(vi::graphic::readbackImage const& image, std::string const& path)
+        {
+            if(image.width > 0xffff || image.height > 0xffff || image.pixels.size() < (size_t)image.width * image.height * 4)
+                return false;
+            
+            FILE *file = fopen(path.c_str(), "wb");
+            if(!file)
+                return false;
+            
+            // Uncompressed true color image with 8 bits of alpha, the origin is the bottom left corner just like the rows of the image
+            uint8_t header[18] = { 0 };
+            header[2]  = 2;
+            header[12] = image.width & 0xff;
+            header[13] = (image.width >> 8) & 0xff;
+            header[14] = image.height & 0xff;
+            header[15] = (image.height >> 8) & 0xff;
+            header[16] = 32;
+            header[17] = 8;
+            
+            std::vector<uint8_t> row(image.width * 4);
+            bool result = (fwrite(header, sizeof(header), 1, file) == 1);
+            
+            for(uint32_t y=0; y<image.height && result; y++)
+            {
+                const uint8_t *source = &image.pixels[(size_t)y * image.width * 4];
+                
+                for(uint32_t x=0; x<image.width; x++)
+                {
+                    const uint8_t *pixel = source + x * 4;
+                    uint32_t alpha = pixel[3];
+                    
+                    // TGA stores straight BGRA
+                    for(uint32_t i=0; i<3; i++)
+                    {
+                        uint32_t value = (alpha > 0 && alpha < 255) ? MIN((pixel[2 - i] * 255 + alpha / 2) / alpha, 255) : pixel[2 - i];
+                        row[x * 4 + i] = (uint8_t)value;
+                    }
+                    
+                    row[x * 4 + 3] = (uint8_t)alpha;
+                }
+                
+                result = (fwrite(&row[0], row.size(), 1, file) == 1);
+            }
+            
+            fclose(file);
+            return result;
+        }
+    }
+}
@@ -0,0 +1,282 @@
+//
+//  ViRenderCommand.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#import "ViBase.h"
+#import "ViMatrix4x4.h"
+#import "ViMaterial.h"
+#import "ViMesh.h"
+#import "ViRenderTarget.h"
+#import "ViRect.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * Possible render command types
+         **/
+        typedef enum
+        {
+            /**
+             * Sets the shader, blending and culling state of the commands material.
+             **/
+            renderCommandTypeSetPipeline,
+            /**
+             * Binds the textures of the commands material.
+             **/
+            renderCommandTypeBindTextures,
+            /**
+             * Sets the matrices and the material parameters. The uniform data is stored in the command lists uniforms vector.
+             **/
+            renderCommandTypeSetUniforms,
+            /**
+             * Draws a range of indices of the commands mesh using the commands material.
+             **/
+            renderCommandTypeDraw,
+            /**
+             * Pushes a debug marker with the commands debugName.
+             **/
+            renderCommandTypePushMarker,
+            /**
+             * Pops the last pushed debug marker.
+             **/
+            renderCommandTypePopMarker,
+            /**
+             * Binds and clears the commands render target, following commands render into it until the matching renderCommandTypeEndTarget.
+             **/
+            renderCommandTypeBeginTarget,
+            /**
+             * Restores the framebuffer that was bound before the matching renderCommandTypeBeginTarget.
+             **/
+            renderCommandTypeEndTarget,
+            /**
+             * Clears the depth buffer of the bound framebuffer.
+             **/
+            renderCommandTypeClearDepth,
+            /**
+             * Sets the depth test and depth writes according to the commands depthMode.
+             **/
+            renderCommandTypeSetDepth
+        } renderCommandType;
+        
+        /**
+         * Possible depth modes of renderCommandTypeSetDepth commands
+         **/
+        typedef enum
+        {
+            /**
+             * Depth test and depth writes are disabled, this is the default state.
+             **/
+            renderDepthModeDisabled,
+            /**
+             * Depth test and depth writes are enabled.
+             **/
+            renderDepthModeWrite,
+            /**
+             * Only the depth test is enabled.
+             **/
+            renderDepthModeTest
+        } renderDepthMode;
+
+        /**
+         * @brief A single backend independent render command.
+         **/
+        class renderCommand
+        {
+        public:
+            /**
+             * The type of the command
+             **/
+            renderCommandType type;
+            /**
+             * The material, used by every command but the marker commands.
+             **/
+            vi::graphic::material *material;
+            /**
+             * The mesh to draw, only used by renderCommandTypeDraw.
+             **/
+            vi::common::mesh *mesh;
+            /**
+             * The first index of the draw range.
+             **/
+            uint32_t first;
+            /**
+             * The number of indices to draw.
+             **/
+            uint32_t count;
+            /**
+             * Index into the command lists uniforms vector, only used by renderCommandTypeSetUniforms.
+             **/
+            uint32_t uniforms;
+            /**
+             * The debug name of renderCommandTypePushMarker commands.
+             **/
+            const char *debugName;
+            /**
+             * The render target of renderCommandTypeBeginTarget commands.
+             **/
+            vi::graphic::renderTarget *target;
+            /**
+             * The depth mode of renderCommandTypeSetDepth commands.
+             **/
+            vi::graphic::renderDepthMode depthMode;
+        };
+
+        /**
+         * @brief Snapshot of the uniforms for one or more draw calls.
+         **/
+        class renderUniforms
+        {
+        public:
+            vi::common::matrix4x4 projection;
+            vi::common::matrix4x4 view;
+            vi::common::matrix4x4 model;
+            vi::common::matrix4x4 projViewModel;
+
+            /**
+             * Offset into the command lists parameterData where the values of the materials parameters are stored, in the order of the parameter vector.
+             **/
+            size_t parameterOffset;
+        };
+
+
+        /**
+         * @brief A list of backend independent render commands
+         *
+         * A render command list is generated by a vi::graphic::commandRenderer while traversing the scene and is then executed by a backend. All data that
+         * might change until the list is executed (matrices, material parameters, batched meshes) is copied into the list, so that generating and executing
+         * the commands can be separated.
+         **/
+        class renderCommandList
+        {
+        public:
+            /**
+             * Constructor.
+             **/
+            renderCommandList();
+            /**
+             * Destructor, deletes all transient meshes.
+             **/
+            ~renderCommandList();
+
+            /**
+             * Removes all commands from the list. The allocated memory and the transient meshes are kept for the next frame.
+             **/
+            void reset();
+
+            /**
+             * Appends a command that sets the pipeline state of the given material.
+             **/
+            void setPipeline(vi::graphic::material *material);
+            /**
+             * Appends a command that binds the textures of the given material.
+             **/
+            void bindTextures(vi::graphic::material *material);
+            /**
+             * Appends a command that sets the matrix uniforms and takes a snapshot of the current values of the materials parameters.
+             **/
+            void setUniforms(vi::graphic::material *material, vi::common::matrix4x4 const& projection, vi::common::matrix4x4 const& view, vi::common::matrix4x4 const& model);
+            /**
+             * Appends a command that draws count indices starting at first of the given mesh.
+             **/
+            void draw(vi::graphic::material *material, vi::common::mesh *mesh, uint32_t first, uint32_t count);
+
+            /**
+             * Appends a command that makes the following commands render into the given render target. The target is cleared to transparent black.
+             **/
+            void beginTarget(vi::graphic::renderTarget *target);
+            /**
+             * Appends a command that ends rendering into the last begun render target.
+             **/
+            void endTarget();
+            
+            /**
+             * Appends a command that pushes a debug marker.
+             * @remark The name must stay valid until the list was executed.
+             **/
+            void pushMarker(const char *name);
+            /**
+             * Appends a command that pops the last debug marker.
+             **/
+            void popMarker();
+            
+            /**
+             * Appends a command that clears the depth buffer.
+             **/
+            void clearDepth();
+            /**
+             * Appends a command that sets the depth mode.
+             **/
+            void setDepth(vi::graphic::renderDepthMode mode);
+            /**
+             * Reorders the draws starting at first so that draws with an opaque material are executed front to back, followed by all other draws in their
+             * original order. The draws must have been recorded with increasing depth. The opaque draws write depth, the others only test against it.
+             * @return False if there was nothing to reorder, or if the range contains render target commands, in which case the list is left untouched.
+             * @sa vi::graphic::material::isOpaque()
+             **/
+            bool sortOpaqueFrontToBack(size_t first);
+
+            /**
+             * Returns an empty mesh that is owned by the list and stays valid until the next reset(). Used for meshes that are generated while traversing
+             * the scene, like the meshes of sprite batches.
+             * @param format The vertex format of the mesh, sprite batches using a vi::graphic::textureArray need vi::common::vertexFormatFloat.
+             **/
+            vi::common::mesh *transientMesh(vi::common::vertexFormat format=vi::common::vertexFormatPacked);
+
+            /**
+             * Returns a hash over the commands starting at first, including their uniform snapshots, the content revisions of the bound textures and
+             * the vertices and indices of every drawn mesh. Two lists with the same signature produce the same image.
+             **/
+            uint32_t signature(size_t first=0);
+            /**
+             * Returns a hash over a single draw command, including its material, the bound textures, the given uniform snapshot and the vertices and indices
+             * of the drawn mesh. Two draws with the same signature produce the same pixels.
+             **/
+            uint32_t drawSignature(vi::graphic::renderCommand const& draw, uint32_t uniforms);
+            /**
+             * Returns the bounds of the mesh of a draw command in window coordinates, with the origin in the lower left corner of a viewport of the given size.
+             * @remark The bounds cover all vertices of the mesh, not only the drawn range.
+             **/
+            vi::common::rect drawBounds(vi::graphic::renderCommand const& draw, uint32_t uniforms, vi::common::vector2 const& viewport);
+            /**
+             * Removes all commands starting at first, together with their uniform snapshots.
+             **/
+            void truncate(size_t first);
+            
+            /**
+             * Returns the number of bytes a parameter occupies in the parameterData
+             **/
+            static size_t parameterSize(vi::graphic::materialParameter const& parameter);
+            /**
+             * Returns the number of vertices referenced by the given range of indices of the mesh, from the smallest to the largest index.
+             **/
+            static uint32_t drawnVertices(vi::common::mesh *mesh, uint32_t first, uint32_t count);
+
+
+            /**
+             * The commands in order of execution.
+             **/
+            std::vector<vi::graphic::renderCommand> commands;
+            /**
+             * The uniform snapshots referenced by renderCommandTypeSetUniforms commands.
+             **/
+            std::vector<vi::graphic::renderUniforms> uniforms;
+            /**
+             * The copied values of the material parameters.
+             **/
+            std::vector<uint8_t> parameterData;
+
+        private:
+            void appendDraw(vi::graphic::renderCommand const& draw, vi::graphic::material *&material);
+            
+            std::vector<vi::common::mesh *> transientMeshes;
+            size_t usedTransientMeshes;
+        };
+    }
+}
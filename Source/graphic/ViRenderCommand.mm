@@ -0,0 +1,522 @@
+//
+//  ViRenderCommand.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <cstring>
+#import "ViRenderCommand.h"
+#import "ViShader.h"
+#import "ViTexture.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        renderCommandList::renderCommandList()
+        {
+            usedTransientMeshes = 0;
+        }
+
+        renderCommandList::~renderCommandList()
+        {
+            std::vector<vi::common::mesh *>::iterator iterator;
+            for(iterator=transientMeshes.begin(); iterator!=transientMeshes.end(); iterator++)
+            {
+                delete *iterator;
+            }
+        }
+
+
+        void renderCommandList::reset()
+        {
+            commands.clear();
+            uniforms.clear();
+            parameterData.clear();
+
+            usedTransientMeshes = 0;
+        }
+
+
+        void renderCommandList::setPipeline(vi::graphic::material *material)
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+
+            command.type = renderCommandTypeSetPipeline;
+            command.material = material;
+
+            commands.push_back(command);
+        }
+
+        void renderCommandList::bindTextures(vi::graphic::material *material)
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+
+            command.type = renderCommandTypeBindTextures;
+            command.material = material;
+
+            commands.push_back(command);
+        }
+
+        void renderCommandList::setUniforms(vi::graphic::material *material, vi::common::matrix4x4 const& projection, vi::common::matrix4x4 const& view, vi::common::matrix4x4 const& model)
+        {
+            renderUniforms snapshot;
+            snapshot.projection = projection;
+            snapshot.view  = view;
+            snapshot.model = model;
+            snapshot.parameterOffset = parameterData.size();
+
+            if(material->shader->matProjViewModel != -1)
+                snapshot.projViewModel = snapshot.projection * snapshot.view * snapshot.model;
+
+            std::vector<vi::graphic::materialParameter>::iterator iterator;
+            for(iterator=material->parameter.begin(); iterator!=material->parameter.end(); iterator++)
+            {
+                vi::graphic::materialParameter& parameter = *iterator;
+
+                size_t size   = parameterSize(parameter);
+                size_t offset = parameterData.size();
+
+                parameterData.resize(offset + size);
+                memcpy(&parameterData[offset], parameter.data, size);
+            }
+
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+
+            command.type = renderCommandTypeSetUniforms;
+            command.material = material;
+            command.uniforms = (uint32_t)uniforms.size();
+
+            uniforms.push_back(snapshot);
+            commands.push_back(command);
+        }
+
+        void renderCommandList::draw(vi::graphic::material *material, vi::common::mesh *mesh, uint32_t first, uint32_t count)
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+
+            command.type = renderCommandTypeDraw;
+            command.material = material;
+            command.mesh  = mesh;
+            command.first = first;
+            command.count = count;
+
+            commands.push_back(command);
+        }
+
+
+        void renderCommandList::beginTarget(vi::graphic::renderTarget *target)
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+            
+            command.type = renderCommandTypeBeginTarget;
+            command.target = target;
+            
+            commands.push_back(command);
+        }
+        
+        void renderCommandList::endTarget()
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+            
+            command.type = renderCommandTypeEndTarget;
+            
+            commands.push_back(command);
+        }
+        
+        
+        void renderCommandList::pushMarker(const char *name)
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+
+            command.type = renderCommandTypePushMarker;
+            command.debugName = name;
+
+            commands.push_back(command);
+        }
+
+        void renderCommandList::popMarker()
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+
+            command.type = renderCommandTypePopMarker;
+
+            commands.push_back(command);
+        }
+
+
+        void renderCommandList::clearDepth()
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+            
+            command.type = renderCommandTypeClearDepth;
+            
+            commands.push_back(command);
+        }
+        
+        void renderCommandList::setDepth(vi::graphic::renderDepthMode mode)
+        {
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+            
+            command.type = renderCommandTypeSetDepth;
+            command.depthMode = mode;
+            
+            commands.push_back(command);
+        }
+        
+        bool renderCommandList::sortOpaqueFrontToBack(size_t first)
+        {
+            std::vector<vi::graphic::renderCommand> opaque;
+            std::vector<vi::graphic::renderCommand> transparent;
+            uint32_t uniformIndex = 0;
+            
+            // Collect the draws together with the uniforms they were recorded with, the pipeline and texture commands are generated again afterwards
+            for(size_t i=first; i<commands.size(); i++)
+            {
+                vi::graphic::renderCommand& command = commands[i];
+                
+                switch(command.type)
+                {
+                    case renderCommandTypeSetUniforms:
+                        uniformIndex = command.uniforms;
+                        break;
+                        
+                    case renderCommandTypeDraw:
+                    {
+                        vi::graphic::renderCommand draw = command;
+                        draw.uniforms = uniformIndex;
+                        
+                        if(draw.material->isOpaque())
+                        {
+                            opaque.push_back(draw);
+                        }
+                        else
+                        {
+                            transparent.push_back(draw);
+                        }
+                    }
+                        break;
+                        
+                    case renderCommandTypeBeginTarget:
+                    case renderCommandTypeEndTarget:
+                        return false;
+                        
+                    default:
+                        break;
+                }
+            }
+            
+            if(opaque.size() == 0)
+                return false;
+            
+            commands.resize(first);
+            clearDepth();
+            setDepth(renderDepthModeWrite);
+            
+            vi::graphic::material *material = NULL;
+            std::vector<vi::graphic::renderCommand>::reverse_iterator opaqueDraw;
+            
+            for(opaqueDraw=opaque.rbegin(); opaqueDraw!=opaque.rend(); opaqueDraw++)
+                appendDraw(*opaqueDraw, material);
+            
+            setDepth(renderDepthModeTest);
+            
+            std::vector<vi::graphic::renderCommand>::iterator transparentDraw;
+            for(transparentDraw=transparent.begin(); transparentDraw!=transparent.end(); transparentDraw++)
+                appendDraw(*transparentDraw, material);
+            
+            setDepth(renderDepthModeDisabled);
+            return true;
+        }
+        
+        void renderCommandList::appendDraw(vi::graphic::renderCommand const& draw, vi::graphic::material *&material)
+        {
+            if(material != draw.material)
+            {
+                setPipeline(draw.material);
+                
+                if(!material || material->textures != draw.material->textures || material->texlocations != draw.material->texlocations)
+                    bindTextures(draw.material);
+                
+                material = draw.material;
+            }
+            
+            renderCommand command;
+            memset(&command, 0, sizeof(renderCommand));
+            
+            command.type = renderCommandTypeSetUniforms;
+            command.material = draw.material;
+            command.uniforms = draw.uniforms;
+            
+            commands.push_back(command);
+            
+            command = draw;
+            command.uniforms = 0;
+            
+            commands.push_back(command);
+        }
+        
+        
+        vi::common::mesh *renderCommandList::transientMesh(vi::common::vertexFormat format)
+        {
+            if(usedTransientMeshes >= transientMeshes.size())
+            {
+                // Transient meshes are batches of sprites which have their texture coordinates and colors in the range of 0 to 1
+                vi::common::mesh *mesh = new vi::common::mesh(128 * 4, 128 * 6);
+                mesh->setVertexFormat(vi::common::vertexFormatPacked);
+                
+                transientMeshes.push_back(mesh);
+            }
+
+            // Reset the mesh before the format is set, an empty mesh doesn't have to convert anything and writes its packed vertices directly
+            vi::common::mesh *mesh = transientMeshes[usedTransientMeshes ++];
+            mesh->vertexCount = 0;
+            mesh->indexCount  = 0;
+            mesh->setVertexFormat(format);
+            mesh->dirty       = true;
+
+            return mesh;
+        }
+
+        static inline uint32_t hashBytes(uint32_t hash, const void *data, size_t size)
+        {
+            const uint8_t *bytes = (const uint8_t *)data;
+            for(size_t i=0; i<size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 16777619;
+            }
+            
+            return hash;
+        }
+        
+        uint32_t renderCommandList::signature(size_t first)
+        {
+            uint32_t hash = 2166136261;
+            
+            std::vector<vi::graphic::renderCommand>::iterator iterator;
+            for(iterator=commands.begin() + first; iterator!=commands.end(); iterator++)
+            {
+                vi::graphic::renderCommand& command = *iterator;
+                
+                hash = hashBytes(hash, &command.type, sizeof(command.type));
+                hash = hashBytes(hash, &command.material, sizeof(command.material));
+                hash = hashBytes(hash, &command.target, sizeof(command.target));
+                hash = hashBytes(hash, &command.depthMode, sizeof(command.depthMode));
+                
+                switch(command.type)
+                {
+                    case renderCommandTypeBindTextures:
+                    {
+                        std::vector<vi::graphic::texture *>::iterator texture;
+                        for(texture=command.material->textures.begin(); texture!=command.material->textures.end(); texture++)
+                        {
+                            GLuint name = (*texture)->getTexture();
+                            uint32_t revision = (*texture)->getContentRevision();
+                            
+                            hash = hashBytes(hash, &name, sizeof(GLuint));
+                            hash = hashBytes(hash, &revision, sizeof(uint32_t));
+                        }
+                    }
+                        break;
+                        
+                    case renderCommandTypeSetUniforms:
+                    {
+                        vi::graphic::renderUniforms& snapshot = uniforms[command.uniforms];
+                        
+                        hash = hashBytes(hash, snapshot.projection.matrix, 16 * sizeof(GLfloat));
+                        hash = hashBytes(hash, snapshot.view.matrix, 16 * sizeof(GLfloat));
+                        hash = hashBytes(hash, snapshot.model.matrix, 16 * sizeof(GLfloat));
+                        
+                        size_t size = 0;
+                        std::vector<vi::graphic::materialParameter>::iterator parameter;
+                        for(parameter=command.material->parameter.begin(); parameter!=command.material->parameter.end(); parameter++)
+                            size += parameterSize(*parameter);
+                        
+                        if(size > 0)
+                            hash = hashBytes(hash, &parameterData[snapshot.parameterOffset], size);
+                    }
+                        break;
+                        
+                    case renderCommandTypeDraw:
+                    {
+                        vi::common::mesh *mesh = command.mesh;
+                        
+                        hash = hashBytes(hash, &command.first, sizeof(command.first));
+                        hash = hashBytes(hash, &command.count, sizeof(command.count));
+                        hash = hashBytes(hash, mesh->getVertexData(), mesh->vertexCount * mesh->getVertexStride());
+                        hash = hashBytes(hash, mesh->getIndices(), mesh->indexCount * sizeof(uint16_t));
+                    }
+                        break;
+                        
+                    default:
+                        break;
+                }
+            }
+            
+            return hash;
+        }
+        
+        uint32_t renderCommandList::drawSignature(vi::graphic::renderCommand const& draw, uint32_t uniformIndex)
+        {
+            uint32_t hash = 2166136261;
+            vi::common::mesh *mesh = draw.mesh;
+            vi::graphic::material *material = draw.material;
+            
+            hash = hashBytes(hash, &material, sizeof(material));
+            hash = hashBytes(hash, &draw.first, sizeof(draw.first));
+            hash = hashBytes(hash, &draw.count, sizeof(draw.count));
+            
+            std::vector<vi::graphic::texture *>::iterator texture;
+            for(texture=material->textures.begin(); texture!=material->textures.end(); texture++)
+            {
+                GLuint name = (*texture)->getTexture();
+                uint32_t revision = (*texture)->getContentRevision();
+                
+                hash = hashBytes(hash, &name, sizeof(GLuint));
+                hash = hashBytes(hash, &revision, sizeof(uint32_t));
+            }
+            
+            if(uniformIndex < uniforms.size())
+            {
+                vi::graphic::renderUniforms& snapshot = uniforms[uniformIndex];
+                
+                hash = hashBytes(hash, snapshot.projection.matrix, 16 * sizeof(GLfloat));
+                hash = hashBytes(hash, snapshot.view.matrix, 16 * sizeof(GLfloat));
+                hash = hashBytes(hash, snapshot.model.matrix, 16 * sizeof(GLfloat));
+                
+                size_t size = 0;
+                std::vector<vi::graphic::materialParameter>::iterator parameter;
+                for(parameter=material->parameter.begin(); parameter!=material->parameter.end(); parameter++)
+                    size += parameterSize(*parameter);
+                
+                if(size > 0)
+                    hash = hashBytes(hash, &parameterData[snapshot.parameterOffset], size);
+            }
+            
+            hash = hashBytes(hash, mesh->getVertexData(), mesh->vertexCount * mesh->getVertexStride());
+            hash = hashBytes(hash, mesh->getIndices(), mesh->indexCount * sizeof(uint16_t));
+            
+            return hash;
+        }
+        
+        vi::common::rect renderCommandList::drawBounds(vi::graphic::renderCommand const& draw, uint32_t uniformIndex, vi::common::vector2 const& viewport)
+        {
+            const vi::common::mesh *mesh = draw.mesh;
+            if(mesh->vertexCount == 0 || uniformIndex >= uniforms.size())
+                return vi::common::rect();
+            
+            vi::common::vertex first = mesh->getVertex(0);
+            float minX = first.x, maxX = first.x;
+            float minY = first.y, maxY = first.y;
+            
+            for(uint32_t i=1; i<mesh->vertexCount; i++)
+            {
+                vi::common::vertex vertex = mesh->getVertex(i);
+                
+                minX = MIN(minX, vertex.x);
+                maxX = MAX(maxX, vertex.x);
+                minY = MIN(minY, vertex.y);
+                maxY = MAX(maxY, vertex.y);
+            }
+            
+            vi::graphic::renderUniforms& snapshot = uniforms[uniformIndex];
+            vi::common::matrix4x4 matrix = snapshot.projection * snapshot.view * snapshot.model;
+            const GLfloat *m = matrix.matrix;
+            
+            // Transform the corners of the local bounds, this is exact for the orthographic projections and affine node matrices used by the renderer
+            float corners[4][2] = { { minX, minY }, { maxX, minY }, { maxX, maxY }, { minX, maxY } };
+            float left = 0.0f, right = 0.0f, bottom = 0.0f, top = 0.0f;
+            
+            for(int i=0; i<4; i++)
+            {
+                float x = corners[i][0];
+                float y = corners[i][1];
+                float w = m[3] * x + m[7] * y + m[11] + m[15];
+                
+                if(fabsf(w) <= kViEpsilonFloat)
+                    w = 1.0f;
+                
+                float windowX = ((m[0] * x + m[4] * y + m[8] + m[12]) / w * 0.5f + 0.5f) * viewport.x;
+                float windowY = ((m[1] * x + m[5] * y + m[9] + m[13]) / w * 0.5f + 0.5f) * viewport.y;
+                
+                left   = (i == 0) ? windowX : MIN(left, windowX);
+                right  = (i == 0) ? windowX : MAX(right, windowX);
+                bottom = (i == 0) ? windowY : MIN(bottom, windowY);
+                top    = (i == 0) ? windowY : MAX(top, windowY);
+            }
+            
+            return vi::common::rect(left, bottom, right - left, top - bottom);
+        }
+        
+        void renderCommandList::truncate(size_t first)
+        {
+            for(size_t i=first; i<commands.size(); i++)
+            {
+                if(commands[i].type == renderCommandTypeSetUniforms)
+                {
+                    uint32_t index = commands[i].uniforms;
+                    
+                    parameterData.resize(uniforms[index].parameterOffset);
+                    uniforms.resize(index);
+                    break;
+                }
+            }
+            
+            commands.resize(first);
+        }
+        
+        size_t renderCommandList::parameterSize(vi::graphic::materialParameter const& parameter)
+        {
+            switch(parameter.type)
+            {
+                case vi::graphic::materialParameterTypeInt:
+                    return parameter.count * parameter.size * sizeof(GLint);
+
+                case vi::graphic::materialParameterTypeFloat:
+                    return parameter.count * parameter.size * sizeof(GLfloat);
+
+                case vi::graphic::materialParameterTypeMatrix:
+                    return parameter.count * parameter.count * parameter.size * sizeof(GLfloat);
+
+                default:
+                    break;
+            }
+
+            return 0;
+        }
+        
+        uint32_t renderCommandList::drawnVertices(vi::common::mesh *mesh, uint32_t first, uint32_t count)
+        {
+            if(first == 0 && count >= mesh->indexCount)
+                return mesh->vertexCount;
+            
+            if(count == 0)
+                return 0;
+            
+            const uint16_t *indices = mesh->getIndices() + first;
+            uint16_t lowest  = indices[0];
+            uint16_t highest = indices[0];
+            
+            for(uint32_t i=1; i<count; i++)
+            {
+                lowest  = MIN(lowest, indices[i]);
+                highest = MAX(highest, indices[i]);
+            }
+            
+            return (highest - lowest) + 1;
+        }
+    }
+}
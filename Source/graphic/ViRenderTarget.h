@@ -0,0 +1,79 @@
+//
+//  ViRenderTarget.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViBase.h"
+#import "ViTexture.h"
+#import "ViContext.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief A framebuffer with a texture attached to it
+         *
+         * Render targets are used by cameras that render into a texture. They are managed by a pool, so instead of creating them yourself, use
+         * acquireRenderTarget() and releaseRenderTarget().
+         **/
+        class renderTarget
+        {
+        public:
+            /**
+             * Returns a render target with the given size and format. If the pool contains an unused render target with the same size and format that
+             * was created by the active context, it is reused, otherwise a new render target is created.
+             * @param format The format of the texture, eg. GL_RGBA or GL_RGB
+             * @remark Requires an active context. Framebuffers aren't shared between contexts, so render targets are only reused by the context that created them.
+             **/
+            static renderTarget *acquireRenderTarget(uint32_t width, uint32_t height, GLenum format=GL_RGBA);
+            /**
+             * Gives the render target back to the pool. The render target isn't deleted and might be returned by the next call to acquireRenderTarget().
+             **/
+            static void releaseRenderTarget(renderTarget *target);
+            /**
+             * Deletes all unused render targets of the active context.
+             **/
+            static void purgeUnusedRenderTargets();
+            /**
+             * Removes all render targets of the given context from the pool, which must be done before the context is destroyed. Unused render targets
+             * are deleted right away, the ones that are still used are deleted by releaseRenderTarget() without touching their OpenGL objects again.
+             * @remark The context must be active, vi::common::context invokes this automatically when it is destroyed.
+             **/
+            static void purgeRenderTargets(vi::common::context *context);
+            
+            
+            /**
+             * Returns the framebuffer of the render target.
+             **/
+            GLuint getFramebuffer();
+            /**
+             * Returns the texture that is attached to the framebuffer.
+             **/
+            vi::graphic::texture *getTexture();
+            
+            uint32_t getWidth();
+            uint32_t getHeight();
+            GLenum getFormat();
+            
+        private:
+            renderTarget(uint32_t width, uint32_t height, GLenum format);
+            ~renderTarget();
+            
+            GLuint framebuffer;
+            GLuint name;
+            vi::graphic::texture *texture;
+            
+            uint32_t width;
+            uint32_t height;
+            GLenum format;
+            
+            vi::common::context *context;
+            bool used;
+            bool orphaned;
+        };
+    }
+}
@@ -0,0 +1,186 @@
+//
+//  ViRenderTarget.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#include <pthread.h>
+#import "ViRenderTarget.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        static pthread_mutex_t renderTargetMutex = PTHREAD_MUTEX_INITIALIZER;
+        static std::vector<vi::graphic::renderTarget *> renderTargetPool; // List containing all render targets, used or not.
+        
+        renderTarget *renderTarget::acquireRenderTarget(uint32_t width, uint32_t height, GLenum format)
+        {
+            vi::common::context *context = vi::common::context::getActiveContext();
+            renderTarget *target = NULL;
+            
+            pthread_mutex_lock(&renderTargetMutex);
+            
+            std::vector<vi::graphic::renderTarget *>::iterator iterator;
+            for(iterator=renderTargetPool.begin(); iterator!=renderTargetPool.end(); iterator++)
+            {
+                renderTarget *candidate = *iterator;
+                if(!candidate->used && candidate->context == context && candidate->width == width && candidate->height == height && candidate->format == format)
+                {
+                    target = candidate;
+                    break;
+                }
+            }
+            
+            if(!target)
+            {
+                target = new renderTarget(width, height, format);
+                target->context = context;
+                
+                renderTargetPool.push_back(target);
+            }
+            
+            target->used = true;
+            
+            pthread_mutex_unlock(&renderTargetMutex);
+            return target;
+        }
+        
+        void renderTarget::releaseRenderTarget(renderTarget *target)
+        {
+            if(!target)
+                return;
+            
+            pthread_mutex_lock(&renderTargetMutex);
+            target->used = false;
+            pthread_mutex_unlock(&renderTargetMutex);
+            
+            // The context of the render target is gone, so it isn't in the pool anymore
+            if(target->orphaned)
+                delete target;
+        }
+        
+        void renderTarget::purgeUnusedRenderTargets()
+        {
+            vi::common::context *context = vi::common::context::getActiveContext();
+            
+            pthread_mutex_lock(&renderTargetMutex);
+            
+            std::vector<vi::graphic::renderTarget *>::iterator iterator;
+            for(iterator=renderTargetPool.begin(); iterator!=renderTargetPool.end();)
+            {
+                renderTarget *target = *iterator;
+                if(!target->used && target->context == context)
+                {
+                    delete target;
+                    iterator = renderTargetPool.erase(iterator);
+                    continue;
+                }
+                
+                iterator ++;
+            }
+            
+            pthread_mutex_unlock(&renderTargetMutex);
+        }
+        
+        void renderTarget::purgeRenderTargets(vi::common::context *context)
+        {
+            pthread_mutex_lock(&renderTargetMutex);
+            
+            std::vector<vi::graphic::renderTarget *>::iterator iterator;
+            for(iterator=renderTargetPool.begin(); iterator!=renderTargetPool.end();)
+            {
+                renderTarget *target = *iterator;
+                if(target->context == context)
+                {
+                    // Used render targets stay alive until they are released, but must not be handed out to a new context at the same address
+                    if(target->used)
+                    {
+                        target->orphaned = true;
+                        target->context  = NULL;
+                    }
+                    else
+                        delete target;
+                    
+                    iterator = renderTargetPool.erase(iterator);
+                    continue;
+                }
+                
+                iterator ++;
+            }
+            
+            pthread_mutex_unlock(&renderTargetMutex);
+        }
+        
+        
+        
+        renderTarget::renderTarget(uint32_t twidth, uint32_t theight, GLenum tformat)
+        {
+            width  = twidth;
+            height = theight;
+            format = tformat;
+            used   = false;
+            orphaned = false;
+            context = NULL;
+            
+            GLint prevBuffer;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevBuffer);
+            
+            glGenFramebuffers(1, &framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            
+            glGenTextures(1, &name);
+            glBindTexture(GL_TEXTURE_2D, name);
+            
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+            
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, name, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, prevBuffer);
+            
+            texture = new vi::graphic::texture(name, width, height);
+        }
+        
+        renderTarget::~renderTarget()
+        {
+            // The objects of orphaned render targets were deleted together with their context
+            if(!orphaned)
+            {
+                glDeleteFramebuffers(1, &framebuffer);
+                glDeleteTextures(1, &name);
+            }
+            
+            delete texture;
+        }
+        
+        
+        GLuint renderTarget::getFramebuffer()
+        {
+            return framebuffer;
+        }
+        
+        vi::graphic::texture *renderTarget::getTexture()
+        {
+            return texture;
+        }
+        
+        uint32_t renderTarget::getWidth()
+        {
+            return width;
+        }
+        
+        uint32_t renderTarget::getHeight()
+        {
+            return height;
+        }
+        
+        GLenum renderTarget::getFormat()
+        {
+            return format;
+        }
+    }
+}
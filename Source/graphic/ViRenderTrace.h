@@ -0,0 +1,274 @@
+//
+//  ViRenderTrace.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#include <map>
+#include <string>
+#import "ViBase.h"
+#import "ViRenderCommand.h"
+#import "ViMaterial.h"
+#import "ViTexture.h"
+#import "ViMesh.h"
+#import "ViColor.h"
+
+namespace vi
+{
+    namespace scene
+    {
+        class camera;
+    }
+
+    namespace graphic
+    {
+        class commandRenderer;
+        class renderTarget;
+        class shader;
+
+        /**
+         * @cond
+         **/
+        typedef enum
+        {
+            traceTextureSourceImage,
+            traceTextureSourceTarget,
+            traceTextureSourceCamera
+        } traceTextureSource;
+
+        typedef struct
+        {
+            uint32_t source;
+            uint32_t sourceIndex;
+            uint32_t width, height;
+            float scaleFactor;
+            bool alpha;
+            std::vector<uint8_t> pixels;
+        } traceTexture;
+
+        typedef struct
+        {
+            std::string vertexFile;
+            std::string fragmentFile;
+        } traceShader;
+
+        typedef struct
+        {
+            std::string name;
+            uint32_t type, count, size;
+        } traceParameter;
+
+        typedef struct
+        {
+            uint32_t shader;
+            GLenum drawMode;
+            bool culling;
+            GLenum cullMode;
+            bool blending;
+            GLenum blendSource, blendDestination;
+
+            std::vector<uint32_t> textures;
+            std::vector<uint32_t> texlocations;
+            std::vector<traceParameter> parameter;
+        } traceMaterial;
+
+        typedef struct
+        {
+            uint32_t format;
+            bool vbo;
+            bool dynamic;
+            uint32_t hash;
+            std::vector<vi::common::vertex> vertices;
+            std::vector<uint16_t> indices;
+        } traceMesh;
+
+        typedef struct
+        {
+            uint32_t width, height;
+            GLenum format;
+        } traceTarget;
+
+        typedef struct
+        {
+            vi::common::vector2 size;
+            bool view;
+        } traceCamera;
+
+        typedef struct
+        {
+            uint32_t type;
+            uint32_t depthMode;
+            uint32_t material;
+            uint32_t mesh;
+            uint32_t first, count;
+            uint32_t uniforms;
+            uint32_t target;
+            uint32_t marker;
+        } traceCommand;
+
+        typedef struct
+        {
+            uint32_t frame;
+            uint32_t camera;
+            vi::common::color clearColor;
+
+            std::vector<traceCommand> commands;
+            std::vector<vi::graphic::renderUniforms> uniforms;
+            std::vector<uint8_t> parameterData;
+        } traceList;
+        /**
+         * @endcond
+         **/
+
+        /**
+         * @brief The time a single draw took while replaying a trace
+         **/
+        typedef struct
+        {
+            /**
+             * The frame of the trace the draw belongs to.
+             **/
+            uint32_t frame;
+            /**
+             * The index of the command list in the trace, every rendered camera adds one list.
+             **/
+            uint32_t list;
+            /**
+             * The index of the draw command in its list.
+             **/
+            uint32_t command;
+            /**
+             * The number of indices that were drawn.
+             **/
+            uint32_t indices;
+            /**
+             * The time in seconds, measured on the CPU with the backend synchronized before and after the draw.
+             **/
+            double time;
+        } renderTraceTiming;
+
+
+        /**
+         * @brief A recording of the command lists a renderer submitted
+         *
+         * A render trace captures everything that is needed to execute the command lists of one or more frames again, without the scene that generated
+         * them: the materials with their shaders and state, the vertices and indices of the drawn meshes, the uniform snapshots and the draw ranges,
+         * depth and render target commands. Meshes, materials and textures are only stored once, no matter how often they are drawn.
+         * Traces are captured with vi::graphic::commandRenderer::captureTrace() and can be replayed against any vi::graphic::commandRenderer, for
+         * example by the TraceReplay tool, to profile the draw stream of a device on another machine.
+         * @remark Texture pixels are only stored for textures that keep their pixel data, see vi::graphic::texture::setKeepsPixelData(). Other textures
+         * are replayed as opaque white textures of the same size. Custom vertex attributes of materials, the layers of texture arrays and the scissor
+         * rectangle of partial redraws aren't recorded.
+         **/
+        class renderTrace
+        {
+        public:
+            /**
+             * Constructor for an empty trace.
+             **/
+            renderTrace();
+            /**
+             * Destructor, releases the resources that were created for the replay.
+             **/
+            ~renderTrace();
+
+            /**
+             * Records the given command list, which is about to be executed with the given camera.
+             **/
+            void record(vi::graphic::renderCommandList *list, vi::scene::camera *camera);
+            /**
+             * Marks the end of a frame, the following lists belong to the next frame.
+             **/
+            void endFrame();
+            /**
+             * Removes all recorded data.
+             **/
+            void clear();
+
+            /**
+             * Writes the trace into the file at the given path.
+             * @return False if the file couldn't be written.
+             **/
+            bool save(std::string const& path);
+            /**
+             * Replaces the trace with the trace stored in the file at the given path.
+             * @return False if the file couldn't be read or isn't a valid trace, which includes meshes with indices outside of their vertices.
+             **/
+            bool load(std::string const& path);
+
+            /**
+             * Executes all recorded command lists with the given renderer. Textures, shaders, materials, meshes, render targets and cameras are created on
+             * the first replay and reused by the following ones, so replaying multiple times gives stable timings. View cameras are replayed into
+             * textures of the same size.
+             * @param renderer The backend that executes the lists. Requires an active context.
+             * @param timings If not NULL, the backend is synchronized after every draw and the time of each draw is appended. Backends that don't
+             * measure draws don't append anything.
+             * @return The time in seconds it took to execute all lists.
+             **/
+            double replay(vi::graphic::commandRenderer *renderer, std::vector<vi::graphic::renderTraceTiming> *timings=NULL);
+
+            /**
+             * Returns the number of completed frames.
+             **/
+            uint32_t getFrameCount();
+            /**
+             * Returns the number of recorded command lists.
+             **/
+            uint32_t getListCount();
+            /**
+             * Returns the GLSL version of the context the trace was recorded with.
+             **/
+            uint32_t getGLSLVersion();
+            /**
+             * Returns the scale factor of the kernel the trace was recorded with.
+             **/
+            float getScaleFactor();
+
+        private:
+            uint32_t indexOfTexture(vi::graphic::texture *texture);
+            uint32_t indexOfShader(vi::graphic::shader *shader);
+            uint32_t indexOfMaterial(vi::graphic::material *material);
+            uint32_t indexOfMesh(vi::common::mesh *mesh);
+            uint32_t indexOfTarget(vi::graphic::renderTarget *target);
+            uint32_t indexOfCamera(vi::scene::camera *camera);
+            uint32_t indexOfMarker(const char *name);
+
+            void createResources();
+            void releaseResources();
+
+            uint32_t frameCount;
+            uint32_t glslVersion;
+            float scaleFactor;
+
+            std::vector<traceTexture> textures;
+            std::vector<traceShader> shaders;
+            std::vector<traceMaterial> materials;
+            std::vector<traceMesh> meshes;
+            std::vector<traceTarget> targets;
+            std::vector<traceCamera> cameras;
+            std::vector<std::string> markers;
+            std::vector<traceList> lists;
+
+            std::map<vi::graphic::texture *, uint32_t> textureIndices;
+            std::map<vi::graphic::shader *, uint32_t> shaderIndices;
+            std::map<vi::graphic::material *, uint32_t> materialIndices;
+            std::map<uint32_t, std::vector<uint32_t> > meshIndices;
+            std::map<vi::graphic::renderTarget *, uint32_t> targetIndices;
+            std::map<vi::scene::camera *, uint32_t> cameraIndices;
+            std::map<std::string, uint32_t> markerIndices;
+
+            bool prepared;
+            std::vector<vi::graphic::texture *> replayTextures;
+            std::vector<vi::graphic::shader *> replayShaders;
+            std::vector<vi::graphic::material *> replayMaterials;
+            std::vector<std::vector<uint8_t> > replayParameterData;
+            std::vector<vi::common::mesh *> replayMeshes;
+            std::vector<vi::graphic::renderTarget *> replayTargets;
+            std::vector<vi::scene::camera *> replayCameras;
+            vi::graphic::renderCommandList replayList;
+        };
+    }
+}
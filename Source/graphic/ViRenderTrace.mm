@@ -0,0 +1,1175 @@
+//
+//  ViRenderTrace.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <cstring>
+#import <Foundation/Foundation.h>
+#import "ViRenderTrace.h"
+#import "ViCommandRenderer.h"
+#import "ViRenderTarget.h"
+#import "ViShader.h"
+#import "ViCamera.h"
+#import "ViContext.h"
+#import "ViKernel.h"
+
+#define kViRenderTraceMagic   0x52544956
+#define kViRenderTraceVersion 1
+#define kViRenderTraceNone    UINT32_MAX
+
+namespace vi
+{
+    namespace graphic
+    {
+        static inline uint32_t traceHash(uint32_t hash, const void *data, size_t size)
+        {
+            const uint8_t *bytes = (const uint8_t *)data;
+            for(size_t i=0; i<size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 16777619;
+            }
+
+            return hash;
+        }
+
+        static bool traceMaterialsEqual(traceMaterial const& a, traceMaterial const& b)
+        {
+            if(a.shader != b.shader || a.drawMode != b.drawMode || a.culling != b.culling || a.cullMode != b.cullMode)
+                return false;
+
+            if(a.blending != b.blending || a.blendSource != b.blendSource || a.blendDestination != b.blendDestination)
+                return false;
+
+            if(a.textures != b.textures || a.texlocations != b.texlocations || a.parameter.size() != b.parameter.size())
+                return false;
+
+            for(size_t i=0; i<a.parameter.size(); i++)
+            {
+                traceParameter const& pa = a.parameter[i];
+                traceParameter const& pb = b.parameter[i];
+
+                if(pa.name != pb.name || pa.type != pb.type || pa.count != pb.count || pa.size != pb.size)
+                    return false;
+            }
+
+            return true;
+        }
+
+
+
+        // Serialization helpers, the trace is stored in the byte order of the recording machine which is marked by the magic number
+        static void writeBytes(std::vector<uint8_t>& data, const void *bytes, size_t size)
+        {
+            const uint8_t *source = (const uint8_t *)bytes;
+            data.insert(data.end(), source, source + size);
+        }
+
+        static void writeUInt(std::vector<uint8_t>& data, uint32_t value)
+        {
+            writeBytes(data, &value, sizeof(uint32_t));
+        }
+
+        static void writeFloat(std::vector<uint8_t>& data, float value)
+        {
+            writeBytes(data, &value, sizeof(float));
+        }
+
+        static void writeString(std::vector<uint8_t>& data, std::string const& string)
+        {
+            writeUInt(data, (uint32_t)string.length());
+            writeBytes(data, string.data(), string.length());
+        }
+
+        typedef struct
+        {
+            const uint8_t *bytes;
+            size_t size;
+            size_t offset;
+            bool valid;
+        } traceReader;
+
+        static void readBytes(traceReader& reader, void *bytes, size_t size)
+        {
+            if(!reader.valid || reader.size - reader.offset < size)
+            {
+                reader.valid = false;
+                memset(bytes, 0, size);
+                return;
+            }
+
+            memcpy(bytes, reader.bytes + reader.offset, size);
+            reader.offset += size;
+        }
+
+        static uint32_t readUInt(traceReader& reader)
+        {
+            uint32_t value;
+            readBytes(reader, &value, sizeof(uint32_t));
+
+            return value;
+        }
+
+        static float readFloat(traceReader& reader)
+        {
+            float value;
+            readBytes(reader, &value, sizeof(float));
+
+            return value;
+        }
+
+        static uint32_t readCount(traceReader& reader, size_t elementSize)
+        {
+            uint32_t count = readUInt(reader);
+
+            // Guard against corrupt files before anything gets allocated
+            if(elementSize > 0 && count > (reader.size - reader.offset) / elementSize)
+            {
+                reader.valid = false;
+                return 0;
+            }
+
+            return count;
+        }
+
+        static std::string readString(traceReader& reader)
+        {
+            uint32_t length = readCount(reader, 1);
+            if(length == 0)
+                return std::string();
+
+            std::string string((const char *)reader.bytes + reader.offset, length);
+            reader.offset += length;
+
+            return string;
+        }
+
+
+
+        renderTrace::renderTrace()
+        {
+            prepared = false;
+            clear();
+        }
+
+        renderTrace::~renderTrace()
+        {
+            releaseResources();
+        }
+
+
+
+        void renderTrace::clear()
+        {
+            releaseResources();
+
+            vi::common::context *context = vi::common::context::getActiveContext();
+            vi::common::kernel *kernel = vi::common::kernel::sharedKernel();
+
+            frameCount  = 0;
+            glslVersion = context ? context->getGLSLVersion() : 120;
+            scaleFactor = kernel ? kernel->scaleFactor : 1.0f;
+
+            textures.clear();
+            shaders.clear();
+            materials.clear();
+            meshes.clear();
+            targets.clear();
+            cameras.clear();
+            markers.clear();
+            lists.clear();
+
+            textureIndices.clear();
+            shaderIndices.clear();
+            materialIndices.clear();
+            meshIndices.clear();
+            targetIndices.clear();
+            cameraIndices.clear();
+            markerIndices.clear();
+        }
+
+        void renderTrace::record(vi::graphic::renderCommandList *list, vi::scene::camera *camera)
+        {
+            releaseResources();
+
+            lists.push_back(traceList());
+
+            traceList& entry = lists.back();
+            entry.frame  = frameCount;
+            entry.camera = indexOfCamera(camera);
+            entry.clearColor    = camera->clearColor;
+            entry.uniforms      = list->uniforms;
+            entry.parameterData = list->parameterData;
+
+            entry.commands.reserve(list->commands.size());
+
+            std::vector<vi::graphic::renderCommand>::iterator iterator;
+            for(iterator=list->commands.begin(); iterator!=list->commands.end(); iterator++)
+            {
+                vi::graphic::renderCommand& command = *iterator;
+                traceCommand tcommand;
+
+                tcommand.type      = command.type;
+                tcommand.depthMode = command.depthMode;
+                tcommand.first     = command.first;
+                tcommand.count     = command.count;
+                tcommand.uniforms  = command.uniforms;
+                tcommand.material  = command.material ? indexOfMaterial(command.material) : kViRenderTraceNone;
+                tcommand.mesh      = (command.type == renderCommandTypeDraw) ? indexOfMesh(command.mesh) : kViRenderTraceNone;
+                tcommand.target    = command.target ? indexOfTarget(command.target) : kViRenderTraceNone;
+                tcommand.marker    = command.debugName ? indexOfMarker(command.debugName) : kViRenderTraceNone;
+
+                entry.commands.push_back(tcommand);
+            }
+        }
+
+        void renderTrace::endFrame()
+        {
+            frameCount ++;
+        }
+
+
+
+        uint32_t renderTrace::indexOfTexture(vi::graphic::texture *texture)
+        {
+            std::map<vi::graphic::texture *, uint32_t>::iterator iterator = textureIndices.find(texture);
+            if(iterator != textureIndices.end())
+                return iterator->second;
+
+            traceTexture ttexture;
+            ttexture.source      = traceTextureSourceImage;
+            ttexture.sourceIndex = 0;
+            ttexture.width       = texture->getWidth();
+            ttexture.height      = texture->getHeight();
+            ttexture.scaleFactor = texture->getScaleFactor();
+            ttexture.alpha       = texture->hasAlphaChannel();
+
+            const uint8_t *pixels = texture->getPixelData();
+            if(pixels)
+            {
+                // The pixel data has the size of the image in pixels, the texture size is in points
+                size_t size = (size_t)lroundf(ttexture.width * ttexture.scaleFactor) * (size_t)lroundf(ttexture.height * ttexture.scaleFactor) * 4;
+                ttexture.pixels.assign(pixels, pixels + size);
+            }
+
+            uint32_t index = (uint32_t)textures.size();
+
+            textures.push_back(ttexture);
+            textureIndices[texture] = index;
+
+            return index;
+        }
+
+        uint32_t renderTrace::indexOfShader(vi::graphic::shader *shader)
+        {
+            std::map<vi::graphic::shader *, uint32_t>::iterator iterator = shaderIndices.find(shader);
+            if(iterator != shaderIndices.end())
+                return iterator->second;
+
+            traceShader tshader;
+            tshader.vertexFile   = shader->getVertexFile();
+            tshader.fragmentFile = shader->getFragmentFile();
+
+            uint32_t index = (uint32_t)shaders.size();
+
+            shaders.push_back(tshader);
+            shaderIndices[shader] = index;
+
+            return index;
+        }
+
+        uint32_t renderTrace::indexOfMaterial(vi::graphic::material *material)
+        {
+            traceMaterial tmaterial;
+            tmaterial.shader   = indexOfShader(material->shader);
+            tmaterial.drawMode = material->drawMode;
+            tmaterial.culling  = material->culling;
+            tmaterial.cullMode = material->cullMode;
+            tmaterial.blending = material->blending;
+            tmaterial.blendSource      = material->blendSource;
+            tmaterial.blendDestination = material->blendDestination;
+            tmaterial.texlocations     = material->texlocations;
+
+            std::vector<vi::graphic::texture *>::iterator texture;
+            for(texture=material->textures.begin(); texture!=material->textures.end(); texture++)
+                tmaterial.textures.push_back(indexOfTexture(*texture));
+
+            std::vector<vi::graphic::materialParameter>::iterator parameter;
+            for(parameter=material->parameter.begin(); parameter!=material->parameter.end(); parameter++)
+            {
+                traceParameter tparameter;
+                tparameter.name  = parameter->name;
+                tparameter.type  = parameter->type;
+                tparameter.count = parameter->count;
+                tparameter.size  = parameter->size;
+
+                tmaterial.parameter.push_back(tparameter);
+            }
+
+            // Materials can change between frames, in which case the changed material is stored again
+            std::map<vi::graphic::material *, uint32_t>::iterator iterator = materialIndices.find(material);
+            if(iterator != materialIndices.end() && traceMaterialsEqual(materials[iterator->second], tmaterial))
+                return iterator->second;
+
+            uint32_t index = (uint32_t)materials.size();
+
+            materials.push_back(tmaterial);
+            materialIndices[material] = index;
+
+            return index;
+        }
+
+        uint32_t renderTrace::indexOfMesh(vi::common::mesh *mesh)
+        {
+            uint32_t format = mesh->getVertexFormat();
+            uint32_t hash = 2166136261;
+            
+            // Traces always store float vertices, packed meshes are unpacked without changing their storage
+            std::vector<vi::common::vertex> vertices(mesh->vertexCount);
+            for(uint32_t i=0; i<mesh->vertexCount; i++)
+                vertices[i] = mesh->getVertex(i);
+
+            hash = traceHash(hash, &format, sizeof(uint32_t));
+            if(mesh->vertexCount > 0)
+                hash = traceHash(hash, &vertices[0], mesh->vertexCount * sizeof(vi::common::vertex));
+            hash = traceHash(hash, mesh->getIndices(), mesh->indexCount * sizeof(uint16_t));
+
+            // Meshes are stored by content, so a static mesh is only stored once and batched meshes that look the same share their data
+            std::vector<uint32_t>& candidates = meshIndices[hash];
+            std::vector<uint32_t>::iterator iterator;
+
+            for(iterator=candidates.begin(); iterator!=candidates.end(); iterator++)
+            {
+                traceMesh& tmesh = meshes[*iterator];
+
+                if(tmesh.format != format || tmesh.vertices.size() != mesh->vertexCount || tmesh.indices.size() != mesh->indexCount)
+                    continue;
+
+                if(mesh->vertexCount > 0 && memcmp(&tmesh.vertices[0], &vertices[0], mesh->vertexCount * sizeof(vi::common::vertex)) != 0)
+                    continue;
+
+                if(mesh->indexCount > 0 && memcmp(&tmesh.indices[0], mesh->getIndices(), mesh->indexCount * sizeof(uint16_t)) != 0)
+                    continue;
+
+                return *iterator;
+            }
+
+            traceMesh tmesh;
+            tmesh.format  = format;
+            tmesh.vbo     = (mesh->vbo != -1);
+            tmesh.dynamic = mesh->dynamic;
+            tmesh.hash    = hash;
+            tmesh.vertices.swap(vertices);
+            tmesh.indices.assign(mesh->getIndices(), mesh->getIndices() + mesh->indexCount);
+
+            uint32_t index = (uint32_t)meshes.size();
+
+            meshes.push_back(tmesh);
+            candidates.push_back(index);
+
+            return index;
+        }
+
+        uint32_t renderTrace::indexOfTarget(vi::graphic::renderTarget *target)
+        {
+            std::map<vi::graphic::renderTarget *, uint32_t>::iterator iterator = targetIndices.find(target);
+            if(iterator != targetIndices.end())
+                return iterator->second;
+
+            traceTarget ttarget;
+            ttarget.width  = target->getWidth();
+            ttarget.height = target->getHeight();
+            ttarget.format = target->getFormat();
+
+            uint32_t index = (uint32_t)targets.size();
+
+            targets.push_back(ttarget);
+            targetIndices[target] = index;
+
+            // Materials that sample the target are replayed with the replayed target
+            if(textureIndices.find(target->getTexture()) == textureIndices.end())
+            {
+                traceTexture& ttexture = textures[indexOfTexture(target->getTexture())];
+                ttexture.source      = traceTextureSourceTarget;
+                ttexture.sourceIndex = index;
+                ttexture.pixels.clear();
+            }
+
+            return index;
+        }
+
+        uint32_t renderTrace::indexOfCamera(vi::scene::camera *camera)
+        {
+            std::map<vi::scene::camera *, uint32_t>::iterator iterator = cameraIndices.find(camera);
+            if(iterator != cameraIndices.end())
+                return iterator->second;
+
+            traceCamera tcamera;
+            tcamera.size = camera->frame.size;
+            tcamera.view = (camera->getTexture() == NULL);
+
+            uint32_t index = (uint32_t)cameras.size();
+
+            cameras.push_back(tcamera);
+            cameraIndices[camera] = index;
+
+            vi::graphic::texture *texture = camera->getTexture();
+            if(texture && textureIndices.find(texture) == textureIndices.end())
+            {
+                traceTexture& ttexture = textures[indexOfTexture(texture)];
+                ttexture.source      = traceTextureSourceCamera;
+                ttexture.sourceIndex = index;
+                ttexture.pixels.clear();
+            }
+
+            return index;
+        }
+
+        uint32_t renderTrace::indexOfMarker(const char *name)
+        {
+            std::string marker = name;
+
+            std::map<std::string, uint32_t>::iterator iterator = markerIndices.find(marker);
+            if(iterator != markerIndices.end())
+                return iterator->second;
+
+            uint32_t index = (uint32_t)markers.size();
+
+            markers.push_back(marker);
+            markerIndices[marker] = index;
+
+            return index;
+        }
+
+
+
+        bool renderTrace::save(std::string const& path)
+        {
+            std::vector<uint8_t> data;
+
+            writeUInt(data, kViRenderTraceMagic);
+            writeUInt(data, kViRenderTraceVersion);
+            writeUInt(data, glslVersion);
+            writeFloat(data, scaleFactor);
+            writeUInt(data, frameCount);
+
+            writeUInt(data, (uint32_t)textures.size());
+            for(size_t i=0; i<textures.size(); i++)
+            {
+                traceTexture& texture = textures[i];
+
+                writeUInt(data, texture.source);
+                writeUInt(data, texture.sourceIndex);
+                writeUInt(data, texture.width);
+                writeUInt(data, texture.height);
+                writeFloat(data, texture.scaleFactor);
+                writeUInt(data, texture.alpha);
+                writeUInt(data, (uint32_t)texture.pixels.size());
+
+                if(texture.pixels.size() > 0)
+                    writeBytes(data, &texture.pixels[0], texture.pixels.size());
+            }
+
+            writeUInt(data, (uint32_t)shaders.size());
+            for(size_t i=0; i<shaders.size(); i++)
+            {
+                writeString(data, shaders[i].vertexFile);
+                writeString(data, shaders[i].fragmentFile);
+            }
+
+            writeUInt(data, (uint32_t)materials.size());
+            for(size_t i=0; i<materials.size(); i++)
+            {
+                traceMaterial& material = materials[i];
+
+                writeUInt(data, material.shader);
+                writeUInt(data, material.drawMode);
+                writeUInt(data, material.culling);
+                writeUInt(data, material.cullMode);
+                writeUInt(data, material.blending);
+                writeUInt(data, material.blendSource);
+                writeUInt(data, material.blendDestination);
+
+                writeUInt(data, (uint32_t)material.textures.size());
+                for(size_t j=0; j<material.textures.size(); j++)
+                    writeUInt(data, material.textures[j]);
+
+                writeUInt(data, (uint32_t)material.texlocations.size());
+                for(size_t j=0; j<material.texlocations.size(); j++)
+                    writeUInt(data, material.texlocations[j]);
+
+                writeUInt(data, (uint32_t)material.parameter.size());
+                for(size_t j=0; j<material.parameter.size(); j++)
+                {
+                    writeString(data, material.parameter[j].name);
+                    writeUInt(data, material.parameter[j].type);
+                    writeUInt(data, material.parameter[j].count);
+                    writeUInt(data, material.parameter[j].size);
+                }
+            }
+
+            writeUInt(data, (uint32_t)meshes.size());
+            for(size_t i=0; i<meshes.size(); i++)
+            {
+                traceMesh& mesh = meshes[i];
+
+                writeUInt(data, mesh.format);
+                writeUInt(data, mesh.vbo);
+                writeUInt(data, mesh.dynamic);
+
+                writeUInt(data, (uint32_t)mesh.vertices.size());
+                if(mesh.vertices.size() > 0)
+                    writeBytes(data, &mesh.vertices[0], mesh.vertices.size() * sizeof(vi::common::vertex));
+
+                writeUInt(data, (uint32_t)mesh.indices.size());
+                if(mesh.indices.size() > 0)
+                    writeBytes(data, &mesh.indices[0], mesh.indices.size() * sizeof(uint16_t));
+            }
+
+            writeUInt(data, (uint32_t)targets.size());
+            for(size_t i=0; i<targets.size(); i++)
+            {
+                writeUInt(data, targets[i].width);
+                writeUInt(data, targets[i].height);
+                writeUInt(data, targets[i].format);
+            }
+
+            writeUInt(data, (uint32_t)cameras.size());
+            for(size_t i=0; i<cameras.size(); i++)
+            {
+                writeFloat(data, cameras[i].size.x);
+                writeFloat(data, cameras[i].size.y);
+                writeUInt(data, cameras[i].view);
+            }
+
+            writeUInt(data, (uint32_t)markers.size());
+            for(size_t i=0; i<markers.size(); i++)
+                writeString(data, markers[i]);
+
+            writeUInt(data, (uint32_t)lists.size());
+            for(size_t i=0; i<lists.size(); i++)
+            {
+                traceList& list = lists[i];
+
+                writeUInt(data, list.frame);
+                writeUInt(data, list.camera);
+                writeFloat(data, list.clearColor.r);
+                writeFloat(data, list.clearColor.g);
+                writeFloat(data, list.clearColor.b);
+                writeFloat(data, list.clearColor.a);
+
+                writeUInt(data, (uint32_t)list.commands.size());
+                if(list.commands.size() > 0)
+                    writeBytes(data, &list.commands[0], list.commands.size() * sizeof(traceCommand));
+
+                // The combined matrix is calculated again when loading
+                writeUInt(data, (uint32_t)list.uniforms.size());
+                for(size_t j=0; j<list.uniforms.size(); j++)
+                {
+                    vi::graphic::renderUniforms& uniforms = list.uniforms[j];
+
+                    writeBytes(data, uniforms.projection.matrix, 16 * sizeof(GLfloat));
+                    writeBytes(data, uniforms.view.matrix, 16 * sizeof(GLfloat));
+                    writeBytes(data, uniforms.model.matrix, 16 * sizeof(GLfloat));
+                    writeUInt(data, (uint32_t)uniforms.parameterOffset);
+                }
+
+                writeUInt(data, (uint32_t)list.parameterData.size());
+                if(list.parameterData.size() > 0)
+                    writeBytes(data, &list.parameterData[0], list.parameterData.size());
+            }
+
+            bool result;
+
+            @autoreleasepool
+            {
+                NSData *file = [NSData dataWithBytes:&data[0] length:data.size()];
+                result = [file writeToFile:[NSString stringWithUTF8String:path.c_str()] atomically:YES];
+            }
+
+            if(!result)
+                ViLog(@"Couldn't write render trace to %s!", path.c_str());
+
+            return result;
+        }
+
+        bool renderTrace::load(std::string const& path)
+        {
+            clear();
+
+            NSData *file = [[NSData alloc] initWithContentsOfFile:[NSString stringWithUTF8String:path.c_str()]];
+            if(!file)
+            {
+                ViLog(@"Couldn't read render trace %s!", path.c_str());
+                return false;
+            }
+
+            traceReader reader;
+            reader.bytes  = (const uint8_t *)[file bytes];
+            reader.size   = [file length];
+            reader.offset = 0;
+            reader.valid  = true;
+
+            if(readUInt(reader) != kViRenderTraceMagic || readUInt(reader) != kViRenderTraceVersion)
+            {
+                ViLog(@"%s isn't a render trace of this version!", path.c_str());
+                [file release];
+
+                return false;
+            }
+
+            glslVersion = readUInt(reader);
+            scaleFactor = readFloat(reader);
+            frameCount  = readUInt(reader);
+
+            uint32_t count = readCount(reader, 7 * sizeof(uint32_t));
+            textures.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                traceTexture& texture = textures[i];
+
+                texture.source      = readUInt(reader);
+                texture.sourceIndex = readUInt(reader);
+                texture.width       = readUInt(reader);
+                texture.height      = readUInt(reader);
+                texture.scaleFactor = readFloat(reader);
+                texture.alpha       = (readUInt(reader) != 0);
+
+                texture.pixels.resize(readCount(reader, 1));
+                if(texture.pixels.size() > 0)
+                    readBytes(reader, &texture.pixels[0], texture.pixels.size());
+            }
+
+            count = readCount(reader, 2 * sizeof(uint32_t));
+            shaders.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                shaders[i].vertexFile   = readString(reader);
+                shaders[i].fragmentFile = readString(reader);
+            }
+
+            count = readCount(reader, 10 * sizeof(uint32_t));
+            materials.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                traceMaterial& material = materials[i];
+
+                material.shader   = readUInt(reader);
+                material.drawMode = readUInt(reader);
+                material.culling  = (readUInt(reader) != 0);
+                material.cullMode = readUInt(reader);
+                material.blending = (readUInt(reader) != 0);
+                material.blendSource      = readUInt(reader);
+                material.blendDestination = readUInt(reader);
+
+                material.textures.resize(readCount(reader, sizeof(uint32_t)));
+                for(size_t j=0; j<material.textures.size(); j++)
+                    material.textures[j] = readUInt(reader);
+
+                material.texlocations.resize(readCount(reader, sizeof(uint32_t)));
+                for(size_t j=0; j<material.texlocations.size(); j++)
+                    material.texlocations[j] = readUInt(reader);
+
+                material.parameter.resize(readCount(reader, 4 * sizeof(uint32_t)));
+                for(size_t j=0; j<material.parameter.size(); j++)
+                {
+                    material.parameter[j].name  = readString(reader);
+                    material.parameter[j].type  = readUInt(reader);
+                    material.parameter[j].count = readUInt(reader);
+                    material.parameter[j].size  = readUInt(reader);
+                }
+            }
+
+            count = readCount(reader, 5 * sizeof(uint32_t));
+            meshes.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                traceMesh& mesh = meshes[i];
+
+                mesh.format  = readUInt(reader);
+                mesh.vbo     = (readUInt(reader) != 0);
+                mesh.dynamic = (readUInt(reader) != 0);
+                mesh.hash    = 0;
+
+                mesh.vertices.resize(readCount(reader, sizeof(vi::common::vertex)));
+                if(mesh.vertices.size() > 0)
+                    readBytes(reader, &mesh.vertices[0], mesh.vertices.size() * sizeof(vi::common::vertex));
+
+                mesh.indices.resize(readCount(reader, sizeof(uint16_t)));
+                if(mesh.indices.size() > 0)
+                    readBytes(reader, &mesh.indices[0], mesh.indices.size() * sizeof(uint16_t));
+
+                // The replay draws the indices without any further checks, so an index outside of the vertices would read past the mesh
+                for(size_t j=0; j<mesh.indices.size() && reader.valid; j++)
+                {
+                    if(mesh.indices[j] >= mesh.vertices.size())
+                        reader.valid = false;
+                }
+            }
+
+            count = readCount(reader, 3 * sizeof(uint32_t));
+            targets.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                targets[i].width  = readUInt(reader);
+                targets[i].height = readUInt(reader);
+                targets[i].format = readUInt(reader);
+            }
+
+            count = readCount(reader, 3 * sizeof(uint32_t));
+            cameras.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                cameras[i].size.x = readFloat(reader);
+                cameras[i].size.y = readFloat(reader);
+                cameras[i].view   = (readUInt(reader) != 0);
+            }
+
+            count = readCount(reader, sizeof(uint32_t));
+            markers.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+                markers[i] = readString(reader);
+
+            count = readCount(reader, 9 * sizeof(uint32_t));
+            lists.resize(count);
+
+            for(uint32_t i=0; i<count && reader.valid; i++)
+            {
+                traceList& list = lists[i];
+
+                list.frame  = readUInt(reader);
+                list.camera = readUInt(reader);
+                list.clearColor.r = readFloat(reader);
+                list.clearColor.g = readFloat(reader);
+                list.clearColor.b = readFloat(reader);
+                list.clearColor.a = readFloat(reader);
+
+                list.commands.resize(readCount(reader, sizeof(traceCommand)));
+                if(list.commands.size() > 0)
+                    readBytes(reader, &list.commands[0], list.commands.size() * sizeof(traceCommand));
+
+                list.uniforms.resize(readCount(reader, 49 * sizeof(uint32_t)));
+                for(size_t j=0; j<list.uniforms.size(); j++)
+                {
+                    vi::graphic::renderUniforms& uniforms = list.uniforms[j];
+
+                    readBytes(reader, uniforms.projection.matrix, 16 * sizeof(GLfloat));
+                    readBytes(reader, uniforms.view.matrix, 16 * sizeof(GLfloat));
+                    readBytes(reader, uniforms.model.matrix, 16 * sizeof(GLfloat));
+
+                    uniforms.parameterOffset = readUInt(reader);
+                    uniforms.projViewModel   = uniforms.projection * uniforms.view * uniforms.model;
+                }
+
+                list.parameterData.resize(readCount(reader, 1));
+                if(list.parameterData.size() > 0)
+                    readBytes(reader, &list.parameterData[0], list.parameterData.size());
+            }
+
+            [file release];
+
+            // Validate every index, so that replaying a damaged trace can't read out of bounds
+            for(size_t i=0; i<textures.size() && reader.valid; i++)
+            {
+                traceTexture& texture = textures[i];
+
+                if(texture.source == traceTextureSourceTarget)
+                    reader.valid = (texture.sourceIndex < targets.size());
+                else if(texture.source == traceTextureSourceCamera)
+                    reader.valid = (texture.sourceIndex < cameras.size());
+                else
+                    reader.valid = (texture.source == traceTextureSourceImage);
+            }
+
+            for(size_t i=0; i<materials.size() && reader.valid; i++)
+            {
+                traceMaterial& material = materials[i];
+                reader.valid = (material.shader < shaders.size());
+
+                for(size_t j=0; j<material.textures.size() && reader.valid; j++)
+                    reader.valid = (material.textures[j] < textures.size());
+            }
+
+            for(size_t i=0; i<lists.size() && reader.valid; i++)
+            {
+                traceList& list = lists[i];
+                reader.valid = (list.camera < cameras.size());
+
+                std::vector<traceCommand>::iterator iterator;
+                for(iterator=list.commands.begin(); iterator!=list.commands.end() && reader.valid; iterator++)
+                {
+                    traceCommand& command = *iterator;
+
+                    switch(command.type)
+                    {
+                        case renderCommandTypeSetPipeline:
+                        case renderCommandTypeBindTextures:
+                            reader.valid = (command.material < materials.size());
+                            break;
+
+                        case renderCommandTypeSetUniforms:
+                        {
+                            reader.valid = (command.material < materials.size() && command.uniforms < list.uniforms.size());
+                            if(!reader.valid)
+                                break;
+
+                            // The snapshot must contain the values of all parameters of the material
+                            std::vector<traceParameter>& parameter = materials[command.material].parameter;
+                            size_t size = 0;
+
+                            for(size_t j=0; j<parameter.size(); j++)
+                            {
+                                vi::graphic::materialParameter tparameter;
+                                tparameter.type  = (vi::graphic::materialParameterType)parameter[j].type;
+                                tparameter.count = parameter[j].count;
+                                tparameter.size  = parameter[j].size;
+
+                                size += vi::graphic::renderCommandList::parameterSize(tparameter);
+                            }
+
+                            reader.valid = (list.uniforms[command.uniforms].parameterOffset + size <= list.parameterData.size());
+                        }
+                            break;
+
+                        case renderCommandTypeDraw:
+                            reader.valid = (command.material < materials.size() && command.mesh < meshes.size() && command.first + command.count <= meshes[command.mesh].indices.size());
+                            break;
+
+                        case renderCommandTypeBeginTarget:
+                            reader.valid = (command.target < targets.size());
+                            break;
+
+                        case renderCommandTypePushMarker:
+                            reader.valid = (command.marker < markers.size());
+                            break;
+
+                        case renderCommandTypeSetDepth:
+                            reader.valid = (command.depthMode <= renderDepthModeTest);
+                            break;
+
+                        default:
+                            reader.valid = (command.type <= renderCommandTypeSetDepth);
+                            break;
+                    }
+                }
+            }
+
+            if(!reader.valid)
+            {
+                ViLog(@"The render trace %s is damaged!", path.c_str());
+                clear();
+
+                return false;
+            }
+
+            return true;
+        }
+
+
+
+        void renderTrace::createResources()
+        {
+            if(prepared)
+                return;
+
+            vi::common::context *context = vi::common::context::getActiveContext();
+            assert(context);
+
+            for(size_t i=0; i<targets.size(); i++)
+                replayTargets.push_back(vi::graphic::renderTarget::acquireRenderTarget(targets[i].width, targets[i].height, targets[i].format));
+
+            // View cameras are replayed into textures with the size of the view in pixels
+            for(size_t i=0; i<cameras.size(); i++)
+            {
+                vi::common::vector2 size = cameras[i].view ? cameras[i].size * scaleFactor : cameras[i].size;
+                replayCameras.push_back(new vi::scene::camera(NULL, size));
+            }
+
+            for(size_t i=0; i<textures.size(); i++)
+            {
+                traceTexture& ttexture = textures[i];
+
+                switch(ttexture.source)
+                {
+                    case traceTextureSourceTarget:
+                        replayTextures.push_back(replayTargets[ttexture.sourceIndex]->getTexture());
+                        break;
+
+                    case traceTextureSourceCamera:
+                        replayTextures.push_back(replayCameras[ttexture.sourceIndex]->getTexture());
+                        break;
+
+                    default:
+                    {
+                        uint32_t width  = (uint32_t)lroundf(ttexture.width * ttexture.scaleFactor);
+                        uint32_t height = (uint32_t)lroundf(ttexture.height * ttexture.scaleFactor);
+
+                        vi::graphic::texture *texture = new vi::graphic::texture(-1, width, height);
+                        texture->width  = ttexture.width;
+                        texture->height = ttexture.height;
+                        texture->scaleFactor   = ttexture.scaleFactor;
+                        texture->containsAlpha = ttexture.alpha;
+
+                        // Textures without pixels are replayed in white, so that the same number of pixels is blended
+                        if(ttexture.pixels.size() == (size_t)width * height * 4)
+                            texture->pixelData = ttexture.pixels;
+                        else
+                            texture->pixelData.assign((size_t)width * height * 4, 255);
+
+                        if(width > 0 && height > 0)
+                        {
+                            glBindTexture(GL_TEXTURE_2D, texture->getTexture());
+                            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &texture->pixelData[0]);
+                        }
+
+                        replayTextures.push_back(texture);
+                    }
+                        break;
+                }
+            }
+
+            for(size_t i=0; i<shaders.size(); i++)
+            {
+                vi::graphic::shader *shader = NULL;
+
+                try
+                {
+                    shader = new vi::graphic::shader(shaders[i].vertexFile, shaders[i].fragmentFile);
+                }
+                catch(const char *error)
+                {
+                    ViLog(@"Couldn't create shader %s, %s for the render trace, using the default shader instead.", shaders[i].vertexFile.c_str(), shaders[i].fragmentFile.c_str());
+                    shader = NULL;
+                }
+
+                replayShaders.push_back(shader);
+            }
+
+            for(size_t i=0; i<materials.size(); i++)
+            {
+                traceMaterial& tmaterial = materials[i];
+
+                vi::graphic::shader *shader = replayShaders[tmaterial.shader];
+                vi::graphic::material *material = new vi::graphic::material(NULL, shader ? shader : context->getShader(vi::graphic::defaultShaderTexture));
+
+                material->drawMode = tmaterial.drawMode;
+                material->culling  = tmaterial.culling;
+                material->cullMode = tmaterial.cullMode;
+                material->blending = tmaterial.blending;
+                material->blendSource      = tmaterial.blendSource;
+                material->blendDestination = tmaterial.blendDestination;
+                material->texlocations     = tmaterial.texlocations;
+
+                for(size_t j=0; j<tmaterial.textures.size(); j++)
+                    material->textures.push_back(replayTextures[tmaterial.textures[j]]);
+
+                // The backends read the values from the uniform snapshots, the storage only has to exist
+                size_t size = 0;
+                for(size_t j=0; j<tmaterial.parameter.size(); j++)
+                {
+                    vi::graphic::materialParameter parameter;
+                    parameter.type  = (vi::graphic::materialParameterType)tmaterial.parameter[j].type;
+                    parameter.count = tmaterial.parameter[j].count;
+                    parameter.size  = tmaterial.parameter[j].size;
+
+                    size += vi::graphic::renderCommandList::parameterSize(parameter);
+                }
+
+                replayParameterData.push_back(std::vector<uint8_t>(MAX(size, 1)));
+
+                size_t offset = 0;
+                for(size_t j=0; j<tmaterial.parameter.size(); j++)
+                {
+                    traceParameter& tparameter = tmaterial.parameter[j];
+                    vi::graphic::materialParameterType type = (vi::graphic::materialParameterType)tparameter.type;
+
+                    if(!material->addParameter(tparameter.name, &replayParameterData.back()[offset], type, tparameter.count, tparameter.size))
+                        ViLog(@"Couldn't find the parameter %s of a render trace material, the replay won't match the recording.", tparameter.name.c_str());
+
+                    vi::graphic::materialParameter parameter;
+                    parameter.type  = type;
+                    parameter.count = tparameter.count;
+                    parameter.size  = tparameter.size;
+
+                    offset += vi::graphic::renderCommandList::parameterSize(parameter);
+                }
+
+                replayMaterials.push_back(material);
+            }
+
+            for(size_t i=0; i<meshes.size(); i++)
+            {
+                traceMesh& tmesh = meshes[i];
+                vi::common::mesh *mesh = new vi::common::mesh((uint32_t)tmesh.vertices.size(), (uint32_t)tmesh.indices.size());
+
+                if(tmesh.vertices.size() > 0)
+                    memcpy(mesh->getVertices(), &tmesh.vertices[0], tmesh.vertices.size() * sizeof(vi::common::vertex));
+
+                if(tmesh.indices.size() > 0)
+                    memcpy(mesh->getIndices(), &tmesh.indices[0], tmesh.indices.size() * sizeof(uint16_t));
+
+                mesh->vertexCount = (uint32_t)tmesh.vertices.size();
+                mesh->indexCount  = (uint32_t)tmesh.indices.size();
+                mesh->setVertexFormat((vi::common::vertexFormat)tmesh.format);
+
+                if(tmesh.vbo)
+                    mesh->generateVBO(tmesh.dynamic);
+
+                replayMeshes.push_back(mesh);
+            }
+
+            prepared = true;
+        }
+
+        void renderTrace::releaseResources()
+        {
+            if(!prepared)
+                return;
+
+            for(size_t i=0; i<textures.size(); i++)
+            {
+                if(textures[i].source == traceTextureSourceImage)
+                    delete replayTextures[i];
+            }
+
+            for(size_t i=0; i<replayMaterials.size(); i++)
+                delete replayMaterials[i];
+
+            for(size_t i=0; i<replayShaders.size(); i++)
+                delete replayShaders[i];
+
+            for(size_t i=0; i<replayMeshes.size(); i++)
+                delete replayMeshes[i];
+
+            for(size_t i=0; i<replayCameras.size(); i++)
+                delete replayCameras[i];
+
+            for(size_t i=0; i<replayTargets.size(); i++)
+                vi::graphic::renderTarget::releaseRenderTarget(replayTargets[i]);
+
+            replayTextures.clear();
+            replayShaders.clear();
+            replayMaterials.clear();
+            replayParameterData.clear();
+            replayMeshes.clear();
+            replayCameras.clear();
+            replayTargets.clear();
+
+            prepared = false;
+        }
+
+
+
+        double renderTrace::replay(vi::graphic::commandRenderer *renderer, std::vector<vi::graphic::renderTraceTiming> *timings)
+        {
+            createResources();
+
+            // The replayed cameras render into textures that already have the size in pixels
+            vi::common::kernel *kernel = vi::common::kernel::sharedKernel();
+            float kernelScaleFactor = kernel ? kernel->scaleFactor : 1.0f;
+
+            if(kernel)
+                kernel->scaleFactor = 1.0f;
+
+            std::vector<double> drawTimes;
+            double time = 0.0;
+
+            for(size_t i=0; i<lists.size(); i++)
+            {
+                traceList& list = lists[i];
+
+                replayList.reset();
+                replayList.uniforms      = list.uniforms;
+                replayList.parameterData = list.parameterData;
+
+                std::vector<traceCommand>::iterator iterator;
+                for(iterator=list.commands.begin(); iterator!=list.commands.end(); iterator++)
+                {
+                    traceCommand& tcommand = *iterator;
+                    vi::graphic::renderCommand command;
+                    memset(&command, 0, sizeof(renderCommand));
+
+                    command.type      = (vi::graphic::renderCommandType)tcommand.type;
+                    command.depthMode = (vi::graphic::renderDepthMode)tcommand.depthMode;
+                    command.first     = tcommand.first;
+                    command.count     = tcommand.count;
+                    command.uniforms  = tcommand.uniforms;
+                    command.material  = (tcommand.material < replayMaterials.size()) ? replayMaterials[tcommand.material] : NULL;
+                    command.mesh      = (tcommand.mesh < replayMeshes.size()) ? replayMeshes[tcommand.mesh] : NULL;
+                    command.target    = (tcommand.target < replayTargets.size()) ? replayTargets[tcommand.target] : NULL;
+                    command.debugName = (tcommand.marker < markers.size()) ? markers[tcommand.marker].c_str() : NULL;
+
+                    replayList.commands.push_back(command);
+                }
+
+                vi::scene::camera *camera = replayCameras[list.camera];
+                camera->clearColor = list.clearColor;
+
+                drawTimes.clear();
+                renderer->drawTimes = timings ? &drawTimes : NULL;
+
+                double timestamp = vi::graphic::frameStats::timestamp();
+                renderer->executeCommandList(&replayList, camera);
+                time += vi::graphic::frameStats::timestamp() - timestamp;
+
+                renderer->drawTimes = NULL;
+
+                if(!timings)
+                    continue;
+
+                size_t draw = 0;
+                for(size_t j=0; j<list.commands.size() && draw<drawTimes.size(); j++)
+                {
+                    if(list.commands[j].type != renderCommandTypeDraw)
+                        continue;
+
+                    vi::graphic::renderTraceTiming timing;
+                    timing.frame   = list.frame;
+                    timing.list    = (uint32_t)i;
+                    timing.command = (uint32_t)j;
+                    timing.indices = list.commands[j].count;
+                    timing.time    = drawTimes[draw ++];
+
+                    timings->push_back(timing);
+                }
+            }
+
+            if(kernel)
+                kernel->scaleFactor = kernelScaleFactor;
+
+            return time;
+        }
+
+
+
+        uint32_t renderTrace::getFrameCount()
+        {
+            return frameCount;
+        }
+
+        uint32_t renderTrace::getListCount()
+        {
+            return (uint32_t)lists.size();
+        }
+
+        uint32_t renderTrace::getGLSLVersion()
+        {
+            return glslVersion;
+        }
+
+        float renderTrace::getScaleFactor()
+        {
+            return scaleFactor;
+        }
+    }
+}
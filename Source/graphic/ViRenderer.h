@@ -11,6 +11,7 @@
 #import "ViMaterial.h"
 #import "ViShader.h"
 #import "ViCamera.h"
+#import "ViFrameStats.h"
 
 namespace vi
 {
@@ -45,6 +46,23 @@ namespace vi
              * function.
              **/
             virtual void renderSceneWithCamera(vi::scene::scene *scene, vi::scene::camera *camera, double timestep) = 0;
+            
+            /**
+             * Returns the statistics of the frame that is currently rendered. Renderers are expected to fill in what they can measure, the kernel resets
+             * the stats at the beginning of every frame.
+             **/
+            vi::graphic::frameStats *getFrameStats() { return &stats; }
+            
+            /**
+             * Invoked by the kernel after all cameras of a frame were rendered.
+             **/
+            virtual void finishFrame() {};
+            
+        protected:
+            /**
+             * The statistics of the current frame
+             **/
+            vi::graphic::frameStats stats;
         };
     }
 }
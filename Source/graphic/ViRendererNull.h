@@ -0,0 +1,53 @@
+//
+//  ViRendererNull.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViBase.h"
+#import "ViCommandRenderer.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief Renderer that records commands without drawing anything
+         *
+         * The null renderer traverses the scene and generates the command list like every other renderer, but never touches the GPU and never binds
+         * the camera. It can be used to measure the CPU cost of a frame, to inspect the generated commands via getCommandList() or to run a scene
+         * without a window.
+         **/
+        class rendererNull : public commandRenderer
+        {
+        public:
+            /**
+             * Constructor
+             **/
+            rendererNull();
+            
+            /**
+             * Returns the number of draw commands that were recorded, same as the drawCalls of getFrameStats().
+             * @remark The kernel resets the stats at the beginning of every frame, without a kernel they are only reset by resetStatistics().
+             **/
+            uint32_t getDrawCount();
+            /**
+             * Returns the number of commands that were recorded, same as the commands of getFrameStats().
+             * @remark The kernel resets the stats at the beginning of every frame, without a kernel they are only reset by resetStatistics().
+             **/
+            uint32_t getCommandCount();
+            /**
+             * Resets the stats returned by getFrameStats().
+             **/
+            void resetStatistics();
+            
+        protected:
+            /**
+             * Counts the commands of the list.
+             **/
+            virtual void executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera);
+        };
+    }
+}
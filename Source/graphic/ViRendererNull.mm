@@ -0,0 +1,52 @@
+//
+//  ViRendererNull.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViRendererNull.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        rendererNull::rendererNull()
+        {
+        }
+        
+        
+        void rendererNull::executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera)
+        {
+            std::vector<vi::graphic::renderCommand>::iterator iterator;
+            for(iterator=list->commands.begin(); iterator!=list->commands.end(); iterator++)
+            {
+                vi::graphic::renderCommand& command = *iterator;
+                
+                if(command.type == renderCommandTypeDraw)
+                {
+                    stats.drawCalls ++;
+                    stats.vertices += renderCommandList::drawnVertices(command.mesh, command.first, command.count);
+                    stats.indices  += command.count;
+                }
+            }
+        }
+        
+        
+        uint32_t rendererNull::getDrawCount()
+        {
+            return stats.drawCalls;
+        }
+        
+        uint32_t rendererNull::getCommandCount()
+        {
+            return stats.commands;
+        }
+        
+        void rendererNull::resetStatistics()
+        {
+            stats.reset();
+        }
+    }
+}
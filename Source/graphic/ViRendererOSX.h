@@ -8,11 +8,12 @@
 
 #include <vector>
 #import "ViBase.h"
-#import "ViRenderer.h"
+#import "ViCommandRenderer.h"
 #import "ViScene.h"
 #import "ViCamera.h"
 #import "ViMesh.h"
 #import "ViVector3.h"
+#import "ViContext.h"
 
 namespace vi
 {
@@ -22,40 +23,99 @@ namespace vi
         typedef void (*viUniformFv)(GLint, GLsizei, const GLfloat *);
         typedef void (*viUniformMatrixFv)(GLint, GLsizei, GLboolean, const GLfloat *);
         
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            GLint framebuffer;
+            GLint viewport[4];
+        } renderTargetState;
+        
+        typedef struct
+        {
+            vi::common::context *context;
+            
+            GLuint vao;
+            GLuint vbo, ivbo;
+            GLuint attributeBuffer;
+            uint32_t attributes;
+        } streamVertexArray;
+        /**
+         * @endcond
+         **/
+        
         /**
          * @brief Mac OS X and iOS shader based renderer
          *
-         * A shader based renderer capable of rendering under OpenGL 2.x, 3.2 and OpenGL ES 2.0
+         * A shader based renderer capable of rendering under OpenGL 2.x, 3.2 and OpenGL ES 2.0. The renderer executes the command lists generated by
+         * vi::graphic::commandRenderer and filters out redundant state changes.
+         * On OpenGL 2.x contexts on Mac OS X that support EXT_timer_query, the GPU time of every frame is measured with a single query that brackets all
+         * of its cameras, the result is reported a few frames later in vi::graphic::frameStats::gpuTime. There is no GPU timing on 3.2 core profile
+         * contexts and on iOS.
          **/
-        class rendererOSX : public renderer
+        class rendererOSX : public commandRenderer
         {
         public:
             /**
              * Constructor
              **/
             rendererOSX();
+            /**
+             * Destructor, deletes the timer queries and the buffers that meshes without VBOs are streamed through.
+             **/
+            virtual ~rendererOSX();
             
+        protected:
             /**
-             * Renders the given scene with the given camera. See vi::graphic::renderer for more details.
+             * Binds the camera and executes the given command list using OpenGL.
              **/
-            virtual void renderSceneWithCamera(vi::scene::scene *scene, vi::scene::camera *camera, double timestep);
+            virtual void executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera);
+            /**
+             * Ends the timer query that measures the GPU time of the frame and reads back the results of earlier frames that are available.
+             **/
+            virtual void finishFrame();
             
         private:
-            void renderNodeList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes);
-            void renderBatchList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes, vi::scene::sceneNode *parent);
-            void renderNode(vi::scene::sceneNode *node, bool isUINode);
-            void renderMesh(vi::common::mesh *mesh, bool isUIMesh, vi::common::matrix4x4 const& matrix);
-            void setMaterial(vi::graphic::material *material);
+            void setPipeline(vi::graphic::material *material);
+            void setDepth(vi::graphic::renderDepthMode mode);
+            void bindTextures(vi::graphic::material *material);
+            void setUniforms(vi::graphic::material *material, vi::graphic::renderUniforms const& uniforms, const uint8_t *parameterData);
+            void drawMesh(vi::graphic::material *material, vi::common::mesh *mesh, uint32_t first, uint32_t count);
+            
+            void bindVertexArray(GLuint vao);
+            void bindMeshVertexArray(vi::common::mesh *mesh, vi::graphic::shader *shader);
+            void bindStreamVertexArray(vi::common::mesh *mesh, vi::graphic::material *material);
+            void bindMeshAttributes(vi::common::mesh *mesh, vi::graphic::material *material);
+            void setEnabledAttributes(uint32_t attributes, uint32_t& enabled);
+            void setVertexPointers(vi::common::mesh *mesh, vi::graphic::shader *shader, const GLubyte *base);
+            void collectTimerQueries();
             
             viUniformIv uniformIvFuncs[4];
             viUniformFv uniformFvFuncs[4];
             viUniformMatrixFv uniformMatrixFvFuncs[3];
             
-            vi::scene::camera *currentCamera;
-            vi::graphic::material *currentMaterial;
-            vi::common::vector3 translation;
+            vi::graphic::material *boundMaterial;
             vi::common::mesh *lastMesh;
-            vi::common::mesh *batchMesh;
+            vi::graphic::shader *lastShader;
+            bool lastStreamed;
+            GLuint currentProgram;
+            
+            vi::common::context *currentContext;
+            bool useVertexArrays;
+            GLuint boundVertexArray;
+            uint32_t enabledAttributes;
+            
+            std::vector<streamVertexArray> streamArrays;
+            
+            std::vector<renderTargetState> targetStack;
+            
+            bool useTimerQueries;
+            bool measuringFrame;
+            GLuint timerQueries[4];
+            uint32_t timerQueryFrames[4];
+            bool timerQueryPending[4];
+            uint32_t timerQueryIndex;
         };
     }
 }
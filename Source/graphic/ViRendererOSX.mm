@@ -17,12 +17,57 @@ namespace vi
 {
     namespace graphic
     {
+        GLsizeiptr attributeDataSize(vi::graphic::vertexAttribute const& attribute, uint32_t vertexCount);
+        GLsizeiptr attributeDataSize(vi::graphic::vertexAttribute const& attribute, uint32_t vertexCount)
+        {
+            if(vertexCount == 0)
+                return 0;
+            
+            GLsizei element = attribute.size;
+            switch(attribute.type)
+            {
+                case GL_BYTE:
+                case GL_UNSIGNED_BYTE:
+                    break;
+                    
+                case GL_SHORT:
+                case GL_UNSIGNED_SHORT:
+                    element *= 2;
+                    break;
+                    
+                default:
+                    element *= 4;
+                    break;
+            }
+            
+            GLsizei stride = (attribute.stride > 0) ? attribute.stride : element;
+            return stride * (vertexCount - 1) + element;
+        }
+        
+        
         rendererOSX::rendererOSX()
         {
             lastMesh        = NULL;
-            currentCamera   = NULL;
-            currentMaterial = NULL;
-            batchMesh       = new vi::common::mesh(128 * 4, 128 * 6);
+            lastShader      = NULL;
+            lastStreamed    = false;
+            boundMaterial   = NULL;
+            currentContext  = NULL;
+            currentProgram  = 0;
+            
+            useVertexArrays   = false;
+            boundVertexArray  = 0;
+            enabledAttributes = 0;
+            
+            useTimerQueries = false;
+            measuringFrame  = false;
+            timerQueryIndex = 0;
+            
+            for(int i=0; i<4; i++)
+            {
+                timerQueries[i] = 0;
+                timerQueryFrames[i]  = 0;
+                timerQueryPending[i] = false;
+            }
             
             uniformIvFuncs[0] = glUniform1iv;
             uniformIvFuncs[1] = glUniform2iv;
@@ -39,386 +84,688 @@ namespace vi
             uniformMatrixFvFuncs[2] = glUniformMatrix4fv;
         }
         
-       
-        
-        void rendererOSX::renderSceneWithCamera(vi::scene::scene *scene, vi::scene::camera *camera, double timestep)
+        rendererOSX::~rendererOSX()
         {
-            camera->bind();            
-            currentCamera = camera;
-            
-            std::vector<vi::scene::sceneNode *> *nodes = scene->nodesInRect(camera->frame);
-            this->renderNodeList(nodes, timestep, false);
-            this->renderNodeList(scene->UINodes(), timestep, true);
+#ifdef ViTimerQueries
+            if(timerQueries[0] != 0)
+                glDeleteQueries(4, timerQueries);
+#endif
             
-            camera->unbind();
+#ifdef ViVertexArrayObjects
+            std::vector<streamVertexArray>::iterator iterator;
+            for(iterator=streamArrays.begin(); iterator!=streamArrays.end(); iterator++)
+            {
+                streamVertexArray& stream = *iterator;
+                
+                glDeleteVertexArrays(1, &stream.vao);
+                glDeleteBuffers(1, &stream.vbo);
+                glDeleteBuffers(1, &stream.ivbo);
+                glDeleteBuffers(1, &stream.attributeBuffer);
+            }
+#endif
         }
         
-        void rendererOSX::renderBatchList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes, vi::scene::sceneNode *parent)
-        {
-            vi::common::vector2 tsize = parent->getSize();
-        
-            batchMesh->vertexCount  = 0;
-            batchMesh->indexCount   = 0;
+       
         
-            std::vector<vi::scene::sceneNode *>::iterator iterator;
+        void rendererOSX::executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera)
+        {
+            camera->bind();
             
-            for(iterator=nodes->begin(); iterator!=nodes->end(); iterator++)
+            vi::common::context *context = vi::common::context::getActiveContext();
+            if(context != currentContext)
             {
-                vi::scene::sceneNode *node = *iterator;
+                // Vertex array objects and the enabled attribute arrays are per context state, so forget everything we know about the old one
+                currentContext    = context;
+                boundVertexArray  = 0;
+                enabledAttributes = 0;
+                currentProgram    = 0;
+                boundMaterial     = NULL;
+                lastMesh   = NULL;
+                lastShader = NULL;
+                lastStreamed = false;
                 
-                if(node->noPass == currentCamera)
-                    continue;
+#ifdef ViVertexArrayObjects
+                useVertexArrays = (context && context->getGLSLVersion() >= 150);
+#endif
                 
-                if(!uiNodes && node->getSize().length() > kViEpsilonFloat)
+#ifdef ViTimerQueries
+                // The extension string can't be queried with glGetString() on a core profile context
+                useTimerQueries = (context && context->getGLSLVersion() < 150 && vi::common::kernel::checkOpenGLExtension("GL_EXT_timer_query"));
+                
+                if(timerQueries[0] != 0)
                 {
-                    if(!vi::common::rect(node->getPosition(), node->getSize()).intersectsRect(currentCamera->frame))
-                        continue;
+                    // Query objects aren't shared between contexts
+                    glDeleteQueries(4, timerQueries);
+                    
+                    for(int i=0; i<4; i++)
+                        timerQueries[i] = 0;
                 }
-            
                 
-                node->visit(timestep);
+                // A query that was started on the old context can't be ended on this one, the frame just isn't measured
+                measuringFrame  = false;
+                timerQueryIndex = 0;
                 
-                vi::common::vector2 position = node->getPosition();
-                position.y = -position.y;
-                position.y += tsize.y - node->getSize().y;
-                
-                batchMesh->addMesh(node->mesh, position);
+                if(useTimerQueries)
+                {
+                    glGenQueries(4, timerQueries);
+                    
+                    for(int i=0; i<4; i++)
+                        timerQueryPending[i] = false;
+                }
+#endif
+            }
+            
+#ifdef ViTimerQueries
+            // A single query brackets all cameras of the frame, it is started by the first one and ended in finishFrame(). If all queries of the
+            // ring are still in flight, the GPU is lagging behind and the frame simply isn't measured
+            if(useTimerQueries && !measuringFrame && !timerQueryPending[timerQueryIndex])
+            {
+                glBeginQuery(GL_TIME_ELAPSED_EXT, timerQueries[timerQueryIndex]);
                 
+                timerQueryFrames[timerQueryIndex] = stats.frame;
+                measuringFrame = true;
+            }
+#endif
+            
+            std::vector<vi::graphic::renderCommand>::iterator iterator;
+            for(iterator=list->commands.begin(); iterator!=list->commands.end(); iterator++)
+            {
+                vi::graphic::renderCommand& command = *iterator;
                 
-                if(node->hasChilds())
+                switch(command.type)
                 {
-                    vi::graphic::material *material = currentMaterial;
-                    vi::common::vector2 nodePos = node->getPosition();
-                    
-                    translation += nodePos;
-                    
-                    if(node->getFlags() & vi::scene::sceneNodeFlagConcatenateChildren)
+                    case renderCommandTypeSetPipeline:
+                        setPipeline(command.material);
+                        break;
+                        
+                    case renderCommandTypeBindTextures:
+                        bindTextures(command.material);
+                        break;
+                        
+                    case renderCommandTypeSetUniforms:
+                    {
+                        vi::graphic::renderUniforms& uniforms = list->uniforms[command.uniforms];
+                        setUniforms(command.material, uniforms, list->parameterData.empty() ? NULL : &list->parameterData[0] + uniforms.parameterOffset);
+                    }
+                        break;
+                        
+                    case renderCommandTypeDraw:
                     {
-                        renderBatchList(node->getChilds(), timestep, uiNodes, node);
+                        if(drawTimes)
+                        {
+                            glFinish();
+                            
+                            double timestamp = vi::graphic::frameStats::timestamp();
+                            drawMesh(command.material, command.mesh, command.first, command.count);
+                            glFinish();
+                            
+                            drawTimes->push_back(vi::graphic::frameStats::timestamp() - timestamp);
+                            break;
+                        }
+                        
+                        drawMesh(command.material, command.mesh, command.first, command.count);
                     }
-                    else
+                        break;
+                        
+                    case renderCommandTypeBeginTarget:
                     {
-                        renderNodeList(node->getChilds(), timestep, uiNodes);
+                        renderTargetState state;
+                        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &state.framebuffer);
+                        glGetIntegerv(GL_VIEWPORT, state.viewport);
+                        
+                        targetStack.push_back(state);
+                        
+                        glBindFramebuffer(GL_FRAMEBUFFER, command.target->getFramebuffer());
+                        glViewport(0, 0, command.target->getWidth(), command.target->getHeight());
+                        
+                        glClearColor(0.0, 0.0, 0.0, 0.0);
+                        glClear(GL_COLOR_BUFFER_BIT);
                     }
-                    
-                    translation -= nodePos;
-                    setMaterial(material);
+                        break;
+                        
+                    case renderCommandTypeEndTarget:
+                    {
+                        if(targetStack.size() == 0)
+                            break;
+                        
+                        renderTargetState state = targetStack.back();
+                        targetStack.pop_back();
+                        
+                        glBindFramebuffer(GL_FRAMEBUFFER, state.framebuffer);
+                        glViewport(state.viewport[0], state.viewport[1], state.viewport[2], state.viewport[3]);
+                    }
+                        break;
+                        
+                    case renderCommandTypeClearDepth:
+                        glDepthMask(GL_TRUE);
+                        glClear(GL_DEPTH_BUFFER_BIT);
+                        break;
+                        
+                    case renderCommandTypeSetDepth:
+                        setDepth(command.depthMode);
+                        break;
+                        
+                    case renderCommandTypePushMarker:
+#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 5
+                        if(glPushGroupMarkerEXT)
+                            glPushGroupMarkerEXT(0, command.debugName);
+#endif
+                        break;
+                        
+                    case renderCommandTypePopMarker:
+#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 5
+                        if(glPopGroupMarkerEXT)
+                            glPopGroupMarkerEXT();
+#endif
+                        break;
+                        
+                    default:
+                        break;
                 }
             }
             
-            renderMesh(batchMesh, uiNodes, parent->matrix);
+            // Don't leak a bound vertex array object, otherwise buffer bindings made outside of the renderer would end up in it.
+            bindVertexArray(0);
+            
+            camera->unbind();
         }
         
-        void rendererOSX::renderNodeList(std::vector<vi::scene::sceneNode *> *nodes, double timestep, bool uiNodes)
+        void rendererOSX::finishFrame()
         {
-            std::vector<vi::scene::sceneNode *>::iterator iterator;
-            
-            for(iterator=nodes->begin(); iterator!=nodes->end(); iterator++)
+#ifdef ViTimerQueries
+            if(measuringFrame)
             {
-                vi::scene::sceneNode *node = *iterator;
+                glEndQuery(GL_TIME_ELAPSED_EXT);
                 
-                if(node->noPass == currentCamera)
+                timerQueryPending[timerQueryIndex] = true;
+                timerQueryIndex = (timerQueryIndex + 1) % 4;
+                measuringFrame  = false;
+            }
+            
+            if(useTimerQueries)
+                collectTimerQueries();
+#endif
+            
+            commandRenderer::finishFrame();
+        }
+        
+        void rendererOSX::collectTimerQueries()
+        {
+#ifdef ViTimerQueries
+            // The slot after the last used one holds the oldest query, and queries finish in the order they were issued
+            for(int i=0; i<4; i++)
+            {
+                uint32_t index = (timerQueryIndex + i) % 4;
+                if(!timerQueryPending[index])
                     continue;
                 
+                GLint available = 0;
+                glGetQueryObjectiv(timerQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
                 
-                if(node->getSize().length() > kViEpsilonFloat)
-                {
-                    if(!vi::common::rect(node->getPosition(), node->getSize()).intersectsRect(currentCamera->frame) && !uiNodes)
-                        continue;
-                }
-
-#ifndef NDEBUG
-#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 5
-                if(glPushGroupMarkerEXT)
-                    glPushGroupMarkerEXT(0, node->debugName ? node->debugName->c_str() : "scene node");
-#endif
-#endif
-                
-                node->visit(timestep);
+                if(!available)
+                    break;
                 
-                this->setMaterial(node->material);
-                this->renderNode(node, uiNodes);
+                GLuint64EXT elapsed = 0;
+                glGetQueryObjectui64vEXT(timerQueries[index], GL_QUERY_RESULT, &elapsed);
                 
-                if(node->hasChilds())
-                {
-                    vi::common::vector2 nodePos = node->getPosition();
-                    translation += nodePos;
-                    
-                    if(node->getFlags() & vi::scene::sceneNodeFlagConcatenateChildren)
-                    {
-                        renderBatchList(node->getChilds(), timestep, uiNodes, node);
-                    }
-                    else
-                    {
-                        renderNodeList(node->getChilds(), timestep, uiNodes);
-                    }
-                    
-                    translation -= nodePos;
-                }
+                // Each query measured a whole frame, so only the newest result is reported
+                stats.gpuTime  = elapsed * 1e-9;
+                stats.gpuFrame = timerQueryFrames[index];
+                stats.gpuTimeAvailable = true;
                 
-#ifndef NDEBUG
-#if __IPHONE_OS_VERSION_MAX_ALLOWED >= 5
-                if(glPopGroupMarkerEXT)
-                    glPopGroupMarkerEXT();
-#endif
-#endif
+                timerQueryPending[index] = false;
             }
+#endif
         }
         
-        void rendererOSX::renderNode(vi::scene::sceneNode *node, bool isUINode)
-        {
-            if(!node->mesh)
-                return;
-            
-            renderMesh(node->mesh, isUINode, node->matrix);
-        }
         
-        void rendererOSX::renderMesh(vi::common::mesh *mesh, bool isUIMesh, vi::common::matrix4x4 const& matrix)
+        
+        void rendererOSX::setPipeline(vi::graphic::material *material)
         {
-            vi::common::matrix4x4 cameraMatrix = !isUIMesh ? currentCamera->viewMatrix : vi::common::matrix4x4();
-            
-            if(isUIMesh)
-                cameraMatrix.makeTranslate(vi::common::vector3(0.0, currentCamera->frame.size.y, 0.0));
-            
-            
-            vi::common::matrix4x4 nodeMatrix = matrix;
-            if(translation.length() >= kViEpsilonFloat)
-                nodeMatrix.translate(vi::common::vector3(translation.x, -translation.y, 0.0));
-            
-            
-            if(currentMaterial->shader->matProj != -1)
-				glUniformMatrix4fv(currentMaterial->shader->matProj, 1, GL_FALSE, currentCamera->projectionMatrix.matrix);
-            
-            if(currentMaterial->shader->matView != -1)
-                glUniformMatrix4fv(currentMaterial->shader->matView, 1, GL_FALSE, cameraMatrix.matrix);
-			
-            if(currentMaterial->shader->matModel != -1)
-                glUniformMatrix4fv(currentMaterial->shader->matModel, 1, GL_FALSE, nodeMatrix.matrix);
-            
-            if(currentMaterial->shader->matProjViewModel != -1)
+            if(currentProgram != material->shader->program)
             {
-                vi::common::matrix4x4 matProjViewModel = currentCamera->projectionMatrix * cameraMatrix * nodeMatrix;
-                glUniformMatrix4fv(currentMaterial->shader->matProjViewModel, 1, GL_FALSE, matProjViewModel.matrix);
+                glUseProgram(material->shader->program);
+                currentProgram = material->shader->program;
+                
+                stats.programSwitches ++;
             }
             
+            if(!boundMaterial || boundMaterial->culling != material->culling || boundMaterial->cullMode != material->cullMode)
+            {
+                if(material->culling)
+                {
+                    glEnable(GL_CULL_FACE);
+                    glFrontFace(material->cullMode);
+                }
+                else
+                    glDisable(GL_CULL_FACE);
+            }
             
-            do {
-                std::vector<vi::graphic::materialParameter>::iterator iterator;
-                for(iterator=currentMaterial->parameter.begin(); iterator!=currentMaterial->parameter.end(); iterator++)
+            if(!boundMaterial || (boundMaterial->blending != material->blending || boundMaterial->blendSource != material->blendSource || boundMaterial->blendDestination != material->blendDestination))
+            {
+                if(material->blending)
                 {
-                    vi::graphic::materialParameter parameter = *iterator;
-                    
-                    switch(parameter.type)
-                    {
-                        case vi::graphic::materialParameterTypeInt:
-                        {
-                            uniformIvFuncs[parameter.count - 1](parameter.location, parameter.size, (const GLint *)parameter.data);
-                        }
-                            break;
-                            
-                        case vi::graphic::materialParameterTypeFloat:
-                        {
-                            uniformFvFuncs[parameter.count - 1](parameter.location, parameter.size, (const GLfloat *)parameter.data);
-                        }
-                            break;
-                            
-                        case vi::graphic::materialParameterTypeMatrix:
-                        {
-                            uniformMatrixFvFuncs[parameter.count - 2](parameter.location, parameter.size, GL_FALSE, (const GLfloat *)parameter.data);
-                        }
-                            break;
-                            
-                        default:
-                            break;
-                    }
+                    glEnable(GL_BLEND);
+                    glBlendFunc(material->blendSource, material->blendDestination);
                 }
+                else
+                    glDisable(GL_BLEND);
             }
-            while(0);
             
-            do {
-                std::vector<vi::graphic::vertexAttribute>::iterator iterator;
-                for(iterator=currentMaterial->attributes.begin(); iterator!=currentMaterial->attributes.end(); iterator++)
+            boundMaterial = material;
+        }
+        
+        void rendererOSX::setDepth(vi::graphic::renderDepthMode mode)
+        {
+            switch(mode)
+            {
+                case renderDepthModeWrite:
+                    glEnable(GL_DEPTH_TEST);
+                    glDepthFunc(GL_LEQUAL);
+                    glDepthMask(GL_TRUE);
+                    break;
+                    
+                case renderDepthModeTest:
+                    glEnable(GL_DEPTH_TEST);
+                    glDepthFunc(GL_LEQUAL);
+                    glDepthMask(GL_FALSE);
+                    break;
+                    
+                default:
+                    glDisable(GL_DEPTH_TEST);
+                    glDepthMask(GL_TRUE);
+                    break;
+            }
+        }
+        
+        void rendererOSX::bindTextures(vi::graphic::material *material)
+        {
+            if(material->textures.size() > 0)
+            {
+                for(int i=0; i<material->texlocations.size(); i++)
                 {
-                    vi::graphic::vertexAttribute attribute = *iterator;
+                    if(material->texlocations[i] == -1)
+                        break;
                     
-                    glEnableVertexAttribArray(attribute.location);
-                    glVertexAttribPointer(attribute.location, attribute.size, attribute.type, 0, attribute.stride, attribute.data);
+                    glActiveTexture(GL_TEXTURE0 + i);
+                    glBindTexture(material->textures[i]->getTarget(), material->textures[i]->getTexture());
+                    
+                    stats.textureBinds ++;
                 }
-            } 
-            while(0);
+            }
+        }
+        
+        void rendererOSX::setUniforms(vi::graphic::material *material, vi::graphic::renderUniforms const& uniforms, const uint8_t *parameterData)
+        {
+            vi::graphic::shader *shader = material->shader;
             
+            if(shader->matProj != -1)
+            {
+				glUniformMatrix4fv(shader->matProj, 1, GL_FALSE, uniforms.projection.matrix);
+                stats.uniformUploads ++;
+            }
             
+            if(shader->matView != -1)
+            {
+                glUniformMatrix4fv(shader->matView, 1, GL_FALSE, uniforms.view.matrix);
+                stats.uniformUploads ++;
+            }
+			
+            if(shader->matModel != -1)
+            {
+                glUniformMatrix4fv(shader->matModel, 1, GL_FALSE, uniforms.model.matrix);
+                stats.uniformUploads ++;
+            }
             
-            if(mesh->vbo == -1)
+            if(shader->matProjViewModel != -1)
             {
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                glUniformMatrix4fv(shader->matProjViewModel, 1, GL_FALSE, uniforms.projViewModel.matrix);
+                stats.uniformUploads ++;
+            }
+            
+            
+            std::vector<vi::graphic::materialParameter>::iterator iterator;
+            for(iterator=material->parameter.begin(); iterator!=material->parameter.end(); iterator++)
+            {
+                vi::graphic::materialParameter& parameter = *iterator;
                 
-                if(lastMesh != mesh || mesh->dirty)
+                switch(parameter.type)
                 {
-                    lastMesh = mesh;
-                    
-                    if(currentMaterial->shader->position != -1)
-                        glDisableVertexAttribArray(currentMaterial->shader->position);
-                    
-                    if(currentMaterial->shader->texcoord0 != -1)
-                        glDisableVertexAttribArray(currentMaterial->shader->texcoord0);
-                    
-                    if(currentMaterial->shader->color != -1)
-                        glDisableVertexAttribArray(currentMaterial->shader->color);
-                    
-                    
-                    vi::common::vertex *vertices = mesh->getVertices();
-                    if(currentMaterial->shader->position != -1)
+                    case vi::graphic::materialParameterTypeInt:
                     {
-                        glEnableVertexAttribArray(currentMaterial->shader->position);
-                        glVertexAttribPointer(currentMaterial->shader->position, 2, GL_FLOAT, 0, sizeof(vi::common::vertex), &vertices[0].x);
+                        uniformIvFuncs[parameter.count - 1](parameter.location, parameter.size, (const GLint *)parameterData);
                     }
-                    
-                    if(currentMaterial->shader->texcoord0 != -1)
+                        break;
+                        
+                    case vi::graphic::materialParameterTypeFloat:
                     {
-                        glEnableVertexAttribArray(currentMaterial->shader->texcoord0);
-                        glVertexAttribPointer(currentMaterial->shader->texcoord0, 2, GL_FLOAT, 0, sizeof(vi::common::vertex), &vertices[0].u);
+                        uniformFvFuncs[parameter.count - 1](parameter.location, parameter.size, (const GLfloat *)parameterData);
                     }
-                    
-                    if(currentMaterial->shader->color != -1)
+                        break;
+                        
+                    case vi::graphic::materialParameterTypeMatrix:
                     {
-                        glEnableVertexAttribArray(currentMaterial->shader->color);
-                        glVertexAttribPointer(currentMaterial->shader->color, 4, GL_FLOAT, 0, sizeof(vi::common::vertex), &vertices[0].r);
+                        uniformMatrixFvFuncs[parameter.count - 2](parameter.location, parameter.size, GL_FALSE, (const GLfloat *)parameterData);
                     }
+                        break;
+                        
+                    default:
+                        break;
                 }
+                
+                parameterData += vi::graphic::renderCommandList::parameterSize(parameter);
             }
-            else
+            
+            stats.uniformUploads += (uint32_t)material->parameter.size();
+        }
+        
+        void rendererOSX::drawMesh(vi::graphic::material *material, vi::common::mesh *mesh, uint32_t first, uint32_t count)
+        {
+            vi::graphic::shader *shader = material->shader;
+            bool hasVertexArray = false;
+            bool streamed = false;
+            
+#ifdef ViVertexArrayObjects
+            if(useVertexArrays)
             {
-                if(lastMesh != mesh || mesh->dirty)
+                // Core profile contexts have no client side arrays. Meshes without VBOs (eg. the transient meshes of the command list) and draws with
+                // custom attributes are streamed, the cached vertex array object of the mesh must not keep the pointers of a single material
+                if(mesh->vbo != -1 && material->attributes.empty())
                 {
-                    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-                    
-                    if(currentMaterial->shader->position != -1)
-                        glDisableVertexAttribArray(currentMaterial->shader->position);
-                    
-                    if(currentMaterial->shader->texcoord0 != -1)
-                        glDisableVertexAttribArray(currentMaterial->shader->texcoord0);
-                    
-                    if(currentMaterial->shader->color != -1)
-                        glDisableVertexAttribArray(currentMaterial->shader->color);
-                    
-                    
-                    
-                    
-                    if(currentMaterial->shader->position != -1)
-                    {
-                        glEnableVertexAttribArray(currentMaterial->shader->position);
-                        glVertexAttribPointer(currentMaterial->shader->position, 2, GL_FLOAT, 0, sizeof(vi::common::vertex), (const void *)0);
-                    }
-                    
-                    if(currentMaterial->shader->texcoord0 != -1)
-                    {
-                        glEnableVertexAttribArray(currentMaterial->shader->texcoord0);
-                        glVertexAttribPointer(currentMaterial->shader->texcoord0, 2, GL_FLOAT, 0, sizeof(vi::common::vertex), (const void *)8);
-                    }
-                    
-                    if(currentMaterial->shader->color != -1)
-                    {
-                        glEnableVertexAttribArray(currentMaterial->shader->color);
-                        glVertexAttribPointer(currentMaterial->shader->color, 4, GL_FLOAT, 0, sizeof(vi::common::vertex), (const void *)16);
-                    }
+                    bindMeshVertexArray(mesh, shader);
+                }
+                else
+                {
+                    bindStreamVertexArray(mesh, material);
+                    streamed = true;
+                }
+                
+                hasVertexArray = true;
+            }
+#endif
+            
+            if(!hasVertexArray)
+            {
+                bindVertexArray(0);
+                bindMeshAttributes(mesh, material);
+                
+                // The attributes were already enabled by bindMeshAttributes(), their pointers are client memory and not offsets into the VBO
+                if(!material->attributes.empty())
+                    glBindBuffer(GL_ARRAY_BUFFER, 0);
+                
+                std::vector<vi::graphic::vertexAttribute>::iterator iterator;
+                for(iterator=material->attributes.begin(); iterator!=material->attributes.end(); iterator++)
+                {
+                    vi::graphic::vertexAttribute attribute = *iterator;
+                    glVertexAttribPointer(attribute.location, attribute.size, attribute.type, 0, attribute.stride, attribute.data);
                 }
             }
             
             
-            if(mesh->ivbo == -1)
+            if(mesh->ivbo == -1 && !hasVertexArray)
 			{
 				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-				glDrawElements(currentMaterial->drawMode, mesh->indexCount, GL_UNSIGNED_SHORT, mesh->getIndices());
+				glDrawElements(material->drawMode, count, GL_UNSIGNED_SHORT, mesh->getIndices() + first);
 			}
             else
             {
-                if(lastMesh != mesh || mesh->dirty)
+                if(!hasVertexArray && (lastMesh != mesh || mesh->dirty))
                 {
                     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ivbo);
                 }
                 
-				glDrawElements(currentMaterial->drawMode, mesh->indexCount, GL_UNSIGNED_SHORT, 0);
+				glDrawElements(material->drawMode, count, GL_UNSIGNED_SHORT, (const GLvoid *)(first * sizeof(uint16_t)));
 			}
             
+            stats.drawCalls ++;
+            stats.vertices += renderCommandList::drawnVertices(mesh, first, count);
+            stats.indices  += count;
             
-            do {
-                std::vector<vi::graphic::vertexAttribute>::iterator iterator;
-                for(iterator=currentMaterial->attributes.begin(); iterator!=currentMaterial->attributes.end(); iterator++)
-                {
-                    vi::graphic::vertexAttribute attribute = *iterator;
-                    
-                    glDisableVertexAttribArray(attribute.location);
-                }
-            } 
-            while(0);
-            
-            lastMesh = mesh;
+            lastMesh   = mesh;
+            lastShader = shader;
+            lastStreamed = streamed;
             lastMesh->dirty = false;
         }
         
         
         
-        void rendererOSX::setMaterial(vi::graphic::material *material)
+        void rendererOSX::bindVertexArray(GLuint vao)
         {
-            if(!material)
+#ifdef ViVertexArrayObjects
+            if(boundVertexArray != vao)
+            {
+                glBindVertexArray(vao);
+                boundVertexArray = vao;
+            }
+#endif
+        }
+        
+        void rendererOSX::bindMeshVertexArray(vi::common::mesh *mesh, vi::graphic::shader *shader)
+        {
+            vi::common::meshVertexArray *vertexArray = mesh->vertexArrayForShader(shader, currentContext);
+            bindVertexArray(vertexArray->vao);
+            
+            if(vertexArray->vbo == mesh->vbo && vertexArray->ivbo == mesh->ivbo && vertexArray->revision == mesh->revision)
                 return;
             
-            if(!material->shader)
+            // The vertex array object is either new or the mesh got new buffers, (re)specify it
+            glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ivbo);
+            
+            if(shader->position != -1)
+                glEnableVertexAttribArray(shader->position);
+            
+            if(shader->texcoord0 != -1)
+                glEnableVertexAttribArray(shader->texcoord0);
+            
+            if(shader->color != -1)
+                glEnableVertexAttribArray(shader->color);
+            
+            setVertexPointers(mesh, shader, NULL);
+            
+            vertexArray->vbo  = mesh->vbo;
+            vertexArray->ivbo = mesh->ivbo;
+            vertexArray->revision = mesh->revision;
+        }
+        
+        void rendererOSX::bindStreamVertexArray(vi::common::mesh *mesh, vi::graphic::material *material)
+        {
+#ifdef ViVertexArrayObjects
+            vi::graphic::shader *shader = material->shader;
+            streamVertexArray *stream = NULL;
+            
+            std::vector<streamVertexArray>::iterator iterator;
+            for(iterator=streamArrays.begin(); iterator!=streamArrays.end(); iterator++)
             {
-                static bool complaintAboutShader = false;
-                if(!complaintAboutShader)
+                if((*iterator).context == currentContext)
                 {
-                    ViLog(@"Tried to enable a material in a shader based renderer but the material had no shader! This error will be reported once");
-                    complaintAboutShader = true;
+                    stream = &(*iterator);
+                    break;
                 }
+            }
+            
+            if(!stream)
+            {
+                streamVertexArray tstream;
+                tstream.context    = currentContext;
+                tstream.attributes = 0;
                 
-                return;
+                glGenVertexArrays(1, &tstream.vao);
+                glGenBuffers(1, &tstream.vbo);
+                glGenBuffers(1, &tstream.ivbo);
+                glGenBuffers(1, &tstream.attributeBuffer);
+                
+                glBindVertexArray(tstream.vao);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tstream.ivbo);
+                glBindVertexArray(boundVertexArray);
+                
+                streamArrays.push_back(tstream);
+                stream = &streamArrays.back();
             }
             
-            if(currentMaterial != material)
+            bindVertexArray(stream->vao);
+            
+            uint32_t attributes = 0;
+            
+            if(shader->position != -1)
+                attributes |= (1 << shader->position);
+            
+            if(shader->texcoord0 != -1)
+                attributes |= (1 << shader->texcoord0);
+            
+            if(shader->color != -1)
+                attributes |= (1 << shader->color);
+            
+            std::vector<vi::graphic::vertexAttribute>::iterator attribute;
+            for(attribute=material->attributes.begin(); attribute!=material->attributes.end(); attribute++)
             {
-                glUseProgram(material->shader->program);
+                attributes |= (1 << (*attribute).location);
+            }
+            
+            setEnabledAttributes(attributes, stream->attributes);
+            
+            
+            if(!lastStreamed || lastMesh != mesh || lastShader != shader || mesh->dirty)
+            {
+                // The buffers are respecified for every mesh, which lets the driver orphan the storage that is still in use by the previous draw
+                glBindBuffer(GL_ARRAY_BUFFER, stream->vbo);
+                glBufferData(GL_ARRAY_BUFFER, mesh->vertexCount * mesh->getVertexStride(), mesh->getVertexData(), GL_STREAM_DRAW);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->indexCount * sizeof(uint16_t), mesh->getIndices(), GL_STREAM_DRAW);
+                
+                setVertexPointers(mesh, shader, NULL);
+            }
+            
+            if(material->attributes.empty())
+                return;
+            
+            // Custom attributes point into client memory that might have changed since the last draw, so they are copied for every draw
+            GLsizeiptr size = 0;
+            
+            for(attribute=material->attributes.begin(); attribute!=material->attributes.end(); attribute++)
+                size += attributeDataSize(*attribute, mesh->vertexCount);
+            
+            glBindBuffer(GL_ARRAY_BUFFER, stream->attributeBuffer);
+            glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+            
+            GLsizeiptr offset = 0;
+            
+            for(attribute=material->attributes.begin(); attribute!=material->attributes.end(); attribute++)
+            {
+                GLsizeiptr length = attributeDataSize(*attribute, mesh->vertexCount);
+                
+                glBufferSubData(GL_ARRAY_BUFFER, offset, length, (*attribute).data);
+                glVertexAttribPointer((*attribute).location, (*attribute).size, (*attribute).type, 0, (*attribute).stride, (const GLvoid *)offset);
                 
-                if(!currentMaterial || (currentMaterial->textures != material->textures || currentMaterial->texlocations != material->texlocations))
+                offset += length;
+            }
+#endif
+        }
+        
+        void rendererOSX::bindMeshAttributes(vi::common::mesh *mesh, vi::graphic::material *material)
+        {
+            vi::graphic::shader *shader = material->shader;
+            uint32_t attributes = 0;
+            
+            if(shader->position != -1)
+                attributes |= (1 << shader->position);
+            
+            if(shader->texcoord0 != -1)
+                attributes |= (1 << shader->texcoord0);
+            
+            if(shader->color != -1)
+                attributes |= (1 << shader->color);
+            
+            std::vector<vi::graphic::vertexAttribute>::iterator iterator;
+            for(iterator=material->attributes.begin(); iterator!=material->attributes.end(); iterator++)
+            {
+                attributes |= (1 << (*iterator).location);
+            }
+            
+            setEnabledAttributes(attributes, enabledAttributes);
+            
+            
+            if(lastMesh == mesh && lastShader == shader && !mesh->dirty)
+                return;
+            
+            const GLubyte *base = NULL;
+            if(mesh->vbo == -1)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                base = (const GLubyte *)mesh->getVertexData();
+            }
+            else
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+            }
+            
+            setVertexPointers(mesh, shader, base);
+        }
+        
+        void rendererOSX::setVertexPointers(vi::common::mesh *mesh, vi::graphic::shader *shader, const GLubyte *base)
+        {
+            GLsizei stride = mesh->getVertexStride();
+            
+            switch(mesh->getVertexFormat())
+            {
+                case vi::common::vertexFormatPacked:
                 {
-                    if(material->textures.size() > 0)
-                    {
-                        for(int i=0; i<material->texlocations.size(); i++)
-                        {
-                            if(material->texlocations[i] == -1)
-                                break;
-                            
-                            glActiveTexture(GL_TEXTURE0 + i);
-                            glBindTexture(GL_TEXTURE_2D, material->textures[i]->getTexture());
-                        }
-                    }
+                    if(shader->position != -1)
+                        glVertexAttribPointer(shader->position, 2, GL_FLOAT, GL_FALSE, stride, base + 0);
+                    
+                    if(shader->texcoord0 != -1)
+                        glVertexAttribPointer(shader->texcoord0, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, base + 8);
+                    
+                    if(shader->color != -1)
+                        glVertexAttribPointer(shader->color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + 12);
                 }
-                
-                if(!currentMaterial || currentMaterial->culling != material->culling)
+                    break;
+                    
+                case vi::common::vertexFormatPackedShort:
                 {
-                    if(material->culling)
-                    {
-                        glEnable(GL_CULL_FACE);
-                        glFrontFace(material->cullMode);
-                    }
-                    else
-                        glDisable(GL_CULL_FACE);
+                    if(shader->position != -1)
+                        glVertexAttribPointer(shader->position, 2, GL_SHORT, GL_FALSE, stride, base + 0);
+                    
+                    if(shader->texcoord0 != -1)
+                        glVertexAttribPointer(shader->texcoord0, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, base + 4);
+                    
+                    if(shader->color != -1)
+                        glVertexAttribPointer(shader->color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + 8);
                 }
-                
-                if(!currentMaterial || (currentMaterial->blending != material->blending || currentMaterial->blendSource != material->blendSource || currentMaterial->blendDestination != material->blendDestination))
+                    break;
+                    
+                default:
                 {
-                    if(material->blending)
-                    {
-                        glEnable(GL_BLEND);
-                        glBlendFunc(material->blendSource, material->blendDestination);
-                    }
-                    else
-                        glDisable(GL_BLEND);
+                    if(shader->position != -1)
+                        glVertexAttribPointer(shader->position, 2, GL_FLOAT, GL_FALSE, stride, base + 0);
+                    
+                    if(shader->texcoord0 != -1)
+                        glVertexAttribPointer(shader->texcoord0, 2, GL_FLOAT, GL_FALSE, stride, base + 8);
+                    
+                    if(shader->color != -1)
+                        glVertexAttribPointer(shader->color, 4, GL_FLOAT, GL_FALSE, stride, base + 16);
                 }
+                    break;
+            }
+        }
+        
+        void rendererOSX::setEnabledAttributes(uint32_t attributes, uint32_t& enabled)
+        {
+            uint32_t changed = attributes ^ enabled;
+            if(changed == 0)
+                return;
+            
+            for(GLuint i=0; changed; i++, changed >>= 1)
+            {
+                if(!(changed & 1))
+                    continue;
                 
-                currentMaterial = material;
+                if(attributes & (1 << i))
+                    glEnableVertexAttribArray(i);
+                else
+                    glDisableVertexAttribArray(i);
             }
+            
+            enabled = attributes;
         }
     }
 }
@@ -0,0 +1,124 @@
+//
+//  ViRendererSoftware.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <pthread.h>
+#include <vector>
+#include <map>
+#import "ViBase.h"
+#import "ViCommandRenderer.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            uint32_t width, height;
+            std::vector<uint8_t> color;
+            std::vector<float> depth;
+        } softwareBuffer;
+
+        typedef struct
+        {
+            float x[3], y[3], z[3];
+            float u[3], v[3];
+            float r[3], g[3], b[3], a[3];
+
+            const uint8_t *texture;
+            uint32_t textureWidth, textureHeight;
+
+            bool vertexColor;
+            bool blending;
+            GLenum blendSource, blendDestination;
+            vi::graphic::renderDepthMode depthMode;
+
+            int32_t minX, minY, maxX, maxY;
+        } softwareTriangle;
+        /**
+         * @endcond
+         **/
+
+        /**
+         * @brief Renderer that rasterizes the command list on the CPU
+         *
+         * The software renderer executes the command list without OpenGL, it implements the semantics of the default texture, sprite and particle shaders
+         * (textured and vertex colored triangles with atlas translation), blending, culling and the depth modes. The triangles of a list are binned
+         * into screen tiles which are rasterized in parallel. The result is an RGBA buffer per camera that can be compared against reference images or
+         * used to measure the cost of the traversal and batching without a GPU.
+         * @remark Textures must keep their pixels to be sampled, see vi::graphic::texture::setKeepsPixelData(). Textures of cameras and cached UI nodes
+         * that were rendered by the software renderer are sampled from its buffers. Other textures are sampled as opaque white.
+         * @remark Custom shaders aren't interpreted, materials are drawn with the semantics of the default shader their attributes and parameters match.
+         * Only GL_TRIANGLES draws are rasterized and the vertices are used in their floating point format, regardless of the meshes vertex format.
+         **/
+        class rendererSoftware : public commandRenderer
+        {
+        public:
+            /**
+             * Constructor
+             * @param threads The number of threads that rasterize tiles, including the calling thread. 0 uses one thread per CPU core.
+             * @param tileSize The width and height of a tile in pixels.
+             **/
+            rendererSoftware(uint32_t threads=0, uint32_t tileSize=64);
+            /**
+             * Destructor, stops the rasterizer threads.
+             **/
+            virtual ~rendererSoftware();
+
+            /**
+             * Returns the pixels the camera rendered in the last frame as premultiplied RGBA, with the bottom row first like glReadPixels(), or NULL
+             * if the camera wasn't rendered yet.
+             * @param width If not NULL, receives the width of the image in pixels.
+             * @param height If not NULL, receives the height of the image in pixels.
+             **/
+            const uint8_t *getPixels(vi::scene::camera *camera, uint32_t *width=NULL, uint32_t *height=NULL);
+
+        protected:
+            /**
+             * Rasterizes the commands of the list into the buffer of the camera.
+             **/
+            virtual void executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera);
+
+        private:
+            softwareBuffer *bufferForKey(void *key, uint32_t width, uint32_t height);
+            void clearBuffer(softwareBuffer *buffer, vi::common::color const& color);
+
+            void addTriangles(vi::graphic::renderCommandList *list, vi::graphic::renderCommand const& draw, uint32_t uniforms, vi::graphic::renderDepthMode depthMode);
+            void flush();
+
+            void rasterizeTile(uint32_t tile);
+            void rasterizeTriangle(softwareTriangle const& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY);
+
+            static void *workerThread(void *renderer);
+            void runWorker();
+            void processTiles();
+
+            std::map<void *, softwareBuffer> buffers;
+            std::vector<softwareBuffer *> targetStack;
+            softwareBuffer *target;
+            bool loggedMissingPixels;
+
+            std::vector<softwareTriangle> triangles;
+            std::vector<std::vector<uint32_t> > bins;
+            uint32_t tileSize;
+            uint32_t tilesX, tilesY;
+
+            std::vector<pthread_t> workers;
+            pthread_mutex_t mutex;
+            pthread_cond_t workCondition;
+            pthread_cond_t doneCondition;
+            uint32_t job;
+            uint32_t jobTiles;
+            uint32_t nextTile;
+            uint32_t finishedWorkers;
+            bool running;
+        };
+    }
+}
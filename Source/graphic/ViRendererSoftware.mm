@@ -0,0 +1,667 @@
+//
+//  ViRendererSoftware.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <algorithm>
+#include <unistd.h>
+#include <math.h>
+#import "ViRendererSoftware.h"
+#import "ViKernel.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        static inline float blendFactor(GLenum factor, float source, float sourceAlpha, float destination, float destinationAlpha)
+        {
+            switch(factor)
+            {
+                case GL_ZERO:
+                    return 0.0f;
+                case GL_SRC_COLOR:
+                    return source;
+                case GL_ONE_MINUS_SRC_COLOR:
+                    return 1.0f - source;
+                case GL_SRC_ALPHA:
+                    return sourceAlpha;
+                case GL_ONE_MINUS_SRC_ALPHA:
+                    return 1.0f - sourceAlpha;
+                case GL_DST_COLOR:
+                    return destination;
+                case GL_ONE_MINUS_DST_COLOR:
+                    return 1.0f - destination;
+                case GL_DST_ALPHA:
+                    return destinationAlpha;
+                case GL_ONE_MINUS_DST_ALPHA:
+                    return 1.0f - destinationAlpha;
+
+                default:
+                    return 1.0f;
+            }
+        }
+
+        static inline uint8_t packChannel(float value)
+        {
+            value = MIN(MAX(value, 0.0f), 1.0f);
+            return (uint8_t)(value * 255.0f + 0.5f);
+        }
+
+        static inline void sampleTexture(softwareTriangle const& triangle, float u, float v, float *result)
+        {
+            if(!triangle.texture)
+            {
+                result[0] = result[1] = result[2] = result[3] = 1.0f;
+                return;
+            }
+
+            // Bilinear filtering with repeating texture coordinates, the default state of the textures
+            int32_t width  = (int32_t)triangle.textureWidth;
+            int32_t height = (int32_t)triangle.textureHeight;
+
+            float s = u * width - 0.5f;
+            float t = v * height - 0.5f;
+
+            float floorS = floorf(s);
+            float floorT = floorf(t);
+            float fractS = s - floorS;
+            float fractT = t - floorT;
+
+            int32_t x0 = ((int32_t)floorS % width + width) % width;
+            int32_t y0 = ((int32_t)floorT % height + height) % height;
+            int32_t x1 = (x0 + 1) % width;
+            int32_t y1 = (y0 + 1) % height;
+
+            const uint8_t *p00 = triangle.texture + (y0 * width + x0) * 4;
+            const uint8_t *p10 = triangle.texture + (y0 * width + x1) * 4;
+            const uint8_t *p01 = triangle.texture + (y1 * width + x0) * 4;
+            const uint8_t *p11 = triangle.texture + (y1 * width + x1) * 4;
+
+            for(int i=0; i<4; i++)
+            {
+                float top    = p00[i] + (p10[i] - p00[i]) * fractS;
+                float bottom = p01[i] + (p11[i] - p01[i]) * fractS;
+
+                result[i] = (top + (bottom - top) * fractT) / 255.0f;
+            }
+        }
+
+        static inline bool isTopLeftEdge(float x0, float y0, float x1, float y1)
+        {
+            // Counter clockwise winding with y pointing up, so left edges go down and top edges go left
+            return (y1 < y0 || (y1 == y0 && x1 < x0));
+        }
+
+
+
+        rendererSoftware::rendererSoftware(uint32_t threads, uint32_t ttileSize)
+        {
+            tileSize = MAX(ttileSize, 8);
+            tilesX   = 0;
+            tilesY   = 0;
+            target   = NULL;
+            loggedMissingPixels = false;
+
+            job  = 0;
+            jobTiles = 0;
+            nextTile = 0;
+            finishedWorkers = 0;
+            running = true;
+
+            if(threads == 0)
+                threads = (uint32_t)MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+
+            pthread_mutex_init(&mutex, NULL);
+            pthread_cond_init(&workCondition, NULL);
+            pthread_cond_init(&doneCondition, NULL);
+
+            // The thread that executes the command list rasterizes tiles as well
+            for(uint32_t i=1; i<threads; i++)
+            {
+                pthread_t thread;
+                pthread_create(&thread, NULL, &rendererSoftware::workerThread, this);
+
+                workers.push_back(thread);
+            }
+        }
+
+        rendererSoftware::~rendererSoftware()
+        {
+            pthread_mutex_lock(&mutex);
+            running = false;
+
+            pthread_cond_broadcast(&workCondition);
+            pthread_mutex_unlock(&mutex);
+
+            std::vector<pthread_t>::iterator iterator;
+            for(iterator=workers.begin(); iterator!=workers.end(); iterator++)
+                pthread_join(*iterator, NULL);
+
+            pthread_cond_destroy(&workCondition);
+            pthread_cond_destroy(&doneCondition);
+            pthread_mutex_destroy(&mutex);
+        }
+
+
+
+        const uint8_t *rendererSoftware::getPixels(vi::scene::camera *camera, uint32_t *width, uint32_t *height)
+        {
+            void *key = camera->getTexture() ? (void *)camera->getTexture() : (void *)camera;
+
+            std::map<void *, softwareBuffer>::iterator iterator = buffers.find(key);
+            if(iterator == buffers.end() || iterator->second.color.empty())
+                return NULL;
+
+            if(width)
+                *width = iterator->second.width;
+
+            if(height)
+                *height = iterator->second.height;
+
+            return &iterator->second.color[0];
+        }
+
+
+
+        void rendererSoftware::executeCommandList(vi::graphic::renderCommandList *list, vi::scene::camera *camera)
+        {
+            vi::graphic::texture *texture = camera->getTexture();
+
+            if(texture)
+            {
+                target = bufferForKey(texture, texture->width, texture->height);
+            }
+            else
+            {
+                vi::common::kernel *kernel = vi::common::kernel::sharedKernel();
+                float factor = kernel ? kernel->scaleFactor : 1.0f;
+
+                target = bufferForKey(camera, (uint32_t)(camera->frame.size.x * factor), (uint32_t)(camera->frame.size.y * factor));
+            }
+
+            clearBuffer(target, camera->clearColor);
+            targetStack.clear();
+
+
+            vi::graphic::renderDepthMode depthMode = renderDepthModeDisabled;
+            uint32_t uniforms = 0;
+
+            std::vector<vi::graphic::renderCommand>::iterator iterator;
+            for(iterator=list->commands.begin(); iterator!=list->commands.end(); iterator++)
+            {
+                vi::graphic::renderCommand& command = *iterator;
+
+                switch(command.type)
+                {
+                    case renderCommandTypeSetUniforms:
+                        uniforms = command.uniforms;
+                        break;
+
+                    case renderCommandTypeDraw:
+                        if(drawTimes)
+                        {
+                            // Rasterize every draw on its own, so that its time contains the binning and the rasterization
+                            flush();
+                            
+                            double timestamp = vi::graphic::frameStats::timestamp();
+                            addTriangles(list, command, uniforms, depthMode);
+                            flush();
+                            
+                            drawTimes->push_back(vi::graphic::frameStats::timestamp() - timestamp);
+                        }
+                        else
+                            addTriangles(list, command, uniforms, depthMode);
+
+                        stats.drawCalls ++;
+                        stats.vertices += renderCommandList::drawnVertices(command.mesh, command.first, command.count);
+                        stats.indices  += command.count;
+                        break;
+
+                    case renderCommandTypeBeginTarget:
+                    {
+                        flush();
+                        targetStack.push_back(target);
+
+                        vi::graphic::texture *targetTexture = command.target->getTexture();
+
+                        target = bufferForKey(targetTexture, targetTexture->width, targetTexture->height);
+                        clearBuffer(target, vi::common::color(0.0, 0.0, 0.0, 0.0));
+                    }
+                        break;
+
+                    case renderCommandTypeEndTarget:
+                    {
+                        if(targetStack.size() == 0)
+                            break;
+
+                        flush();
+
+                        target = targetStack.back();
+                        targetStack.pop_back();
+                    }
+                        break;
+
+                    case renderCommandTypeClearDepth:
+                        flush();
+                        std::fill(target->depth.begin(), target->depth.end(), 1.0f);
+                        break;
+
+                    case renderCommandTypeSetDepth:
+                        depthMode = command.depthMode;
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+
+            flush();
+            target = NULL;
+        }
+
+
+
+        softwareBuffer *rendererSoftware::bufferForKey(void *key, uint32_t width, uint32_t height)
+        {
+            softwareBuffer& buffer = buffers[key];
+
+            if(buffer.width != width || buffer.height != height || buffer.color.size() != width * height * 4)
+            {
+                buffer.width  = width;
+                buffer.height = height;
+                buffer.color.resize(width * height * 4);
+                buffer.depth.resize(width * height);
+            }
+
+            return &buffer;
+        }
+
+        void rendererSoftware::clearBuffer(softwareBuffer *buffer, vi::common::color const& color)
+        {
+            uint8_t r = packChannel(color.r);
+            uint8_t g = packChannel(color.g);
+            uint8_t b = packChannel(color.b);
+            uint8_t a = packChannel(color.a);
+
+            for(size_t i=0; i<buffer->color.size(); i+=4)
+            {
+                buffer->color[i + 0] = r;
+                buffer->color[i + 1] = g;
+                buffer->color[i + 2] = b;
+                buffer->color[i + 3] = a;
+            }
+
+            std::fill(buffer->depth.begin(), buffer->depth.end(), 1.0f);
+        }
+
+
+
+        void rendererSoftware::addTriangles(vi::graphic::renderCommandList *list, vi::graphic::renderCommand const& draw, uint32_t uniforms, vi::graphic::renderDepthMode depthMode)
+        {
+            vi::graphic::material *material = draw.material;
+            vi::graphic::shader *shader = material->shader;
+
+            if(material->drawMode != GL_TRIANGLES || target->width == 0 || target->height == 0 || list->uniforms.size() <= uniforms)
+                return;
+
+            vi::graphic::renderUniforms& snapshot = list->uniforms[uniforms];
+            vi::common::matrix4x4 matrix = snapshot.projViewModel;
+
+            if(shader->matProjViewModel == -1)
+            {
+                vi::common::matrix4x4 projection = snapshot.projection;
+                matrix = projection * snapshot.view * snapshot.model;
+            }
+
+
+            // The sprite shader translates the texture coordinates into the atlas
+            float atlas[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+            const uint8_t *parameterData = list->parameterData.empty() ? NULL : &list->parameterData[0] + snapshot.parameterOffset;
+
+            std::vector<vi::graphic::materialParameter>::iterator iterator;
+            for(iterator=material->parameter.begin(); iterator!=material->parameter.end(); iterator++)
+            {
+                vi::graphic::materialParameter& parameter = *iterator;
+
+                if(parameter.name == "atlasTranslation" && parameter.type == materialParameterTypeFloat && parameter.count == 4)
+                    memcpy(atlas, parameterData, 4 * sizeof(float));
+
+                parameterData += vi::graphic::renderCommandList::parameterSize(parameter);
+            }
+
+
+            const uint8_t *pixels = NULL;
+            uint32_t pixelsWidth  = 0;
+            uint32_t pixelsHeight = 0;
+
+            if(material->textures.size() > 0 && material->textures[0])
+            {
+                vi::graphic::texture *texture = material->textures[0];
+                std::map<void *, softwareBuffer>::iterator buffer = buffers.find(texture);
+
+                if(buffer != buffers.end() && &buffer->second != target && !buffer->second.color.empty())
+                {
+                    pixels = &buffer->second.color[0];
+                    pixelsWidth  = buffer->second.width;
+                    pixelsHeight = buffer->second.height;
+                }
+                else if(texture->getPixelData())
+                {
+                    pixels = texture->getPixelData();
+                    pixelsWidth  = texture->width;
+                    pixelsHeight = texture->height;
+                }
+                else if(!loggedMissingPixels)
+                {
+                    ViLog(@"The software renderer samples textures without pixel data as white, see vi::graphic::texture::setKeepsPixelData()");
+                    loggedMissingPixels = true;
+                }
+            }
+
+
+            const vi::common::mesh *mesh = draw.mesh;
+            const uint16_t *indices = mesh->getIndices() + draw.first;
+
+            float width  = (float)target->width;
+            float height = (float)target->height;
+
+            for(uint32_t i=0; i+2<draw.count; i+=3)
+            {
+                softwareTriangle triangle;
+                bool visible = true;
+
+                for(int j=0; j<3; j++)
+                {
+                    vi::common::vertex vertex = mesh->getVertex(indices[i + j]);
+                    const float *m = matrix.matrix;
+
+                    float x = m[0] * vertex.x + m[4] * vertex.y + m[8]  + m[12];
+                    float y = m[1] * vertex.x + m[5] * vertex.y + m[9]  + m[13];
+                    float z = m[2] * vertex.x + m[6] * vertex.y + m[10] + m[14];
+                    float w = m[3] * vertex.x + m[7] * vertex.y + m[11] + m[15];
+
+                    if(w <= 0.0f)
+                    {
+                        visible = false;
+                        break;
+                    }
+
+                    triangle.x[j] = ((x / w) * 0.5f + 0.5f) * width;
+                    triangle.y[j] = ((y / w) * 0.5f + 0.5f) * height;
+                    triangle.z[j] = (z / w) * 0.5f + 0.5f;
+
+                    triangle.u[j] = vertex.u * atlas[2] + atlas[0];
+                    triangle.v[j] = vertex.v * atlas[3] + atlas[1];
+
+                    triangle.r[j] = vertex.r;
+                    triangle.g[j] = vertex.g;
+                    triangle.b[j] = vertex.b;
+                    triangle.a[j] = vertex.a;
+                }
+
+                if(!visible)
+                    continue;
+
+
+                float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+                if(area == 0.0f)
+                    continue;
+
+                if(material->culling && (area > 0.0f) != (material->cullMode == GL_CCW))
+                    continue;
+
+                // The rasterizer expects counter clockwise triangles
+                if(area < 0.0f)
+                {
+                    std::swap(triangle.x[1], triangle.x[2]);
+                    std::swap(triangle.y[1], triangle.y[2]);
+                    std::swap(triangle.z[1], triangle.z[2]);
+                    std::swap(triangle.u[1], triangle.u[2]);
+                    std::swap(triangle.v[1], triangle.v[2]);
+                    std::swap(triangle.r[1], triangle.r[2]);
+                    std::swap(triangle.g[1], triangle.g[2]);
+                    std::swap(triangle.b[1], triangle.b[2]);
+                    std::swap(triangle.a[1], triangle.a[2]);
+                }
+
+                triangle.minX = MAX((int32_t)floorf(MIN(triangle.x[0], MIN(triangle.x[1], triangle.x[2]))), 0);
+                triangle.minY = MAX((int32_t)floorf(MIN(triangle.y[0], MIN(triangle.y[1], triangle.y[2]))), 0);
+                triangle.maxX = MIN((int32_t)ceilf(MAX(triangle.x[0], MAX(triangle.x[1], triangle.x[2]))), (int32_t)target->width - 1);
+                triangle.maxY = MIN((int32_t)ceilf(MAX(triangle.y[0], MAX(triangle.y[1], triangle.y[2]))), (int32_t)target->height - 1);
+
+                if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+                    continue;
+
+                triangle.texture = pixels;
+                triangle.textureWidth  = pixelsWidth;
+                triangle.textureHeight = pixelsHeight;
+
+                triangle.vertexColor = (shader->color != -1);
+                triangle.blending = material->blending;
+                triangle.blendSource = material->blendSource;
+                triangle.blendDestination = material->blendDestination;
+                triangle.depthMode = depthMode;
+
+                triangles.push_back(triangle);
+            }
+        }
+
+        void rendererSoftware::flush()
+        {
+            if(triangles.empty() || !target)
+                return;
+
+            tilesX = (target->width + tileSize - 1) / tileSize;
+            tilesY = (target->height + tileSize - 1) / tileSize;
+
+            bins.resize(tilesX * tilesY);
+
+            std::vector<std::vector<uint32_t> >::iterator bin;
+            for(bin=bins.begin(); bin!=bins.end(); bin++)
+                bin->clear();
+
+            // The bins keep the submission order, so every pixel is blended in the same order as on the GPU
+            for(uint32_t i=0; i<triangles.size(); i++)
+            {
+                softwareTriangle& triangle = triangles[i];
+
+                for(int32_t y=triangle.minY / tileSize; y<=triangle.maxY / (int32_t)tileSize; y++)
+                {
+                    for(int32_t x=triangle.minX / tileSize; x<=triangle.maxX / (int32_t)tileSize; x++)
+                        bins[y * tilesX + x].push_back(i);
+                }
+            }
+
+            processTiles();
+            triangles.clear();
+        }
+
+
+
+        void rendererSoftware::rasterizeTile(uint32_t tile)
+        {
+            int32_t minX = (tile % tilesX) * tileSize;
+            int32_t minY = (tile / tilesX) * tileSize;
+            int32_t maxX = MIN(minX + (int32_t)tileSize, (int32_t)target->width) - 1;
+            int32_t maxY = MIN(minY + (int32_t)tileSize, (int32_t)target->height) - 1;
+
+            std::vector<uint32_t>::iterator iterator;
+            for(iterator=bins[tile].begin(); iterator!=bins[tile].end(); iterator++)
+            {
+                softwareTriangle& triangle = triangles[*iterator];
+                rasterizeTriangle(triangle, MAX(minX, triangle.minX), MAX(minY, triangle.minY), MIN(maxX, triangle.maxX), MIN(maxY, triangle.maxY));
+            }
+        }
+
+        void rendererSoftware::rasterizeTriangle(softwareTriangle const& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY)
+        {
+            const float *x = triangle.x;
+            const float *y = triangle.y;
+
+            float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+            float invArea = 1.0f / area;
+
+            // Edge i lies opposite of vertex i, its edge function is the barycentric weight of that vertex
+            bool topLeft[3];
+            topLeft[0] = isTopLeftEdge(x[1], y[1], x[2], y[2]);
+            topLeft[1] = isTopLeftEdge(x[2], y[2], x[0], y[0]);
+            topLeft[2] = isTopLeftEdge(x[0], y[0], x[1], y[1]);
+
+            for(int32_t py=minY; py<=maxY; py++)
+            {
+                float sampleY = py + 0.5f;
+
+                for(int32_t px=minX; px<=maxX; px++)
+                {
+                    float sampleX = px + 0.5f;
+
+                    float e0 = (x[2] - x[1]) * (sampleY - y[1]) - (y[2] - y[1]) * (sampleX - x[1]);
+                    float e1 = (x[0] - x[2]) * (sampleY - y[2]) - (y[0] - y[2]) * (sampleX - x[2]);
+                    float e2 = (x[1] - x[0]) * (sampleY - y[0]) - (y[1] - y[0]) * (sampleX - x[0]);
+
+                    if(e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+                        continue;
+
+                    if((e0 == 0.0f && !topLeft[0]) || (e1 == 0.0f && !topLeft[1]) || (e2 == 0.0f && !topLeft[2]))
+                        continue;
+
+                    float w0 = e0 * invArea;
+                    float w1 = e1 * invArea;
+                    float w2 = e2 * invArea;
+
+
+                    uint32_t index = py * target->width + px;
+
+                    float z = triangle.z[0] * w0 + triangle.z[1] * w1 + triangle.z[2] * w2;
+                    if(z < 0.0f || z > 1.0f)
+                        continue;
+
+                    if(triangle.depthMode != renderDepthModeDisabled)
+                    {
+                        if(z > target->depth[index])
+                            continue;
+
+                        if(triangle.depthMode == renderDepthModeWrite)
+                            target->depth[index] = z;
+                    }
+
+
+                    float source[4];
+
+                    float u = triangle.u[0] * w0 + triangle.u[1] * w1 + triangle.u[2] * w2;
+                    float v = triangle.v[0] * w0 + triangle.v[1] * w1 + triangle.v[2] * w2;
+                    sampleTexture(triangle, u, v, source);
+
+                    if(triangle.vertexColor)
+                    {
+                        float color[4];
+                        color[0] = triangle.r[0] * w0 + triangle.r[1] * w1 + triangle.r[2] * w2;
+                        color[1] = triangle.g[0] * w0 + triangle.g[1] * w1 + triangle.g[2] * w2;
+                        color[2] = triangle.b[0] * w0 + triangle.b[1] * w1 + triangle.b[2] * w2;
+                        color[3] = triangle.a[0] * w0 + triangle.a[1] * w1 + triangle.a[2] * w2;
+
+                        // Sprite and particle shader: texture * color, premultiplied with the vertex alpha
+                        for(int i=0; i<4; i++)
+                            source[i] *= color[i] * color[3];
+                    }
+
+
+                    uint8_t *pixel = &target->color[index * 4];
+
+                    if(triangle.blending)
+                    {
+                        float destination[4];
+                        for(int i=0; i<4; i++)
+                            destination[i] = pixel[i] / 255.0f;
+
+                        for(int i=0; i<4; i++)
+                        {
+                            float sourceFactor = blendFactor(triangle.blendSource, source[i], source[3], destination[i], destination[3]);
+                            float destinationFactor = blendFactor(triangle.blendDestination, source[i], source[3], destination[i], destination[3]);
+
+                            pixel[i] = packChannel(source[i] * sourceFactor + destination[i] * destinationFactor);
+                        }
+                    }
+                    else
+                    {
+                        for(int i=0; i<4; i++)
+                            pixel[i] = packChannel(source[i]);
+                    }
+                }
+            }
+        }
+
+
+
+        void *rendererSoftware::workerThread(void *renderer)
+        {
+            ((rendererSoftware *)renderer)->runWorker();
+            return NULL;
+        }
+
+        void rendererSoftware::runWorker()
+        {
+            uint32_t lastJob = 0;
+
+            pthread_mutex_lock(&mutex);
+
+            while(1)
+            {
+                while(running && job == lastJob)
+                    pthread_cond_wait(&workCondition, &mutex);
+
+                if(!running)
+                    break;
+
+                lastJob = job;
+
+                // The tile count is read from the job, tilesX and tilesY already belong to the next job while flush() bins it
+                while(job == lastJob && nextTile < jobTiles)
+                {
+                    uint32_t tile = nextTile ++;
+                    pthread_mutex_unlock(&mutex);
+
+                    rasterizeTile(tile);
+
+                    pthread_mutex_lock(&mutex);
+                }
+
+                if(++ finishedWorkers == workers.size())
+                    pthread_cond_signal(&doneCondition);
+            }
+
+            pthread_mutex_unlock(&mutex);
+        }
+
+        void rendererSoftware::processTiles()
+        {
+            pthread_mutex_lock(&mutex);
+
+            job ++;
+            jobTiles = tilesX * tilesY;
+            nextTile = 0;
+            finishedWorkers = 0;
+
+            pthread_cond_broadcast(&workCondition);
+
+            while(nextTile < jobTiles)
+            {
+                uint32_t tile = nextTile ++;
+                pthread_mutex_unlock(&mutex);
+
+                rasterizeTile(tile);
+
+                pthread_mutex_lock(&mutex);
+            }
+
+            // Every worker reports once per job after its last tile, the bins and triangles must not change before all of them did
+            while(finishedWorkers < workers.size())
+                pthread_cond_wait(&doneCondition, &mutex);
+
+            pthread_mutex_unlock(&mutex);
+        }
+    }
+}
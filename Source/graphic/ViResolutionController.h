@@ -0,0 +1,106 @@
+//
+//  ViResolutionController.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViBase.h"
+#import "ViFrameStats.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief Adjusts the resolution of a camera to keep the frame time within a budget
+         *
+         * The controller averages the frame time over a window of frames and lowers the resolution scale by one step if the average exceeds the budget.
+         * The scale is only raised again after several windows in a row were clearly below the budget, so that the resolution doesn't oscillate
+         * between two steps. Assign the controller to a camera with vi::scene::camera::setResolutionController().
+         * The frame time is the GPU time of the frame if the context supports timer queries, and the CPU time of the frame otherwise, which includes
+         * the time the driver blocks because the GPU falls behind. A window only ever averages one of the two, it is started over when the source
+         * changes.
+         **/
+        class resolutionController
+        {
+        public:
+            /**
+             * Constructor
+             * @param budget The target frame time in seconds.
+             **/
+            resolutionController(double budget=1.0/60.0);
+            
+            /**
+             * Adds the given frame to the current window and returns the new resolution scale. GPU times arrive a few frames late and not for every
+             * frame, so while the window averages GPU times, frames without one are skipped. Once no GPU time arrived for a whole window, the
+             * controller falls back to the CPU frame time.
+             * @remark The kernel invokes this once per frame for the controllers of the view cameras.
+             **/
+            float update(vi::graphic::frameStats const& stats);
+            /**
+             * Adds a frame with the given time in seconds to the current window and returns the new resolution scale. The time must come from the
+             * same source as the other times of the window.
+             **/
+            float update(double frameTime);
+            
+            /**
+             * Returns the current resolution scale.
+             **/
+            float getScale();
+            /**
+             * Sets the resolution scale and starts a new window.
+             **/
+            void setScale(float scale);
+            
+            /**
+             * The target frame time in seconds.
+             * @default 1/60
+             **/
+            double budget;
+            /**
+             * The lowest resolution scale the controller goes down to.
+             * @default 0.5
+             **/
+            float minScale;
+            /**
+             * The highest resolution scale the controller goes up to.
+             * @default 1.0
+             **/
+            float maxScale;
+            /**
+             * The amount the scale changes by per step.
+             * @default 0.1
+             **/
+            float step;
+            /**
+             * The number of frames that are averaged before the scale is adjusted.
+             * @default 15
+             **/
+            uint32_t windowFrames;
+            /**
+             * The scale is raised if the average frame time of a window is below this fraction of the budget.
+             * @default 0.75
+             **/
+            float raiseThreshold;
+            /**
+             * The number of windows in a row that must be below the raise threshold before the scale is raised.
+             * @default 3
+             **/
+            uint32_t raiseWindows;
+            
+        private:
+            void resetWindow();
+            
+            float scale;
+            
+            double accumulatedTime;
+            uint32_t frames;
+            uint32_t fastWindows;
+            
+            bool gpuWindow;
+            uint32_t framesWithoutGPUTime;
+        };
+    }
+}
@@ -0,0 +1,118 @@
+//
+//  ViResolutionController.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViResolutionController.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        resolutionController::resolutionController(double tbudget)
+        {
+            budget   = tbudget;
+            minScale = 0.5f;
+            maxScale = 1.0f;
+            step     = 0.1f;
+            
+            windowFrames   = 15;
+            raiseThreshold = 0.75f;
+            raiseWindows   = 3;
+            
+            scale = 1.0f;
+            accumulatedTime = 0.0;
+            frames      = 0;
+            fastWindows = 0;
+            
+            gpuWindow = false;
+            framesWithoutGPUTime = 0;
+        }
+        
+        
+        float resolutionController::update(vi::graphic::frameStats const& stats)
+        {
+            // Lowering the resolution only helps if the GPU is the bottleneck, so GPU times are preferred
+            if(stats.gpuTimeAvailable)
+            {
+                if(!gpuWindow)
+                {
+                    resetWindow();
+                    gpuWindow = true;
+                }
+                
+                framesWithoutGPUTime = 0;
+                return update(stats.gpuTime);
+            }
+            
+            if(gpuWindow)
+            {
+                // The result of an earlier frame is still in flight
+                if(++ framesWithoutGPUTime <= MAX(windowFrames, 1))
+                    return scale;
+                
+                resetWindow();
+                gpuWindow = false;
+            }
+            
+            return update(stats.frameTime);
+        }
+        
+        float resolutionController::update(double frameTime)
+        {
+            accumulatedTime += frameTime;
+            frames ++;
+            
+            if(frames < MAX(windowFrames, 1))
+                return scale;
+            
+            double average = accumulatedTime / frames;
+            
+            accumulatedTime = 0.0;
+            frames = 0;
+            
+            if(average > budget)
+            {
+                // Lower the resolution as soon as a window is over budget
+                scale = MAX(scale - step, minScale);
+                fastWindows = 0;
+            }
+            else if(average < budget * raiseThreshold)
+            {
+                if(++ fastWindows >= raiseWindows)
+                {
+                    scale = MIN(scale + step, maxScale);
+                    fastWindows = 0;
+                }
+            }
+            else
+            {
+                fastWindows = 0;
+            }
+            
+            return scale;
+        }
+        
+        
+        float resolutionController::getScale()
+        {
+            return scale;
+        }
+        
+        void resolutionController::setScale(float tscale)
+        {
+            scale = MIN(MAX(tscale, minScale), maxScale);
+            resetWindow();
+        }
+        
+        void resolutionController::resetWindow()
+        {
+            accumulatedTime = 0.0;
+            frames      = 0;
+            fastWindows = 0;
+        }
+    }
+}
@@ -21,7 +21,9 @@ namespace vi
         {
             defaultShaderTexture /** <Texture shader**/,
             defaultShaderSprite /** <Sprite shader**/,
-            defaultShaderParticle
+            defaultShaderParticle,
+            defaultShaderTextureArray /** <Texture shader sampling a vi::graphic::textureArray, requires a OpenGL 3.2 Core Profile context**/,
+            defaultShaderColor /** <Shader without texture that only uses the premultiplied vertex color, used by vi::graphic::debugDraw**/
         } defaultShader;
         
         /**
@@ -56,11 +58,25 @@ namespace vi
              **/
             static shader *getDefaultShader();
             
+            /**
+             * Returns the name of the vertex shader file the shader was created from.
+             **/
+            std::string const& getVertexFile();
+            /**
+             * Returns the name of the fragment shader file the shader was created from.
+             **/
+            std::string const& getFragmentFile();
+            
             
             /**
              * Handle to the OpenGL program
              **/
             GLuint program;
+            /**
+             * A number that is unique to every created program. Unlike the program handle or the address of the shader, it isn't reused after the
+             * shader was deleted, so it can be used to tell apart state cached for an older shader.
+             **/
+            uint32_t generation;
         
             /**
              * Projection matrix location.
@@ -112,6 +128,9 @@ namespace vi
             
             void generateShaderFromPaths(std::string vertexFile, std::string fragmentFile);
             void getUniforms();
+            
+            std::string vertexName;
+            std::string fragmentName;
         };
     }
 }
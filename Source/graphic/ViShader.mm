@@ -15,6 +15,8 @@ namespace vi
 {
     namespace graphic
     {
+        static uint32_t shaderGeneration = 0;
+        
         shader::shader(std::string vertexFile, std::string fragmentFile)
         {            
             generateShaderFromPaths(vertexFile, fragmentFile);
@@ -36,6 +38,14 @@ namespace vi
                     generateShaderFromPaths("/Vinter.bundle/Shaders/ViParticleShader.vsh", "/Vinter.bundle/Shaders/ViParticleShader.fsh");
                     break;
                     
+                case defaultShaderTextureArray:
+                    generateShaderFromPaths("/Vinter.bundle/Shaders/ViTextureArrayShader.vsh", "/Vinter.bundle/Shaders/ViTextureArrayShader.fsh");
+                    break;
+                    
+                case defaultShaderColor:
+                    generateShaderFromPaths("/Vinter.bundle/Shaders/ViColorShader.vsh", "/Vinter.bundle/Shaders/ViColorShader.fsh");
+                    break;
+                    
                 default:
                     throw "Unknown default shader!";
                     break;
@@ -58,12 +68,25 @@ namespace vi
             return contextShader;
         }
         
+        std::string const& shader::getVertexFile()
+        {
+            return vertexName;
+        }
+        
+        std::string const& shader::getFragmentFile()
+        {
+            return fragmentName;
+        }
+        
         
         
         void shader::generateShaderFromPaths(std::string vertexFile, std::string fragmentFile)
         {
             bool result;
             
+            vertexName   = vertexFile;
+            fragmentName = fragmentFile;
+            
             matProj = -1;
             matView = -1;
             matModel = -1;
@@ -74,6 +97,7 @@ namespace vi
             texcoord1 = -1;
             
             program = -1;
+            generation = ++ shaderGeneration;
             
             @autoreleasepool
             {
@@ -7,6 +7,7 @@
 //
 
 #include <string>
+#include <vector>
 #import "ViBase.h"
 #import "ViAsset.h"
 
@@ -23,6 +24,11 @@ namespace vi
 {
     namespace graphic
     {
+        class textureAtlas;
+        class rendererSoftware;
+        class renderTrace;
+        class textureArray;
+        
         typedef enum
         {
             /**
@@ -63,6 +69,10 @@ namespace vi
          **/
         class texture : public vi::common::asset
         {
+            friend class textureAtlas;
+            friend class rendererSoftware;
+            friend class renderTrace;
+            friend class textureArray;
         public:
             /**
              * Constructor for an empty or already loaded texture, depending on _name
@@ -75,6 +85,19 @@ namespace vi
              * Constructor for an texture which is loaded from the main bundle
              **/
             texture(std::string name);
+            /**
+             * Constructor for an texture which is loaded from the main bundle, with control over when the image is uploaded.
+             * @param upload If false, the image is only decoded and no OpenGL command is issued, which allows decoding the texture on a thread without
+             * an active context. The decoded image is kept in memory until upload() is invoked.
+             * @sa vi::common::uploadQueue
+             **/
+            texture(std::string name, bool upload);
+            /**
+             * Constructor for an texture which is loaded from the main bundle, with control over when the image is uploaded and whether it keeps its pixels.
+             * @param keepPixelData Used instead of the value of setKeepsPixelData(), so that the setting doesn't have to be read on another thread.
+             * @sa vi::common::uploadQueue
+             **/
+            texture(std::string name, bool upload, bool keepPixelData);
             /**
              * Constructor for an texture from an Core Graphics image
              * @param factor The scale factor of the texture
@@ -96,10 +119,19 @@ namespace vi
 #endif
             virtual ~texture();
             
+            /**
+             * Uploads the decoded image of a texture that was created without being uploaded. Does nothing if the texture is already uploaded.
+             **/
+            virtual void upload();
+            
             /**
              * Returns the handle to the texture
              **/
             GLuint getTexture();
+            /**
+             * Returns the target the texture has to be bound to, GL_TEXTURE_2D for all textures except vi::graphic::textureArray.
+             **/
+            virtual GLenum getTarget();
             
             /**
              * Returns the width of the texture
@@ -109,18 +141,70 @@ namespace vi
              * Returns the height of the texture
              **/
             uint32_t getHeight();
+            /**
+             * Returns true if the texture has an alpha channel. Textures created from a handle are assumed to have one.
+             **/
+            bool hasAlphaChannel();
+            /**
+             * Returns the premultiplied RGBA pixels of the texture with the first row at the texture coordinate 0, or NULL if the texture doesn't keep its pixels.
+             * @sa setKeepsPixelData()
+             **/
+            const uint8_t *getPixelData();
+            /**
+             * Frees the pixels that were kept in main memory.
+             * @sa setKeepsPixelData()
+             **/
+            void purgePixelData();
+            /**
+             * Returns the scale factor of the texture, the size of the texture in pixels is its size in points multiplied with the scale factor.
+             **/
+            float getScaleFactor();
+            
+            /**
+             * Tells renderers that compare frames, eg. the partial redraw of vi::graphic::commandRenderer, that the pixels of the texture changed. This
+             * is done automatically when a camera renders into the texture, or when a texture atlas or texture array copies an image into it.
+             **/
+            void setNeedsContentUpdate();
+            /**
+             * Returns a number that is incremented every time the pixels of the texture change.
+             * @sa setNeedsContentUpdate()
+             **/
+            uint32_t getContentRevision();
+            /**
+             * Returns a number that is incremented every time the pixels of any texture change, which lets cameras that render on demand skip the
+             * scene without looking at every texture it uses.
+             * @sa setNeedsContentUpdate()
+             **/
+            static uint32_t getGlobalContentRevision();
             
             /**
              * Sets the default texture format for textures with alpha channel.
              **/
             static void setDefaultFormat(vi::graphic::textureFormat format);
+            /**
+             * If set to true, textures that are created from images afterwards keep a copy of their pixels in main memory, which is used by
+             * vi::graphic::rendererSoftware. The default is false.
+             **/
+            static void setKeepsPixelData(bool keeps);
+            /**
+             * Returns true if textures that are created from images keep a copy of their pixels.
+             **/
+            static bool getKeepsPixelData();
             
         protected:                     
+            void loadImage(std::string const& name, bool upload);
             void generateTextureFromImage(CGImageRef imageRef, float factor);
             void generateTextureFromData(void *data, vi::graphic::textureFormat format);
+            void *decodeImage(CGImageRef imageRef, float factor, vi::graphic::textureFormat& format);
+            
+            void *pendingData;
+            vi::graphic::textureFormat pendingFormat;
+            std::vector<uint8_t> pixelData;
             
             bool ownsHandle;
             bool containsAlpha;
+            bool keepsPixels;
+            uint32_t contentRevision;
             GLuint name;
             
             uint32_t width, height;
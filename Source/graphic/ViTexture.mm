@@ -15,12 +15,18 @@ namespace vi
     namespace graphic
     {
         static vi::graphic::textureFormat defaultAlphaFormat = textureFormatRGBA8888;
+        static bool keepsPixelData = false;
+        static uint32_t globalContentRevision = 0;
         
         
         texture::texture(GLuint _name, uint32_t _width, uint32_t _height)
         {
             width = _width;
             height = _height;
+            scaleFactor = 1.0f;
+            pendingData = NULL;
+            keepsPixels = keepsPixelData;
+            contentRevision = 0;
             
             if(_name == -1)
             {
@@ -42,18 +48,49 @@ namespace vi
             {
                 name = _name;
                 ownsHandle = false;
-                containsAlpha = false;
+                containsAlpha = true;
             }
         }
         
         texture::texture(std::string name)
         {
-            std::string path = vi::common::dataPool::pathForFile(name);
+            keepsPixels = keepsPixelData;
+            contentRevision = 0;
+            loadImage(name, true);
+        }
+        
+        texture::texture(std::string name, bool upload)
+        {
+            keepsPixels = keepsPixelData;
+            contentRevision = 0;
+            loadImage(name, upload);
+        }
+        
+        texture::texture(std::string name, bool upload, bool keepPixelData)
+        {
+            keepsPixels = keepPixelData;
+            contentRevision = 0;
+            loadImage(name, upload);
+        }
+        
+        texture::texture(CGImageRef image, float factor)
+        {
+            pendingData = NULL;
+            keepsPixels = keepsPixelData;
+            contentRevision = 0;
             
+            generateTextureFromImage(image, factor);
+        }
+        
 #ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
-            NSImage *image = [[NSImage alloc] initWithContentsOfFile:[NSString stringWithUTF8String:path.c_str()]];
+        texture::texture(NSImage *image)
+        {
             if(!image)
-                throw "No such image found!";
+                throw "Trying to generate a texture from nothing!";
+            
+            pendingData = NULL;
+            keepsPixels = keepsPixelData;
+            contentRevision = 0;
             
             CGImageSourceRef source = CGImageSourceCreateWithData((CFDataRef)[image TIFFRepresentation], NULL);
             CGImageRef imageRef =  CGImageSourceCreateImageAtIndex(source, 0, NULL);
@@ -62,60 +99,80 @@ namespace vi
             
             CFRelease(source);
             CFRelease(imageRef);
+        }
 #endif
 #ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
-            UIImage *image = [[UIImage alloc] initWithContentsOfFile:[NSString stringWithUTF8String:path.c_str()]];
+        texture::texture(UIImage *image)
+        {
             if(!image)
-                throw "No such image found!";
+                throw "Trying to generate a texture from nothing!";
             
             float scale = 1.0f;
+            pendingData = NULL;
+            keepsPixels = keepsPixelData;
+            contentRevision = 0;
+            
             if([image respondsToSelector:@selector(scale)])
                 scale = [image scale];
             
             generateTextureFromImage([image CGImage], scale);
-#endif
-            
-            [image release];
         }
+#endif
         
-        texture::texture(CGImageRef image, float factor)
-        {
-            generateTextureFromImage(image, factor);
-        }
         
-#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
-        texture::texture(NSImage *image)
+        
+        void texture::loadImage(std::string const& name, bool upload)
         {
+            std::string path = vi::common::dataPool::pathForFile(name);
+            
+            pendingData = NULL;
+            ownsHandle  = false;
+            this->name  = 0;
+            
+#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+            NSImage *image = [[NSImage alloc] initWithContentsOfFile:[NSString stringWithUTF8String:path.c_str()]];
             if(!image)
-                throw "Trying to generate a texture from nothing!";
+                throw "No such image found!";
             
             CGImageSourceRef source = CGImageSourceCreateWithData((CFDataRef)[image TIFFRepresentation], NULL);
             CGImageRef imageRef =  CGImageSourceCreateImageAtIndex(source, 0, NULL);
             
-            generateTextureFromImage(imageRef, 1.0f);
+            if(upload)
+                generateTextureFromImage(imageRef, 1.0f);
+            else
+                pendingData = decodeImage(imageRef, 1.0f, pendingFormat);
             
             CFRelease(source);
             CFRelease(imageRef);
-        }
 #endif
 #ifdef __IPHONE_OS_VERSION_MAX_ALLOWED
-        texture::texture(UIImage *image)
-        {
+            UIImage *image = [[UIImage alloc] initWithContentsOfFile:[NSString stringWithUTF8String:path.c_str()]];
             if(!image)
-                throw "Trying to generate a texture from nothing!";
+                throw "No such image found!";
             
             float scale = 1.0f;
-            
             if([image respondsToSelector:@selector(scale)])
                 scale = [image scale];
             
-            generateTextureFromImage([image CGImage], scale);
-        }
+            if(upload)
+                generateTextureFromImage([image CGImage], scale);
+            else
+                pendingData = decodeImage([image CGImage], scale, pendingFormat);
 #endif
-        
-
+            
+            [image release];
+        }
         
         void texture::generateTextureFromImage(CGImageRef imageRef, float factor)
+        {
+            vi::graphic::textureFormat format;
+            void *data = decodeImage(imageRef, factor, format);
+            
+            generateTextureFromData(data, format);
+            free(data);
+        }
+        
+        void *texture::decodeImage(CGImageRef imageRef, float factor, vi::graphic::textureFormat& format)
         {
             if(!imageRef)
                 throw "CGImageRef must not be NULL!";
@@ -156,6 +213,18 @@ namespace vi
             
             CFRelease(colorSpace);
             
+            if(keepsPixels)
+            {
+                pixelData.assign((uint8_t *)data, (uint8_t *)data + width * height * 4);
+                
+                // Images without alpha channel leave the alpha byte undefined
+                if(!containsAlpha)
+                {
+                    for(uint32_t i=3; i<pixelData.size(); i+=4)
+                        pixelData[i] = 255;
+                }
+            }
+            
             
             if(pixelFormat == textureFormatRGB565) 
             {
@@ -287,10 +356,10 @@ namespace vi
             }
             
             
-            generateTextureFromData(data, pixelFormat);
-            
             CFRelease(context);
-            free(data);
+            
+            format = pixelFormat;
+            return data;
         }
         
         void texture::generateTextureFromData(void *data, vi::graphic::textureFormat format)
@@ -346,6 +415,21 @@ namespace vi
         {
             if(ownsHandle)
                 glDeleteTextures(1, &name);
+            
+            if(pendingData)
+                free(pendingData);
+        }
+        
+        
+        void texture::upload()
+        {
+            if(pendingData)
+            {
+                generateTextureFromData(pendingData, pendingFormat);
+                
+                free(pendingData);
+                pendingData = NULL;
+            }
         }
         
         
@@ -354,6 +438,47 @@ namespace vi
             return name;
         }
         
+        GLenum texture::getTarget()
+        {
+            return GL_TEXTURE_2D;
+        }
+        
+        bool texture::hasAlphaChannel()
+        {
+            return containsAlpha;
+        }
+        
+        const uint8_t *texture::getPixelData()
+        {
+            return pixelData.size() > 0 ? &pixelData[0] : NULL;
+        }
+        
+        void texture::purgePixelData()
+        {
+            std::vector<uint8_t>().swap(pixelData);
+        }
+        
+        float texture::getScaleFactor()
+        {
+            return scaleFactor;
+        }
+        
+        void texture::setNeedsContentUpdate()
+        {
+            contentRevision ++;
+            globalContentRevision ++;
+        }
+        
+        uint32_t texture::getContentRevision()
+        {
+            return contentRevision;
+        }
+        
+        uint32_t texture::getGlobalContentRevision()
+        {
+            return globalContentRevision;
+        }
+        
         uint32_t texture::getWidth()
         {
             return width / scaleFactor;
@@ -366,6 +491,16 @@ namespace vi
         
         
         
+        void texture::setKeepsPixelData(bool keeps)
+        {
+            keepsPixelData = keeps;
+        }
+        
+        bool texture::getKeepsPixelData()
+        {
+            return keepsPixelData;
+        }
+        
         void texture::setDefaultFormat(vi::graphic::textureFormat format)
         {
             if(format > textureFormatRGBA5551)
@@ -0,0 +1,87 @@
+//
+//  ViTextureArray.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#import "ViBase.h"
+#import "ViTexture.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief A GL_TEXTURE_2D_ARRAY made of equally sized textures
+         *
+         * A texture array copies textures of the same size into the layers of one array texture. Meshes that sample the array with the
+         * vi::graphic::defaultShaderTextureArray shader select the layer per vertex, so quads using different source textures can be drawn with a single
+         * draw call. Sprite batches automatically switch to this shader when they use a texture array, see vi::scene::spriteBatch::setTexture() and
+         * vi::scene::sprite::setTextureLayer().
+         * The layer is stored in the texture coordinates of the vertices as u + layerOffset(layer), which requires u to be in the range of 0 to 1 and
+         * floating point texture coordinates. The renderer takes care of the latter for sprite batches.
+         * @remark Texture arrays require a OpenGL 3.2 Core Profile context and aren't supported by vi::graphic::rendererSoftware.
+         **/
+        class textureArray : public texture
+        {
+        public:
+            /**
+             * Constructor for an empty texture array.
+             * @param width The width of the layers in pixels
+             * @param height The height of the layers in pixels
+             * @param capacity The number of layers, all layers are allocated upfront.
+             * @param factor The scale factor of the textures that are added
+             * @remark Throws an exception if texture arrays aren't supported.
+             **/
+            textureArray(uint32_t width, uint32_t height, uint32_t capacity, float factor=1.0f);
+            /**
+             * Destructor.
+             **/
+            virtual ~textureArray();
+            
+            /**
+             * Returns GL_TEXTURE_2D_ARRAY.
+             **/
+            virtual GLenum getTarget();
+            
+            /**
+             * Copies the given texture into the next free layer and returns the layer, or the layer of the texture if it was already added.
+             * @return The layer of the texture, or -1 if the array is full, the size of the texture doesn't match the size of the layers or the texture
+             * can't be copied, which is the case for compressed textures.
+             * @remark The array only copies the pixels of the texture, which can be deleted afterwards as long as it isn't passed to getLayer() anymore.
+             **/
+            int32_t addTexture(vi::graphic::texture *texture);
+            /**
+             * Returns the layer of the given texture or -1 if the texture wasn't added.
+             **/
+            int32_t getLayer(vi::graphic::texture *texture);
+            
+            /**
+             * Returns the number of used layers.
+             **/
+            uint32_t getLayerCount();
+            /**
+             * Returns the number of layers the array can hold.
+             **/
+            uint32_t getCapacity();
+            
+            /**
+             * Returns true if the active context supports texture arrays.
+             **/
+            static bool isSupported();
+            /**
+             * Returns the value that is added to the u texture coordinate of a vertex to select the given layer.
+             **/
+            static GLfloat layerOffset(uint32_t layer);
+            
+        private:
+            uint32_t capacity;
+            GLuint framebuffer;
+            
+            std::vector<vi::graphic::texture *> layers;
+        };
+    }
+}
@@ -0,0 +1,149 @@
+//
+//  ViTextureArray.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViTextureArray.h"
+#import "ViContext.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        textureArray::textureArray(uint32_t twidth, uint32_t theight, uint32_t tcapacity, float factor) :
+            texture(0, twidth, theight)
+        {
+            capacity = tcapacity;
+            scaleFactor = factor;
+            framebuffer = 0;
+            
+            if(!isSupported())
+                throw "Texture arrays require a OpenGL 3.2 Core Profile context!";
+            
+#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+            glGenTextures(1, &name);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, name);
+            
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            
+            ownsHandle = true;
+#endif
+        }
+        
+        textureArray::~textureArray()
+        {
+            if(framebuffer)
+                glDeleteFramebuffers(1, &framebuffer);
+        }
+        
+        
+        GLenum textureArray::getTarget()
+        {
+#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+            return GL_TEXTURE_2D_ARRAY;
+#else
+            return GL_TEXTURE_2D;
+#endif
+        }
+        
+        
+        int32_t textureArray::addTexture(vi::graphic::texture *texture)
+        {
+            int32_t layer = getLayer(texture);
+            if(layer != -1)
+                return layer;
+            
+            if(layers.size() >= capacity)
+            {
+                ViLog(@"Can't add texture, the texture array is full!");
+                return -1;
+            }
+            
+            if(texture->getTarget() != GL_TEXTURE_2D || texture->width != width || texture->height != height)
+            {
+                ViLog(@"Can't add texture, its size doesn't match the size of the texture array!");
+                return -1;
+            }
+            
+#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+            texture->upload();
+            
+            // Copy the texture into the layer by reading it back from a framebuffer it is attached to
+            GLint prevBuffer;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevBuffer);
+            
+            if(!framebuffer)
+                glGenFramebuffers(1, &framebuffer);
+            
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->name, 0);
+            
+            bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+            if(complete)
+            {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, name);
+                glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layers.size(), 0, 0, width, height);
+                setNeedsContentUpdate();
+            }
+            
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, prevBuffer);
+            
+            if(!complete)
+            {
+                ViLog(@"Can't add texture, it can't be copied into the texture array!");
+                return -1;
+            }
+            
+            layers.push_back(texture);
+            return (int32_t)layers.size() - 1;
+#else
+            return -1;
+#endif
+        }
+        
+        int32_t textureArray::getLayer(vi::graphic::texture *texture)
+        {
+            for(uint32_t i=0; i<layers.size(); i++)
+            {
+                if(layers[i] == texture)
+                    return (int32_t)i;
+            }
+            
+            return -1;
+        }
+        
+        
+        uint32_t textureArray::getLayerCount()
+        {
+            return (uint32_t)layers.size();
+        }
+        
+        uint32_t textureArray::getCapacity()
+        {
+            return capacity;
+        }
+        
+        
+        bool textureArray::isSupported()
+        {
+#ifdef __MAC_OS_X_VERSION_MAX_ALLOWED
+            vi::common::context *context = vi::common::context::getActiveContext();
+            return (context && context->getGLSLVersion() >= 150);
+#else
+            return false;
+#endif
+        }
+        
+        GLfloat textureArray::layerOffset(uint32_t layer)
+        {
+            return 2.0f * layer;
+        }
+    }
+}
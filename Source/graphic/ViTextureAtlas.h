@@ -0,0 +1,153 @@
+//
+//  ViTextureAtlas.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#include <string>
+#include <map>
+#import "ViBase.h"
+#import "ViTexture.h"
+#import "ViVector2.h"
+#import "ViAlphaHull.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        /**
+         * @brief A rectangular part of a texture atlas page
+         *
+         * Regions are returned by a vi::graphic::textureAtlas and can be passed to vi::scene::sprite::setTextureRegion() or
+         * vi::scene::spriteBatch::addSprite(). Sprites using regions of the same page can be drawn with one draw call when they are part of the same sprite batch.
+         **/
+        class textureRegion
+        {
+        public:
+            /**
+             * Constructor for an empty region
+             **/
+            textureRegion();
+            /**
+             * Constructor
+             **/
+            textureRegion(vi::graphic::texture *page, vi::common::vector2 const& origin, vi::common::vector2 const& size);
+
+            /**
+             * The page texture that contains the region, owned by the atlas.
+             **/
+            vi::graphic::texture *page;
+            /**
+             * The origin of the region in points
+             **/
+            vi::common::vector2 origin;
+            /**
+             * The size of the region in points
+             **/
+            vi::common::vector2 size;
+            /**
+             * A convex polygon around the visible pixels of the region, normalized to the size of the region with y pointing down. Sprites draw the
+             * polygon instead of a quad if it isn't empty.
+             * @sa vi::graphic::alphaHull
+             **/
+            std::vector<vi::common::vector2> hull;
+        };
+
+        /**
+         * @brief Packs textures into larger textures at runtime
+         *
+         * A texture atlas copies textures into one or more large page textures using a skyline bottom left packer, so that sprites with different images
+         * can share one texture and therefore one material and one draw call. A new page is created when a texture doesn't fit into any of the existing pages.
+         * @remark The atlas must be used with the context that is active when the pages are created. Textures with a different scale factor than the atlas
+         * are copied pixel by pixel and will therefore appear in a different size.
+         * @remark If the added textures keep their pixel data (see vi::graphic::texture::setKeepsPixelData()), the atlas generates an alpha hull for
+         * every region which saves enough transparent pixels. Images added with addImage() always keep their pixels until they are copied.
+         **/
+        class textureAtlas
+        {
+        public:
+            /**
+             * Constructor
+             * @param width The width of the pages in pixels
+             * @param height The height of the pages in pixels
+             * @param padding The number of transparent pixels between two regions, avoids bleeding when the sprites are scaled.
+             * @param factor The scale factor of the pages
+             **/
+            textureAtlas(uint32_t width=1024, uint32_t height=1024, uint32_t padding=2, float factor=1.0f);
+            /**
+             * Destructor, deletes all pages.
+             **/
+            ~textureAtlas();
+
+            /**
+             * Copies the content of the texture into the atlas and returns the region it was placed into. Textures that were created without being
+             * uploaded are uploaded first.
+             * @remark The texture isn't needed by the atlas afterwards and can be deleted.
+             **/
+            vi::graphic::textureRegion addTexture(vi::graphic::texture *texture);
+            /**
+             * Loads the image with the given name and copies it into the atlas. If the image was already added, its existing region is returned.
+             **/
+            vi::graphic::textureRegion addImage(std::string const& name);
+            /**
+             * Returns true if an image with the given name was added to the atlas and stores its region in region.
+             **/
+            bool getRegion(std::string const& name, vi::graphic::textureRegion& region);
+
+            /**
+             * Sets the parameters for the alpha hulls of regions that are added afterwards.
+             * @param maxVertices The maximum number of vertices of a hull, 0 disables the generation of hulls.
+             * @param maxCoverage Hulls are only kept if they cover less than this fraction of their region.
+             * @sa vi::graphic::alphaHull::generate()
+             **/
+            void setHullGeneration(uint32_t maxVertices, float maxCoverage);
+
+            /**
+             * Returns the number of pages
+             **/
+            uint32_t getPageCount();
+            /**
+             * Returns the page at the given index
+             **/
+            vi::graphic::texture *getPage(uint32_t index);
+
+        private:
+            /**
+             * @cond
+             **/
+            typedef struct
+            {
+                uint32_t x, y;
+                uint32_t width;
+            } skylineNode;
+
+            typedef struct
+            {
+                vi::graphic::texture *texture;
+                std::vector<skylineNode> skyline;
+            } atlasPage;
+            /**
+             * @endcond
+             **/
+
+            bool findPosition(atlasPage& page, uint32_t width, uint32_t height, uint32_t& x, uint32_t& y, size_t& index);
+            void insertNode(atlasPage& page, size_t index, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+            atlasPage& createPage();
+
+            uint32_t pageWidth, pageHeight;
+            uint32_t padding;
+            float scaleFactor;
+
+            uint32_t maxHullVertices;
+            float maxHullCoverage;
+
+            GLuint framebuffer;
+
+            std::vector<atlasPage> pages;
+            std::map<std::string, vi::graphic::textureRegion> namedRegions;
+        };
+    }
+}
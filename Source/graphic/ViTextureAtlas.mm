@@ -0,0 +1,286 @@
+//
+//  ViTextureAtlas.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViTextureAtlas.h"
+
+namespace vi
+{
+    namespace graphic
+    {
+        textureRegion::textureRegion()
+        {
+            page = NULL;
+        }
+
+        textureRegion::textureRegion(vi::graphic::texture *tpage, vi::common::vector2 const& torigin, vi::common::vector2 const& tsize)
+        {
+            page   = tpage;
+            origin = torigin;
+            size   = tsize;
+        }
+
+
+
+        textureAtlas::textureAtlas(uint32_t width, uint32_t height, uint32_t tpadding, float factor)
+        {
+            pageWidth   = width;
+            pageHeight  = height;
+            padding     = tpadding;
+            scaleFactor = factor;
+            framebuffer = 0;
+
+            maxHullVertices = 8;
+            maxHullCoverage = 0.8f;
+        }
+
+        textureAtlas::~textureAtlas()
+        {
+            std::vector<atlasPage>::iterator iterator;
+            for(iterator=pages.begin(); iterator!=pages.end(); iterator++)
+            {
+                delete (*iterator).texture;
+            }
+
+            if(framebuffer)
+                glDeleteFramebuffers(1, &framebuffer);
+        }
+
+
+
+        vi::graphic::textureRegion textureAtlas::addTexture(vi::graphic::texture *texture)
+        {
+            if(texture->scaleFactor != scaleFactor)
+                ViLog(@"Adding texture with scale factor %f to texture atlas with scale factor %f!", texture->scaleFactor, scaleFactor);
+
+            uint32_t width  = texture->width + padding;
+            uint32_t height = texture->height + padding;
+
+            if(width > pageWidth || height > pageHeight)
+                throw "Texture is too large for the texture atlas!";
+
+            // A texture that was only decoded has no storage yet that could be attached to the framebuffer
+            texture->upload();
+
+            atlasPage *page = NULL;
+            uint32_t x, y;
+            size_t index;
+
+            std::vector<atlasPage>::iterator iterator;
+            for(iterator=pages.begin(); iterator!=pages.end(); iterator++)
+            {
+                if(findPosition(*iterator, width, height, x, y, index))
+                {
+                    page = &(*iterator);
+                    break;
+                }
+            }
+
+            if(!page)
+            {
+                page = &createPage();
+                findPosition(*page, width, height, x, y, index);
+            }
+
+            insertNode(*page, index, x, y, width, height);
+
+
+            // Copy the texture into the page by reading it back from a framebuffer it is attached to
+            GLint prevBuffer;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevBuffer);
+
+            if(!framebuffer)
+                glGenFramebuffers(1, &framebuffer);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->name, 0);
+
+            glBindTexture(GL_TEXTURE_2D, page->texture->name);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, x, y, 0, 0, texture->width, texture->height);
+            page->texture->setNeedsContentUpdate();
+
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, prevBuffer);
+
+            vi::graphic::textureRegion region(page->texture, vi::common::vector2(x / scaleFactor, y / scaleFactor), vi::common::vector2(texture->width / scaleFactor, texture->height / scaleFactor));
+
+            if(maxHullVertices > 0 && texture->getPixelData())
+                vi::graphic::alphaHull::generate(texture->getPixelData(), texture->width, texture->height, texture->width, region.hull, maxHullVertices, maxHullCoverage);
+
+            return region;
+        }
+
+        vi::graphic::textureRegion textureAtlas::addImage(std::string const& name)
+        {
+            vi::graphic::textureRegion region;
+            if(getRegion(name, region))
+                return region;
+
+            // The pixels are kept around for the hull of the region, the texture is deleted right after it was copied into the page anyway
+            vi::graphic::texture *texture = new vi::graphic::texture(name, true, true);
+
+            try
+            {
+                region = addTexture(texture);
+            }
+            catch(const char *exception)
+            {
+                delete texture;
+                throw exception;
+            }
+
+            delete texture;
+
+            namedRegions[name] = region;
+            return region;
+        }
+
+        bool textureAtlas::getRegion(std::string const& name, vi::graphic::textureRegion& region)
+        {
+            std::map<std::string, vi::graphic::textureRegion>::iterator iterator = namedRegions.find(name);
+            if(iterator == namedRegions.end())
+                return false;
+
+            region = iterator->second;
+            return true;
+        }
+
+
+
+        void textureAtlas::setHullGeneration(uint32_t maxVertices, float maxCoverage)
+        {
+            maxHullVertices = maxVertices;
+            maxHullCoverage = maxCoverage;
+        }
+
+
+
+        uint32_t textureAtlas::getPageCount()
+        {
+            return (uint32_t)pages.size();
+        }
+
+        vi::graphic::texture *textureAtlas::getPage(uint32_t index)
+        {
+            return pages[index].texture;
+        }
+
+
+
+        textureAtlas::atlasPage& textureAtlas::createPage()
+        {
+            atlasPage page;
+            page.texture = new vi::graphic::texture(-1, pageWidth, pageHeight);
+            page.texture->scaleFactor = scaleFactor;
+
+            skylineNode node;
+            node.x = 0;
+            node.y = 0;
+            node.width = pageWidth;
+
+            page.skyline.push_back(node);
+            pages.push_back(page);
+
+            return pages.back();
+        }
+
+        bool textureAtlas::findPosition(atlasPage& page, uint32_t width, uint32_t height, uint32_t& x, uint32_t& y, size_t& index)
+        {
+            uint32_t bestBottom = UINT32_MAX;
+            uint32_t bestWidth  = UINT32_MAX;
+            bool found = false;
+
+            for(size_t i=0; i<page.skyline.size(); i++)
+            {
+                uint32_t left = page.skyline[i].x;
+                if(left + width > pageWidth)
+                    break;
+
+                // The rectangle rests on the highest node it spans
+                uint32_t top = 0;
+                uint32_t remaining = width;
+                bool fits = true;
+
+                for(size_t j=i; remaining > 0; j++)
+                {
+                    skylineNode& node = page.skyline[j];
+
+                    top = MAX(top, node.y);
+                    if(top + height > pageHeight)
+                    {
+                        fits = false;
+                        break;
+                    }
+
+                    remaining -= MIN(remaining, node.width);
+                }
+
+                if(!fits)
+                    continue;
+
+                uint32_t bottom = top + height;
+                if(bottom < bestBottom || (bottom == bestBottom && page.skyline[i].width < bestWidth))
+                {
+                    bestBottom = bottom;
+                    bestWidth  = page.skyline[i].width;
+
+                    x = left;
+                    y = top;
+                    index = i;
+                    found = true;
+                }
+            }
+
+            return found;
+        }
+
+        void textureAtlas::insertNode(atlasPage& page, size_t index, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+        {
+            skylineNode node;
+            node.x = x;
+            node.y = y + height;
+            node.width = width;
+
+            page.skyline.insert(page.skyline.begin() + index, node);
+
+            // Shrink or remove the nodes that are now covered by the new node
+            for(size_t i=index + 1; i<page.skyline.size();)
+            {
+                skylineNode& previous = page.skyline[i - 1];
+                skylineNode& current  = page.skyline[i];
+
+                uint32_t end = previous.x + previous.width;
+                if(current.x >= end)
+                    break;
+
+                uint32_t shrink = end - current.x;
+                if(current.width <= shrink)
+                {
+                    page.skyline.erase(page.skyline.begin() + i);
+                    continue;
+                }
+
+                current.x += shrink;
+                current.width -= shrink;
+                break;
+            }
+
+            // Merge neighbouring nodes on the same height
+            for(size_t i=0; i+1<page.skyline.size();)
+            {
+                if(page.skyline[i].y == page.skyline[i + 1].y)
+                {
+                    page.skyline[i].width += page.skyline[i + 1].width;
+                    page.skyline.erase(page.skyline.begin() + i + 1);
+                    continue;
+                }
+
+                i ++;
+            }
+        }
+    }
+}
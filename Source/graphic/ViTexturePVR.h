@@ -7,6 +7,7 @@
 //
 
 #include <string>
+#include <vector>
 #import "ViBase.h"
 #import "ViTexture.h"
 
@@ -47,13 +48,28 @@ namespace vi
              * @remark The function uses vi::common::dataPool::pathForFile() to get the path for the file.
              **/
             texturePVR(std::string name);
+            /**
+             * Constructor with control over when the texture is uploaded.
+             * @param upload If false, the file is only read and parsed without issuing any OpenGL command. The data is kept in memory until upload() is invoked.
+             * @sa vi::common::uploadQueue
+             **/
+            texturePVR(std::string name, bool upload);
+            
+            /**
+             * Uploads the parsed PVR data, does nothing if the texture is already uploaded.
+             **/
+            virtual void upload();
             
         private:
             uint32_t mipMaps;
+            uint32_t formatIndex;
             texturePVRMipMap mipMap[ViTexturePVRMaxMipsMaps];
             
+            std::vector<uint8_t> pvrData;
+            bool pendingUpload;
             
-            bool generateTextureFromPVRData(const void *data, size_t length);
+            void loadPVR(std::string const& name, bool upload);
+            bool parsePVRData(const void *data, size_t length);
         };
     }
 }
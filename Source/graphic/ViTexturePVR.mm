@@ -95,6 +95,16 @@ namespace vi
 #define PVRFormatTableSize (sizeof(PVRFormatTable) / sizeof(PVRFormatTable[0]))
         
         texturePVR::texturePVR(std::string name) : vi::graphic::texture(0, 0, 0)
+        {
+            loadPVR(name, true);
+        }
+        
+        texturePVR::texturePVR(std::string name, bool upload) : vi::graphic::texture(0, 0, 0)
+        {
+            loadPVR(name, upload);
+        }
+        
+        void texturePVR::loadPVR(std::string const& name, bool upload)
         {
             std::string _path = vi::common::dataPool::pathForFile(name);
             
@@ -105,24 +115,43 @@ namespace vi
             ViLog(@"Trying to instantiate texturePVR on Mac OS X, are you sure that you want to do this?");
 #endif
                 
+            // Throwing inside of the pool would skip draining it, so the exception is raised afterwards
+            bool valid = false;
+            
             @autoreleasepool
             {
                 NSString *path = [NSString stringWithUTF8String:_path.c_str()];
                 NSData *data = [NSData dataWithContentsOfFile:path];
                 
-                scaleFactor = ([[path lastPathComponent] rangeOfString:@"@2x" options:NSBackwardsSearch].location != NSNotFound) ? 2.0f : 1.0f;
-                generateTextureFromPVRData([data bytes], [data length]);
+                if(data && [data length] >= sizeof(PVRTextureHeader))
+                {
+                    const uint8_t *bytes = (const uint8_t *)[data bytes];
+                    
+                    scaleFactor = ([[path lastPathComponent] rangeOfString:@"@2x" options:NSBackwardsSearch].location != NSNotFound) ? 2.0f : 1.0f;
+                    pvrData.assign(bytes, bytes + [data length]);
+                    
+                    valid = true;
+                }
             }
+            
+            if(!valid)
+                throw "Invalid PVR file!";
+            
+            // The mip maps point into the pvrData, which is kept until the texture is uploaded
+            pendingUpload = parsePVRData(&pvrData[0], pvrData.size());
+            
+            if(upload)
+                this->upload();
         }
         
-        bool texturePVR::generateTextureFromPVRData(const void *data, size_t length)
+        bool texturePVR::parsePVRData(const void *data, size_t length)
         {
             PVRTextureHeader *header;
             uint32_t flags, pvrTag;
             uint32_t dataLength = 0, dataOffset = 0, dataSize = 0, bpp = 4;
             uint32_t blockSize = 0, widthBlocks = 0, heightBlocks = 0;
             uint32_t _width, _height;
-            uint32_t formatFlags, formatIndex;
+            uint32_t formatFlags;
             uint8_t *bytes = NULL;
             
             
@@ -214,9 +243,20 @@ namespace vi
             }
             
             if(success)
-            {               
+            {
                 width = _width;
                 height = _height;
+            }
+            
+            return success;
+        }
+        
+        void texturePVR::upload()
+        {
+            if(pendingUpload)
+            {
+                uint32_t _width  = width;
+                uint32_t _height = height;
                 
                 GLenum internalFormat = PVRFormatTable[formatIndex][FormatTableOpenGLInternalFormat];
                 GLenum format = PVRFormatTable[formatIndex][FormatTableOpenGLFormat];
@@ -255,10 +295,13 @@ namespace vi
                     _width = MAX(_width >> 1, 1);
                     _height = MAX(_height >> 1, 1);
                 }
+                
+                ownsHandle    = true;
+                pendingUpload = false;
+                
+                std::vector<uint8_t>().swap(pvrData);
+                vi::common::kernel::sharedKernel()->checkError();
             }
-            
-            vi::common::kernel::sharedKernel()->checkError();
-            return success;
         }
     }
 }
@@ -24,6 +24,19 @@
  * @remark Every context that shared with the context of the view must be recreated!
  **/
 @property (nonatomic, assign) BOOL allowsCoreProfile;
+/**
+ * YES if the content of the back buffer should be preserved when the buffers are swapped, which allows the renderer to only redraw the parts of the
+ * view that changed. Default is NO.
+ * @remark Every context that shared with the context of the view must be recreated!
+ * @sa vi::graphic::commandRenderer::partialRedraw
+ **/
+@property (nonatomic, assign) BOOL preservesBackbuffer;
+/**
+ * YES if the view should have a 16 bit depth buffer, which is required by the depth sorting of the renderer. Default is NO.
+ * @remark Every context that shared with the context of the view must be recreated!
+ * @sa vi::graphic::commandRenderer::depthSorting
+ **/
+@property (nonatomic, assign) BOOL usesDepthBuffer;
 
 /**
  * Returns the size of the buffers
@@ -13,7 +13,7 @@
 #import "ViKernel.h"
 
 @implementation ViViewOSX
-@synthesize allowsCoreProfile;
+@synthesize allowsCoreProfile, preservesBackbuffer, usesDepthBuffer;
 
 - (vi::common::context *)context
 {
@@ -43,15 +43,39 @@
     [context->getNativeContext() flushBuffer];
 }
 
+- (void)recreateContext
+{
+    delete context;
+    context = new vi::common::context(allowsCoreProfile ? 150 : 120, preservesBackbuffer, usesDepthBuffer);
+    context->activateContext();
+    
+    [self setOpenGLContext:context->getNativeContext()];
+}
+
 - (void)setAllowsCoreProfile:(BOOL)allows
 {
     if(allowsCoreProfile != allows)
     {
-        delete context;
-        context = new vi::common::context(allows ? 150 : 120);
-        context->activateContext();
-        
-        [self setOpenGLContext:context->getNativeContext()];
+        allowsCoreProfile = allows;
+        [self recreateContext];
+    }
+}
+
+- (void)setPreservesBackbuffer:(BOOL)preserves
+{
+    if(preservesBackbuffer != preserves)
+    {
+        preservesBackbuffer = preserves;
+        [self recreateContext];
+    }
+}
+
+- (void)setUsesDepthBuffer:(BOOL)uses
+{
+    if(usesDepthBuffer != uses)
+    {
+        usesDepthBuffer = uses;
+        [self recreateContext];
     }
 }
 
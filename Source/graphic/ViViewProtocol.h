@@ -38,5 +38,18 @@
 
 - (CGFloat)contentScaleFactor;
 
+@optional
+/**
+ * Should return YES if the content of the back buffer is preserved when the buffers are swapped. Views that don't implement this are treated as
+ * if they return NO.
+ * @sa vi::graphic::commandRenderer::partialRedraw
+ **/
+- (BOOL)preservesBackbuffer;
+/**
+ * Should return YES if the framebuffer of the view has a depth buffer. Views that don't implement this are treated as if they return NO.
+ * @sa vi::graphic::commandRenderer::depthSorting
+ **/
+- (BOOL)usesDepthBuffer;
+
 @end
 
@@ -23,9 +23,25 @@
     vi::common::context *context;
     
     GLuint viewRenderbuffer; 
+    GLuint viewDepthbuffer;
 	GLuint viewFramebuffer;
+    
+    BOOL preservesBackbuffer;
+    BOOL usesDepthBuffer;
 }
 
+/**
+ * YES if the content of the back buffer should be preserved when it is presented, which allows the renderer to only redraw the parts of the view
+ * that changed. Default is NO.
+ * @sa vi::graphic::commandRenderer::partialRedraw
+ **/
+@property (nonatomic, assign) BOOL preservesBackbuffer;
+/**
+ * YES if the framebuffer of the view should have a 16 bit depth buffer, which is required by the depth sorting of the renderer. Default is NO.
+ * @sa vi::graphic::commandRenderer::depthSorting
+ **/
+@property (nonatomic, assign) BOOL usesDepthBuffer;
+
 /**
  * Returns the size of the buffers
  * @sa ViViewProtocol
@@ -11,6 +11,7 @@
 #import "ViEvent.h"
 
 @implementation ViViewiOS
+@synthesize preservesBackbuffer, usesDepthBuffer;
 
 + (Class)layerClass
 {
@@ -65,6 +66,16 @@
     [context->getNativeContext() renderbufferStorage:GL_RENDERBUFFER fromDrawable:(CAEAGLLayer *)self.layer];
 	glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH, &backingWidth);
     glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &backingHeight);
+    
+    // The depth buffer is only used by the depth sorting of the renderer
+    if(usesDepthBuffer)
+    {
+        glGenRenderbuffers(1, &viewDepthbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, viewDepthbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, backingWidth, backingHeight);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, viewDepthbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, viewRenderbuffer);
+    }
 	
 	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 	{
@@ -103,6 +114,12 @@
     
     glDeleteRenderbuffers(1, &viewRenderbuffer);
     viewRenderbuffer = 0;
+    
+    if(viewDepthbuffer)
+    {
+        glDeleteRenderbuffers(1, &viewDepthbuffer);
+        viewDepthbuffer = 0;
+    }
 }
 
 - (void)layoutSubviews
@@ -115,15 +132,49 @@
 
 #pragma mark -
 
-- (BOOL)setupView 
+- (void)updateDrawableProperties
 {
-	CAEAGLLayer *layer = (CAEAGLLayer *)[self layer];
-	NSDictionary *properties = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:NO], kEAGLDrawablePropertyRetainedBacking, 
+    CAEAGLLayer *layer = (CAEAGLLayer *)[self layer];
+	NSDictionary *properties = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:preservesBackbuffer], kEAGLDrawablePropertyRetainedBacking, 
                                                                             kEAGLColorFormatRGBA8, kEAGLDrawablePropertyColorFormat, nil];
     
+    [layer setDrawableProperties:properties];
+}
+
+- (void)setPreservesBackbuffer:(BOOL)preserves
+{
+    if(preservesBackbuffer != preserves)
+    {
+        preservesBackbuffer = preserves;
+        [self updateDrawableProperties];
+        
+        // The drawable properties are only applied when the renderbuffer storage is allocated again
+        context->activateContext();
+        
+        [self destroyFramebuffer];
+        [self generateBuffer];
+    }
+}
+
+- (void)setUsesDepthBuffer:(BOOL)uses
+{
+    if(usesDepthBuffer != uses)
+    {
+        usesDepthBuffer = uses;
+        
+        context->activateContext();
+        
+        [self destroyFramebuffer];
+        [self generateBuffer];
+    }
+}
+
+- (BOOL)setupView 
+{
+	CAEAGLLayer *layer = (CAEAGLLayer *)[self layer];
     
     [layer setOpaque:YES];
-    [layer setDrawableProperties:properties];
+    [self updateDrawableProperties];
 
     context = new vi::common::context();
     context->activateContext();
@@ -12,7 +12,10 @@
 #import "ViTexture.h"
 #import "ViColor.h"
 #import "ViRect.h"
+#import "ViRenderTarget.h"
 #import "ViVector2.h"
+#import "ViPixelReadback.h"
+#import "ViResolutionController.h"
 
 namespace vi
 {
@@ -21,8 +24,15 @@ namespace vi
         class kernel;
     }
     
+    namespace graphic
+    {
+        class commandRenderer;
+    }
+    
     namespace scene
     {
+        class scene;
+        
         /**
          * @brief A camera is a view into a scene (surprise)
          *
@@ -32,15 +42,19 @@ namespace vi
         class camera
         {
             friend class vi::common::kernel;
+            friend class vi::graphic::commandRenderer;
         public:
             /**
              * Constructor
              * @param tview The render target view. If set to NULL, the camera will render into a texture instead of an view
-             * @param size The size of the camera. Only used if tview is NULL to create a backing texture and framebuffer for the camera.
+             * @param size The size of the camera. Only used if tview is NULL to acquire a backing texture and framebuffer for the camera.
+             * @param format The format of the backing texture, eg. GL_RGBA or GL_RGB. Only used if tview is NULL.
+             * @remark The backing texture and framebuffer are taken from the vi::graphic::renderTarget pool, cameras that are created after another camera
+             * with the same size and format was deleted reuse its render target.
              **/
-            camera(id<ViViewProtocol> tview=NULL, vi::common::vector2 const& size=vi::common::vector2());
+            camera(id<ViViewProtocol> tview=NULL, vi::common::vector2 const& size=vi::common::vector2(), GLenum format=GL_RGBA);
             /**
-             * Destructor automatically deletes the texture and framebuffer allocated by the view.
+             * Destructor automatically gives the texture and framebuffer back to the render target pool.
              **/
             ~camera();
 
@@ -53,6 +67,11 @@ namespace vi
              * If the camera renders into a texture, the camera will bind the previously active frame buffer (the one that was active when calling bind())
              **/
             void unbind();
+            /**
+             * Updates the frame of view based cameras and recalculates the projection and view matrix. This is invoked by bind() but doesn't touch
+             * any OpenGL state, so it can be used to prepare a camera for rendering without binding it.
+             **/
+            void update();
             
             /**
              * The visible frame of the camera.
@@ -83,13 +102,95 @@ namespace vi
              **/
             std::string debugName;
             
+            /**
+             * If true, the camera only renders when something it sees changed (the visible nodes, their meshes, matrices, materials, parameters or
+             * the content of their textures) and otherwise keeps the image of the last frame. Only useful for cameras that render into a texture.
+             * As long as nothing in the scene or in any texture was flagged as changed and the frame and clear color of the camera stayed the same,
+             * the scene isn't even traversed, so its nodes aren't visited by this camera either.
+             * @remark Changes that don't go through a setter, eg. to public members, meshes or material parameters, must be flagged with
+             * vi::scene::sceneNode::setNeedsContentUpdate() or setNeedsRender().
+             * @default false
+             **/
+            bool renderOnDemand;
+            /**
+             * The camera only renders every renderInterval-th frame and keeps the image of its last frame in between, which is useful for cameras rendering
+             * into textures that don't need to be updated every frame, like minimaps. The scene staggers cameras with an interval above 1 across the
+             * frames, so that two cameras with an interval of 2 render in alternating frames instead of both in the same one.
+             * @remark Values below 1 are treated as 1.
+             * @default 1
+             **/
+            uint32_t renderInterval;
+            /**
+             * Forces a camera that renders on demand, or a view camera whose renderer uses partial redraws, to render completely again in the next frame.
+             **/
+            void setNeedsRender();
+            
+            /**
+             * Reads the pixels of the next frame the camera renders back without stalling the rendering, and invokes the callback with them once
+             * the GPU finished the copy, usually one or two frames later. The callback is invoked on the render thread at the beginning of a frame.
+             * @remark Cameras that render on demand are forced to render the next frame.
+             * @sa vi::graphic::pixelReadback
+             **/
+            void readPixels(vi::graphic::readbackCallback const& callback);
+            /**
+             * Reads back every frame the camera renders, and invokes the callback with the images on a worker thread, which can write them to disk
+             * without blocking the rendering, eg. with vi::graphic::pixelReadback::writeTGA(). Frames are dropped instead of stalling if the GPU or the
+             * worker fall behind.
+             **/
+            void streamPixels(vi::graphic::readbackCallback const& callback);
+            /**
+             * Stops streaming the pixels of the camera.
+             **/
+            void stopStreamingPixels();
+            /**
+             * Returns the readback of the camera, or NULL if the camera never read back pixels.
+             **/
+            vi::graphic::pixelReadback *getPixelReadback();
+            
+            /**
+             * Sets the fraction of the view resolution the scene nodes are rendered at. Below 1.0, the scene is rendered into a smaller texture which is
+             * then upscaled into the view, which trades sharpness for fill rate. UI nodes are always drawn in the full resolution.
+             * @remark Only used by cameras rendering into a view, and clamped to 0.1 - 1.0. Frames rendered with a scale below 1.0 don't use depth sorting
+             * or partial redraws.
+             * @default 1.0
+             **/
+            void setResolutionScale(float scale);
+            /**
+             * Returns the resolution scale.
+             **/
+            float getResolutionScale();
+            /**
+             * Sets a controller that adjusts the resolution scale before every frame, based on the frame time of the last frame. The kernel updates
+             * every controller once per frame, so a controller can be shared by several view cameras. The camera doesn't take ownership of the
+             * controller, pass NULL to remove it again.
+             **/
+            void setResolutionController(vi::graphic::resolutionController *controller);
+            /**
+             * Returns the resolution controller of the camera or NULL.
+             **/
+            vi::graphic::resolutionController *getResolutionController();
+            
         private:
             id<ViViewProtocol> view;
             
-            GLuint target;
-            GLuint framebuffer;
             GLint  prevBuffer;
-            vi::graphic::texture *texture;
+            vi::graphic::renderTarget *renderTarget;
+            vi::graphic::pixelReadback *readback;
+            
+            float resolutionScale;
+            vi::graphic::resolutionController *controller;
+            
+            bool needsRender;
+            uint32_t lastSignature;
+            
+            vi::scene::scene *lastScene;
+            uint32_t lastSceneRevision;
+            uint32_t lastTextureRevision;
+            vi::common::rect lastFrame;
+            vi::common::color lastClearColor;
+            
+            bool scissor;
+            GLint scissorRect[4];
         };
     }
 }
@@ -14,56 +14,117 @@ namespace vi
 {
     namespace scene
     {
-        camera::camera(id<ViViewProtocol> tview, vi::common::vector2 const& size)
+        camera::camera(id<ViViewProtocol> tview, vi::common::vector2 const& size, GLenum format)
         {
             clearColor = vi::common::color(0.5, 0.8, 1.0, 1.0);
             view = tview;
-            texture = NULL;
+            renderTarget = NULL;
+            readback = NULL;
+            
+            resolutionScale = 1.0f;
+            controller = NULL;
+            
+            renderOnDemand = false;
+            renderInterval = 1;
+            needsRender    = true;
+            lastSignature  = 0;
+            lastScene      = NULL;
+            lastSceneRevision   = 0;
+            lastTextureRevision = 0;
+            scissor        = false;
                     
             frame.size = vi::common::vector2([view size].width, [view size].height);
             
             if(!view)
             {
                 frame.size = size;
-                
-                glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevBuffer);
-                
-                glGenFramebuffers(1, &framebuffer);
-                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-                
-                glGenTextures(1, &target);
-                glBindTexture(GL_TEXTURE_2D, target);
-                
-                glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,  size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-                
-                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
-                glBindFramebuffer(GL_FRAMEBUFFER, prevBuffer);
-                
-                texture = new vi::graphic::texture(target, size.x, size.y);
+                renderTarget = vi::graphic::renderTarget::acquireRenderTarget(size.x, size.y, format);
             }
         }
             
         camera::~camera()
         {
-            if(!view)
-            {
-                glDeleteFramebuffers(1, &framebuffer);
-                glDeleteTextures(1, &target);
-                
-                delete texture;
-            }
+            if(readback)
+                delete readback;
+            
+            vi::graphic::renderTarget::releaseRenderTarget(renderTarget);
         }
         
         
-    
         
         vi::graphic::texture *camera::getTexture()
         {
-            return texture;
+            return renderTarget ? renderTarget->getTexture() : NULL;
+        }
+        
+        void camera::setNeedsRender()
+        {
+            needsRender = true;
+        }
+        
+        
+        void camera::readPixels(vi::graphic::readbackCallback const& callback)
+        {
+            if(!readback)
+                readback = new vi::graphic::pixelReadback();
+            
+            readback->request(callback);
+            setNeedsRender();
+        }
+        
+        void camera::streamPixels(vi::graphic::readbackCallback const& callback)
+        {
+            if(!readback)
+                readback = new vi::graphic::pixelReadback();
+            
+            readback->stream(callback);
+            setNeedsRender();
+        }
+        
+        void camera::stopStreamingPixels()
+        {
+            if(readback)
+                readback->stopStream();
+        }
+        
+        vi::graphic::pixelReadback *camera::getPixelReadback()
+        {
+            return readback;
+        }
+        
+        
+        void camera::setResolutionScale(float scale)
+        {
+            resolutionScale = MIN(MAX(scale, 0.1f), 1.0f);
         }
         
+        float camera::getResolutionScale()
+        {
+            return resolutionScale;
+        }
+        
+        void camera::setResolutionController(vi::graphic::resolutionController *tcontroller)
+        {
+            controller = tcontroller;
+        }
+        
+        vi::graphic::resolutionController *camera::getResolutionController()
+        {
+            return controller;
+        }
+        
+        
+        void camera::update()
+        {
+            if(view)
+            {
+                float scaleFactor = vi::common::kernel::sharedKernel()->scaleFactor;
+                frame.size = vi::common::vector2([view size].width/scaleFactor, [view size].height/scaleFactor);
+            }
+            
+            projectionMatrix.makeProjectionOrtho(0.0, frame.size.x, 0.0, frame.size.y, -1.0, 1.0);
+            viewMatrix.makeTranslate(vi::common::vector3(-frame.origin.x, frame.size.y + frame.origin.y, 0.0));
+        }
         
         void camera::bind()
         {
@@ -72,7 +133,6 @@ namespace vi
             if(view)
             {
                 [view bind];
-                frame.size = vi::common::vector2([view size].width/scaleFactor, [view size].height/scaleFactor);
                 
 #ifndef NDEBUG
 #if __IPHONE_OS_VERSION_MAX_ALLOWED >= 5
@@ -91,25 +151,52 @@ namespace vi
 #endif
                 
                 glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevBuffer);		
-                glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+                glBindFramebuffer(GL_FRAMEBUFFER, renderTarget->getFramebuffer());
             }
             
-            projectionMatrix.makeProjectionOrtho(0.0, frame.size.x, 0.0, frame.size.y, -1.0, 1.0);
-            viewMatrix.makeTranslate(vi::common::vector3(-frame.origin.x, frame.size.y + frame.origin.y, 0.0));
+            update();
             
             glViewport(0, 0, (GLint)frame.size.x * scaleFactor, (GLint)frame.size.y * scaleFactor);
             
+            if(scissor)
+            {
+                // Partial redraw, the rest of the preserved back buffer is kept
+                glEnable(GL_SCISSOR_TEST);
+                glScissor(scissorRect[0], scissorRect[1], scissorRect[2], scissorRect[3]);
+            }
+            
             glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
             glClear(GL_COLOR_BUFFER_BIT);
         }
         
         void camera::unbind()
         {
+            if(scissor)
+                glDisable(GL_SCISSOR_TEST);
+            
 #if __IPHONE_OS_VERSION_MAX_ALLOWED >= 5
             if(glPopGroupMarkerEXT)
                 glPopGroupMarkerEXT();
 #endif
             
+            if(readback && readback->wantsCapture())
+            {
+                // Read back before the view swaps its buffers or the previous framebuffer is bound again
+                if(view)
+                {
+                    float scaleFactor = vi::common::kernel::sharedKernel()->scaleFactor;
+                    readback->capture((uint32_t)(frame.size.x * scaleFactor), (uint32_t)(frame.size.y * scaleFactor));
+                }
+                else
+                {
+                    readback->capture(renderTarget->getTexture()->getWidth(), renderTarget->getTexture()->getHeight());
+                }
+                
+                // All buffers were still in flight, so the requests wait for the next frame, which a camera that renders on demand must not skip
+                if(readback->hasPendingRequests())
+                    setNeedsRender();
+            }
+            
             if(view)
             {
                 [view unbind];
@@ -0,0 +1,93 @@
+//
+//  ViNineSliceSprite.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViBase.h"
+#import "ViSceneNode.h"
+#import "ViTexture.h"
+#import "ViTextureAtlas.h"
+#import "ViMaterial.h"
+
+namespace vi
+{
+    namespace scene
+    {
+        /**
+         * @brief A sprite that stretches a texture region without distorting its borders
+         *
+         * A nine slice sprite divides its texture region into a 3x3 grid using four insets. The corners keep their size, the edges are stretched along
+         * one axis and the center is stretched along both axes. The whole sprite is a single mesh with 16 vertices and 54 indices; the indices are
+         * shared by all nine slice sprites and the vertices are only rewritten when the size or the region changes.
+         * The positions and texture coordinates are written into the mesh, so nine slice sprites can be added to a vi::scene::spriteBatch and are drawn
+         * together with the other sprites of the batch.
+         * @remark If the sprite is smaller than the sum of two opposing insets, the insets are scaled down so that they fit.
+         **/
+        class nineSliceSprite : public sceneNode
+        {
+        public:
+            /**
+             * Constructor
+             * @param texture The texture to slice, the sprite initially has the size of the texture.
+             * @param left The width of the left border in points
+             * @param top The height of the top border in points
+             * @param right The width of the right border in points
+             * @param bottom The height of the bottom border in points
+             **/
+            nineSliceSprite(vi::graphic::texture *texture, float left, float top, float right, float bottom);
+            /**
+             * Constructor for a sprite that slices the given region of a texture atlas
+             **/
+            nineSliceSprite(vi::graphic::textureRegion const& region, float left, float top, float right, float bottom);
+            /**
+             * Constructor for a sprite with a shared material, the first texture of the material must be the page of the region.
+             **/
+            nineSliceSprite(vi::graphic::textureRegion const& region, float left, float top, float right, float bottom, vi::graphic::material *sharedMaterial);
+            /**
+             * Destructor. Deletes the mesh, and the material if it isn't shared.
+             **/
+            virtual ~nineSliceSprite();
+
+            /**
+             * Prepares the matrix of the sprite for drawing and rewrites the positions of the vertices if the size changed.
+             **/
+            virtual void visit(double timestep);
+
+            /**
+             * Sets the texture region that is sliced. The size of the sprite is kept.
+             * @remark If the sprite shares its material, the material must already use the page of the region as texture.
+             **/
+            void setTextureRegion(vi::graphic::textureRegion const& region);
+            /**
+             * Sets the insets in points, measured from the edges of the texture region.
+             **/
+            void setInsets(float left, float top, float right, float bottom);
+            
+            /**
+             * Sets the layer of the vi::graphic::textureArray that is used as texture, which is written into the texture coordinates of the mesh.
+             * @remark Only needed if the material uses a texture array, like the one of a sprite batch with a texture array.
+             **/
+            void setTextureLayer(uint32_t layer);
+            /**
+             * Returns the texture array layer of the sprite.
+             **/
+            uint32_t getTextureLayer();
+
+        private:
+            void createFromRegion(vi::graphic::textureRegion const& region, float left, float top, float right, float bottom, vi::graphic::material *sharedMaterial);
+            void updatePositions();
+            void updateTexcoords();
+
+            vi::graphic::textureRegion region;
+            float insetLeft, insetTop, insetRight, insetBottom;
+
+            vi::common::vertex vertices[16];
+            vi::common::vector2 meshSize;
+            uint32_t textureLayer;
+            bool ownsMaterial;
+        };
+    }
+}
@@ -0,0 +1,225 @@
+//
+//  ViNineSliceSprite.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#import "ViNineSliceSprite.h"
+#import "ViContext.h"
+#import "ViTextureArray.h"
+
+namespace vi
+{
+    namespace scene
+    {
+        // Two triangles per cell of the 4x4 vertex grid, in the same winding as the sprite mesh
+        static uint16_t nineSliceIndices[54] = {
+            0,  4,  1,  5,  1,  4,
+            1,  5,  2,  6,  2,  5,
+            2,  6,  3,  7,  3,  6,
+            4,  8,  5,  9,  5,  8,
+            5,  9,  6,  10, 6,  9,
+            6,  10, 7,  11, 7,  10,
+            8,  12, 9,  13, 9,  12,
+            9,  13, 10, 14, 10, 13,
+            10, 14, 11, 15, 11, 14
+        };
+
+
+
+        nineSliceSprite::nineSliceSprite(vi::graphic::texture *texture, float left, float top, float right, float bottom)
+        {
+            vi::graphic::textureRegion tregion(texture, vi::common::vector2(0.0f, 0.0f), vi::common::vector2(texture->getWidth(), texture->getHeight()));
+            createFromRegion(tregion, left, top, right, bottom, NULL);
+        }
+
+        nineSliceSprite::nineSliceSprite(vi::graphic::textureRegion const& tregion, float left, float top, float right, float bottom)
+        {
+            createFromRegion(tregion, left, top, right, bottom, NULL);
+        }
+
+        nineSliceSprite::nineSliceSprite(vi::graphic::textureRegion const& tregion, float left, float top, float right, float bottom, vi::graphic::material *sharedMaterial)
+        {
+            createFromRegion(tregion, left, top, right, bottom, sharedMaterial);
+        }
+
+        void nineSliceSprite::createFromRegion(vi::graphic::textureRegion const& tregion, float left, float top, float right, float bottom, vi::graphic::material *sharedMaterial)
+        {
+            ownsMaterial = false;
+            textureLayer = 0;
+
+            if(!sharedMaterial)
+            {
+                vi::common::context *context = vi::common::context::getActiveContext();
+                assert(context);
+
+                sharedMaterial = new vi::graphic::material(tregion.page, context->getShader(vi::graphic::defaultShaderTexture));
+                sharedMaterial->blending = true;
+                sharedMaterial->blendSource = GL_ONE;
+                sharedMaterial->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+
+                ownsMaterial = true;
+            }
+
+            for(int i=0; i<16; i++)
+            {
+                vertices[i].x = vertices[i].y = 0.0f;
+                vertices[i].u = vertices[i].v = 0.0f;
+                vertices[i].r = vertices[i].g = vertices[i].b = vertices[i].a = 1.0f;
+            }
+
+            // The mesh doesn't own the data, the vertices are a member of the sprite and the indices are the same for all nine slice sprites
+            mesh     = new vi::common::mesh(vertices, nineSliceIndices, 16, 54);
+            material = sharedMaterial;
+
+            region = tregion;
+            insetLeft   = left;
+            insetTop    = top;
+            insetRight  = right;
+            insetBottom = bottom;
+
+            updateTexcoords();
+            setSize(region.size);
+            updatePositions();
+        }
+
+        nineSliceSprite::~nineSliceSprite()
+        {
+            if(ownsMaterial)
+                delete material;
+
+            delete mesh;
+        }
+
+
+
+        void nineSliceSprite::visit(double timestep)
+        {
+            sceneNode::visit(timestep);
+
+            if(meshSize != size)
+                updatePositions();
+        }
+
+        void nineSliceSprite::setTextureRegion(vi::graphic::textureRegion const& tregion)
+        {
+            region = tregion;
+
+            if(ownsMaterial)
+            {
+                if(material->textures.size() == 0)
+                {
+                    material->textures.push_back(region.page);
+                    material->texlocations.push_back(1);
+                }
+                else
+                {
+                    material->textures[0] = region.page;
+                }
+            }
+
+            updateTexcoords();
+        }
+
+        void nineSliceSprite::setInsets(float left, float top, float right, float bottom)
+        {
+            insetLeft   = left;
+            insetTop    = top;
+            insetRight  = right;
+            insetBottom = bottom;
+
+            updateTexcoords();
+            updatePositions();
+        }
+
+        void nineSliceSprite::setTextureLayer(uint32_t layer)
+        {
+            if(textureLayer == layer)
+                return;
+
+            textureLayer = layer;
+            updateTexcoords();
+        }
+
+        uint32_t nineSliceSprite::getTextureLayer()
+        {
+            return textureLayer;
+        }
+
+
+
+        void nineSliceSprite::updatePositions()
+        {
+            meshSize = size;
+
+            float left   = insetLeft;
+            float right  = insetRight;
+            float top    = insetTop;
+            float bottom = insetBottom;
+
+            if(left + right > size.x && left + right > kViEpsilonFloat)
+            {
+                float factor = size.x / (left + right);
+                left  *= factor;
+                right *= factor;
+            }
+
+            if(top + bottom > size.y && top + bottom > kViEpsilonFloat)
+            {
+                float factor = size.y / (top + bottom);
+                top    *= factor;
+                bottom *= factor;
+            }
+
+            // The mesh has its origin at the bottom left, so the first row of vertices is at the top of the sprite
+            float x[4] = { 0.0f, left, size.x - right, size.x };
+            float y[4] = { size.y, size.y - top, bottom, 0.0f };
+
+            for(int row=0; row<4; row++)
+            {
+                for(int column=0; column<4; column++)
+                {
+                    vertices[row * 4 + column].x = x[column];
+                    vertices[row * 4 + column].y = y[row];
+                }
+            }
+
+            mesh->dirty = true;
+            setNeedsContentUpdate();
+        }
+
+        void nineSliceSprite::updateTexcoords()
+        {
+            if(!region.page)
+                return;
+
+            float width  = region.page->getWidth();
+            float height = region.page->getHeight();
+
+            float beginU = region.origin.x / width;
+            float beginV = region.origin.y / height;
+            float endU   = (region.origin.x + region.size.x) / width;
+            float endV   = (region.origin.y + region.size.y) / height;
+
+            // The layer of a texture array is encoded in u, the same way sprites do it
+            float offset = vi::graphic::textureArray::layerOffset(textureLayer);
+
+            float u[4] = { beginU + offset, beginU + insetLeft / width + offset, endU - insetRight / width + offset, endU + offset };
+            float v[4] = { beginV, beginV + insetTop / height, endV - insetBottom / height, endV };
+
+            for(int row=0; row<4; row++)
+            {
+                for(int column=0; column<4; column++)
+                {
+                    vertices[row * 4 + column].u = u[column];
+                    vertices[row * 4 + column].v = v[row];
+                }
+            }
+
+            mesh->dirty = true;
+            setNeedsContentUpdate();
+        }
+    }
+}
@@ -24,6 +24,7 @@ namespace vi
             material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
             
             mesh = new vi::common::mesh(0, 0);
+            mesh->setVertexFormat(vi::common::vertexFormatPacked);
             
             particleMesh = new vi::common::mesh(4, 6);
             particleMesh->addVertex(0.0, 1.0, 0.0, 0.0);
@@ -69,6 +70,7 @@ namespace vi
         void particleEmitter::setTexture(vi::graphic::texture *texture)
         {
             material->textures[0] = texture;
+            setNeedsContentUpdate();
         }
         
         
@@ -137,12 +139,16 @@ namespace vi
                         mesh->addMesh(particleMesh, particle->position, particleSize * particle->scale);
                     }
                 }
+                
+                // Living particles move every frame, which keeps cameras that render on demand visiting the emitter
+                setNeedsContentUpdate();
             }
         }
         
         void particleEmitter::emitParticle(vi::scene::particle *particle)
         {
             particles.push_back(particle);
+            setNeedsContentUpdate();
         }
         
         void particleEmitter::autoEmitParticle(vi::scene::particle *particle, uint32_t tparticlesPerFrame, uint32_t tmaxParticles)
@@ -155,6 +161,8 @@ namespace vi
             
             particlesPerFrame = tparticlesPerFrame;
             maxParticles = tmaxParticles;
+            
+            setNeedsContentUpdate();
         }
         
         void particleEmitter::updateAutoEmitting(uint32_t tparticlesPerFrame, uint32_t tmaxParticles)
@@ -82,6 +82,7 @@ namespace vi
             /**
              * Adds the given camera to the render list.
              * @remark Only add cameras you want to get rendered as every camera requires the scene to be drawn again!
+             * @sa vi::scene::camera::renderInterval
              **/
             void addCamera(vi::scene::camera *camera);
             /**
@@ -135,12 +136,27 @@ namespace vi
              * Returns all nodes that should be rendered in screen space rather than in world space.
              **/
             std::vector<vi::scene::sceneNode *> *UINodes();
+            /**
+             * Returns the quadtree that manages the nodes of the scene.
+             **/
+            vi::common::quadtree *getQuadtree();
             
             /**
              * Updates the physical space and tells the renderer to render the scene with all cameras added to the scene.
              **/
             void draw(vi::graphic::renderer *renderer, double timestep);
             
+            /**
+             * Tells cameras that render on demand that something in the scene changed. Scene nodes do this automatically when they are added or removed,
+             * when their position, size, scale or rotation changes, or when setNeedsContentUpdate() is invoked on them.
+             * @sa vi::scene::camera::renderOnDemand
+             **/
+            void setNeedsContentUpdate();
+            /**
+             * Returns a number that is incremented every time something in the scene changes.
+             **/
+            uint32_t getContentRevision();
+            
             
             /**
              * Sends a line trace from the starting position to the end position and returns the first hit scene node.
@@ -191,12 +207,24 @@ namespace vi
              * Returns teh collision slop.
              **/
             GLfloat getCollisionSlop();
+            /**
+             * Returns the physical space of the scene.
+             **/
+            cpSpace *getSpace();
 #endif
             
         private:            
+            void queueBoundsUpdate(vi::scene::sceneNode *node);
+            void dequeueBoundsUpdate(vi::scene::sceneNode *node);
+            void updateBounds();
+            
             std::vector<vi::scene::camera *> *cameras;
+            uint32_t frame;
+            uint32_t contentRevision;
+            
             std::vector<vi::scene::sceneNode *>nodes;
             std::vector<vi::scene::sceneNode *>uiNodes;
+            std::vector<vi::scene::sceneNode *>boundsUpdates;
             
             vi::animation::animationServer *animationServer;
             vi::common::quadtree *quadtree;
@@ -6,6 +6,7 @@
 //  Unauthorized use is punishable by torture, mutilation, and vivisection.
 //
 
+#include <algorithm>
 #import "ViScene.h"
 #import "ViQuadtree.h"
 #import "ViRect.h"
@@ -66,6 +67,8 @@ namespace vi
             vi::common::rect rect = vi::common::rect(minX, minY, maxX-minX, maxY-minY);
             quadtree = new vi::common::quadtree(rect, subdivisions);
             cameras  = new std::vector<vi::scene::camera *>();
+            frame    = 0;
+            contentRevision = 0;
             animationServer = new vi::animation::animationServer();
             
             context = NULL;
@@ -107,26 +110,49 @@ namespace vi
             event.timestep = timestep;
             event.raise();
             
+            vi::graphic::frameStats *stats = renderer->getFrameStats();
+            double timestamp = vi::graphic::frameStats::timestamp();
+            
             animationServer->run(timestep);
             
+            stats->animationTime += vi::graphic::frameStats::timestamp() - timestamp;
+            
 #ifdef ViPhysicsChipmunk
             if(!physicsPaused)
             {
                 static double physicsstep = 1.0 / 60.0;
                 
+                timestamp = vi::graphic::frameStats::timestamp();
+                
                 totalPhysicsTime += timestep;
                 while(totalPhysicsTime >= physicsstep)
                 {
                     totalPhysicsTime -= physicsstep;
                     cpSpaceStep(space, physicsstep);
                 }
+                
+                stats->physicsTime += vi::graphic::frameStats::timestamp() - timestamp;
             }
 #endif
             
+            uint32_t phase = 0;
+            frame ++;
+            
             std::vector<vi::scene::camera *>::iterator iterator;
             for(iterator=cameras->begin(); iterator!=cameras->end(); iterator++)
             {
                 vi::scene::camera *camera = *iterator;
+                
+                if(camera->renderInterval > 1)
+                {
+                    // Every camera with an interval gets its own phase, so that their frames are spread out instead of falling onto the same tick
+                    if((frame + phase ++) % camera->renderInterval != 0)
+                    {
+                        stats->camerasSkipped ++;
+                        continue;
+                    }
+                }
+                
                 renderer->renderSceneWithCamera(this, camera, timestep);
             }
             
@@ -135,6 +161,16 @@ namespace vi
             event.raise();
         }
         
+        void scene::setNeedsContentUpdate()
+        {
+            contentRevision ++;
+        }
+        
+        uint32_t scene::getContentRevision()
+        {
+            return contentRevision;
+        }
+        
         
 #ifdef ViPhysicsChipmunk
         void scene::pausePhysics()
@@ -184,6 +220,11 @@ namespace vi
         {
             return cpSpaceGetCollisionSlop(space);
         }
+        
+        cpSpace *scene::getSpace()
+        {
+            return space;
+        }
 #endif
         
         
@@ -220,6 +261,8 @@ namespace vi
         {
             uiNodes.push_back(node);
             node->setScene(this);
+            
+            contentRevision ++;
         }
         
         void scene::removeUINode(vi::scene::sceneNode *node)
@@ -236,6 +279,8 @@ namespace vi
                     break;
                 }
             }
+            
+            contentRevision ++;
         }     
         
         void scene::deleteAllUINodes()
@@ -248,6 +293,7 @@ namespace vi
             }
             
             uiNodes.clear();
+            contentRevision ++;
         }
         
         
@@ -257,6 +303,8 @@ namespace vi
             quadtree->insertObject(node);
             node->setScene(this);
             
+            contentRevision ++;
+            
 #ifdef ViPhysicsChipmunk
             if(node->waitingForActivation)
             {
@@ -288,19 +336,58 @@ namespace vi
                 cpSpaceRemoveShape(space, node->shape);
 #endif
             
+            if(node->boundsQueued)
+                dequeueBoundsUpdate(node);
+            
             node->scene = NULL;
             quadtree->removeObject(node);
+            
+            contentRevision ++;
         }
         
         void scene::deleteAllNodes()
         {
             quadtree->deleteAllObjects();
+            contentRevision ++;
+        }
+        
+        
+        
+        void scene::queueBoundsUpdate(vi::scene::sceneNode *node)
+        {
+            boundsUpdates.push_back(node);
+            node->boundsQueued = true;
+        }
+        
+        void scene::dequeueBoundsUpdate(vi::scene::sceneNode *node)
+        {
+            std::vector<vi::scene::sceneNode *>::iterator iterator = std::find(boundsUpdates.begin(), boundsUpdates.end(), node);
+            if(iterator != boundsUpdates.end())
+                boundsUpdates.erase(iterator);
+            
+            node->boundsQueued = false;
         }
         
+        void scene::updateBounds()
+        {
+            // Reinsert the nodes whose subtree changed since the last query, a node that moved a hundred childs is only reinserted once
+            std::vector<vi::scene::sceneNode *>::iterator iterator;
+            for(iterator=boundsUpdates.begin(); iterator!=boundsUpdates.end(); iterator++)
+            {
+                vi::scene::sceneNode *node = *iterator;
+                node->boundsQueued = false;
+                
+                if(node->tree && !node->parent)
+                    node->tree->updateObject(node);
+            }
+            
+            boundsUpdates.clear();
+        }
         
         
         std::vector<vi::scene::sceneNode *> *scene::nodesInRect(vi::common::rect const& rect)
         {
+            updateBounds();
             nodes = std::vector<vi::scene::sceneNode *>();
             
             quadtree->objectsInRect(rect, &nodes);            
@@ -312,6 +399,11 @@ namespace vi
             return &uiNodes;
         }
         
+        vi::common::quadtree *scene::getQuadtree()
+        {
+            return quadtree;
+        }
+        
         
         void scene::activate(ALCdevice *device)
         {
@@ -358,13 +450,14 @@ namespace vi
             vi::scene::sceneNode *hitNode = NULL;
             GLfloat hitDistance;
             
+            updateBounds();
             quadtree->objectsInRect(rect, &objects);
             for(iterator=objects.begin(); iterator!=objects.end(); iterator++)
             {
                 vi::scene::sceneNode *node = *iterator;
                 if(layer == 0 || node->layer == layer)
                 {
-                    bool intersects = line.intersects(vi::common::rect(node->position, node->size), &hitVec2);
+                    bool intersects = line.intersects(node->getBounds(), &hitVec2);
                     if(intersects)
                     {
                         if(hitNode)
@@ -406,13 +499,14 @@ namespace vi
             vi::common::vector2 hitVec;
             GLfloat hitDistance = 0.0;
             
+            updateBounds();
             quadtree->objectsInRect(rect, &objects);
             for(iterator=objects.begin(); iterator!=objects.end(); iterator++)
             {
                 vi::scene::sceneNode *node = *iterator;
                 if(layer == 0 || node->layer == layer)
                 {
-                    bool intersects = vi::common::rect(node->position, node->size).intersectsRect(rect);
+                    bool intersects = node->getBounds().intersectsRect(rect);
                     
                     if(intersects)
                     {
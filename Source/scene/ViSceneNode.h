@@ -11,6 +11,7 @@
 #import "ViBase.h"
 #import "ViMesh.h"
 #import "ViVector2.h"
+#import "ViRect.h"
 #import "ViCamera.h"
 #import "ViMatrix4x4.h"
 
@@ -36,6 +37,7 @@ namespace vi
         {
             /**
              * No clip flag. If set, the node won't be clipped
+             * @remark Rotated or scaled nodes don't need this flag, their bounds already cover the rotation and scale.
              **/
             sceneNodeFlagNoclip = 1,
             /**
@@ -46,7 +48,29 @@ namespace vi
             /**
              * If this flag is set, the renderer is allowed to batch up all the childs of the node in order to speed up rendering
              **/
-            sceneNodeFlagConcatenateChildren = 4
+            sceneNodeFlagConcatenateChildren = 4,
+            /**
+             * Only used by UI nodes. If this flag is set, the renderer draws the node and its childs into a cached texture and composites the
+             * texture as a single quad with the position, rotation and scale of the node. The subtree isn't traversed as long as the cached texture
+             * is valid, it is only redrawn when the size of the node or the content of a used texture changes, or setNeedsContentUpdate() is invoked
+             * on the node or one of its childs.
+             * @remark Everything outside of the nodes size is clipped, so make sure the node is big enough to contain all of its childs. Unlike
+             * uncached nodes, the rotation and scale of the node also apply to its childs.
+             **/
+            sceneNodeFlagCacheContent = 8,
+            /**
+             * Only used by scene nodes that aren't UI nodes, eg. parallax backgrounds or the layers of a tmxNode. If this flag is set, the renderer draws
+             * the node and its childs into a cached texture that covers the camera plus a margin around it and composites the texture as a single quad.
+             * The subtree isn't traversed as long as the cached texture is valid, it is only redrawn when the camera moves past the margin, the position
+             * or size of the node changes, or setNeedsContentUpdate() is invoked.
+             * @sa vi::graphic::commandRenderer::staticLayerMargin
+             **/
+            sceneNodeFlagStaticLayer = 16,
+            /**
+             * If this flag is set, the renderer skips the node and its childs. The node is still part of the scene, so it keeps its place among the
+             * childs of its parent, which makes this cheaper than removing and adding the node again.
+             **/
+            sceneNodeFlagHidden = 32
         };
         
         typedef enum
@@ -61,6 +85,22 @@ namespace vi
             sceneNodePhysicTypeCircle
         } sceneNodePhysicType;
         
+        /**
+         * @cond
+         **/
+        typedef struct
+        {
+            vi::graphic::material *material;
+            vi::common::mesh *mesh;
+            vi::common::rect bounds;
+            
+            GLfloat atlas[4];
+            bool ownsMaterial;
+        } frozenMesh;
+        /**
+         * @endcond
+         **/
+        
         /**
          * @brief A scene node represents a object inside a scene
          *
@@ -68,8 +108,8 @@ namespace vi
          * to allow it to render more useful stuff. Usually you create a mesh and material in a scene nodes subclass which is then rendered by the renderer.
          * All other logic is implemented inside the scene node, like updating the matrix and updating itself on position changes etc.<br />
          * <br />
-         * Scene nodes can also contain childs. A child is an object that is clipped together with its parent (so update the size of the parent if needed),
-         * it will also be rendered relative to its parent by the renderer. Childs can also contain childs again.
+         * Scene nodes can also contain childs. A child is rendered relative to its parent by the renderer and childs can also contain childs again.
+         * Every node caches a bounding box of itself and all of its childs, which the quadtree and the renderer use to reject a whole subtree at once.
          * <br />
          * Nodes can be registered as physical nodes since Vinter 0.4.0, this is done by wrapping a Chipmunk shape and body, 
          * for more information about chipmunk visit http://chipmunk-physics.net/
@@ -166,6 +206,59 @@ namespace vi
              **/
             void setDebugName(std::string *name, bool deleteAutomatically=true);
             
+            /**
+             * Tells the renderer that the content of the node changed, the change is also propagated to all parents of the node and to its scene. Nodes with the
+             * sceneNodeFlagStaticLayer or sceneNodeFlagCacheContent flag and cameras that render on demand are only redrawn after this was invoked on them or
+             * one of their childs. Adding or removing childs, moving, resizing, scaling or rotating childs and the setters of the built in nodes do this
+             * automatically, changes to public members, meshes or materials made directly need to invoke it.
+             **/
+            void setNeedsContentUpdate();
+            /**
+             * Returns a number that is incremented every time the content of the node changes.
+             * @sa setNeedsContentUpdate()
+             **/
+            uint32_t getContentRevision();
+            
+            /**
+             * Returns the axis aligned bounding box of the node in the coordinate space of its parent. Unlike a rect made from the position and size,
+             * the box also covers the rotation and scale the node is rendered with.
+             * @remark Returns an empty rect if the node has no size.
+             **/
+            vi::common::rect getBounds();
+            /**
+             * Returns the bounding box of the node and all of its childs, in the coordinate space of the nodes parent. The box is cached and only
+             * recalculated after the position or size of the node or one of its childs changed, or after childs were added or removed.
+             * @remark Returns an empty rect if the subtree can't be bounded, which is the case if it contains a node with a mesh but without size, or
+             * no node with a size at all. Such subtrees are never culled as a whole. Childs whose subtree has no size at all but is bounded, like
+             * empty groups or text nodes without text, don't affect the bounds of their parent.
+             **/
+            vi::common::rect getSubtreeBounds();
+            
+            /**
+             * Bakes the node and all of its childs into static meshes. The meshes are positioned relative to the node and merged whenever they share
+             * a material, sprites that only differ in their atlas translation share one as well. While the node is frozen, the renderer draws the baked
+             * meshes instead of visiting the subtree, which only costs a draw per baked mesh.
+             * @remark Only the position of the frozen node itself stays live, it can still be moved. Changes to its size, rotation and scale, as well as
+             * any change inside the subtree, including the positions of the childs, aren't visible until the node is unfrozen or frozen again. The subtree
+             * is baked from the stored transforms of the nodes, it isn't visited. Hidden nodes are left out and the noPass camera of the childs is ignored.
+             * @remark Don't freeze physical nodes or nodes that are childs of a node with sceneNodeFlagConcatenateChildren, and call this outside of
+             * the rendering, the baked meshes get VBOs.
+             **/
+            void freeze();
+            /**
+             * Deletes the baked meshes, the subtree is visited and rendered as usual again.
+             **/
+            void unfreeze();
+            /**
+             * Returns true if the node is frozen.
+             **/
+            bool isFrozen();
+            /**
+             * Returns the baked meshes of a frozen node. Their bounds are relative to the position of the node.
+             * @remark Don't delete the vector!
+             **/
+            std::vector<vi::scene::frozenMesh *> *getFrozenMeshes();
+            
 #ifdef ViPhysicsChipmunk
             /**
              * Registers the node as a physical node.
@@ -322,7 +415,7 @@ namespace vi
 #endif
             
             /**
-             * The rotation of the node
+             * The rotation of the node. If you change this directly, call update() to update the bounds of the node.
              **/
             GLfloat rotation;
             /**
@@ -366,7 +459,7 @@ namespace vi
              **/
             vi::common::vector2 size;
             /**
-             * The scale of the scene node. Currently you don't need to call update() after changing this value
+             * The scale of the scene node. If you change this directly, call update() to update the node within its tree.
              **/
             vi::common::vector2 scale;
             /**
@@ -393,6 +486,12 @@ namespace vi
              * Parent node
              **/
             vi::scene::sceneNode *parent;
+            /**
+             * True if the mesh of the node never reaches outside of its size, so the node draws nothing while it has no size. Nodes with a mesh but no
+             * size are otherwise treated as unbounded, because their mesh might cover any area.
+             * @default false
+             **/
+            bool meshWithinSize;
             
         private:
 #ifdef ViPhysicsChipmunk
@@ -427,12 +526,32 @@ namespace vi
            
             bool deleteDebugName;
             bool knownDynamic;
+            uint32_t contentRevision;
+            
+            vi::common::rect bounds;
+            vi::common::rect subtreeBounds;
+            bool subtreeBounded;
+            bool boundsDirty;
+            bool boundsQueued;
             
             std::vector<vi::scene::sceneNode *> childs;
             
+            bool frozen;
+            std::vector<vi::scene::frozenMesh *> frozenMeshes;
+            
+            void bakeNode(vi::scene::sceneNode *node, vi::common::vector2 offset);
+            void bakeChilds(vi::scene::sceneNode *node, vi::common::vector2 offset);
+            void bakeMesh(vi::common::mesh *mesh, vi::graphic::material *material, vi::common::matrix4x4 const& matrix);
+            
+            void invalidateBounds();
+            vi::common::rect calculateBounds();
+            
             void forceSetPosition(vi::common::vector2 const& position);
             void forceSetSize(vi::common::vector2 const& size);
             void forceSetRotation(GLfloat rotation);
+            void forceSetScale(vi::common::vector2 const& scale);
+            
+            void makeMatrix(vi::common::matrix4x4& matrix);
             
             void reenablePhysics();
         };
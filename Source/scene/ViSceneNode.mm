@@ -6,12 +6,14 @@
 //  Unauthorized use is punishable by torture, mutilation, and vivisection.
 //
 
+#include <algorithm>
 #import "ViSceneNode.h"
 #import "ViQuadtree.h"
 #import "ViScene.h"
 #import "ViRenderer.h"
 #import "ViVector3.h"
 #import "ViAnimationServer.h"
+#import "ViMaterial.h"
 
 namespace vi
 {
@@ -26,6 +28,12 @@ namespace vi
             rotation    = temporaryRotation = 0.0;
             
             flags = 0;
+            contentRevision = 0;
+            boundsDirty  = true;
+            boundsQueued = false;
+            subtreeBounded = true;
+            meshWithinSize = false;
+            frozen = false;
 
             material    = NULL;
             mesh        = NULL;
@@ -59,6 +67,8 @@ namespace vi
         
         sceneNode::~sceneNode()
         {            
+            unfreeze();
+            
 #ifdef ViPhysicsChipmunk
             disablePhysics();
 #endif
@@ -66,6 +76,9 @@ namespace vi
             if(tree)
                 tree->removeObject(this);
             
+            if(boundsQueued && scene)
+                scene->dequeueBoundsUpdate(this);
+            
             if(debugName && deleteDebugName)
                 delete debugName;
         }
@@ -88,8 +101,13 @@ namespace vi
             }
 #endif
             
-            matrix.makeIdentity();
-            matrix.translate(vi::common::vector3(position.x, - position.y - size.y, 0.0));
+            makeMatrix(matrix);
+        }
+        
+        void sceneNode::makeMatrix(vi::common::matrix4x4& tmatrix)
+        {
+            tmatrix.makeIdentity();
+            tmatrix.translate(vi::common::vector3(position.x, - position.y - size.y, 0.0));
             
             if(rotation > kViEpsilonFloat || rotation < -kViEpsilonFloat)
             {
@@ -101,10 +119,10 @@ namespace vi
                 rotationMatrix.rotate(rotation, vi::common::vector3(0.0f, 0.0f, 1.0f));
                 rotationMatrix.translate(vi::common::vector3(-halfWidth, -halfHeight, 0.0f));
                 
-                matrix *= rotationMatrix;
+                tmatrix *= rotationMatrix;
             }
             
-            matrix.scale(vi::common::vector3(scale.x, scale.y, 1.0));
+            tmatrix.scale(vi::common::vector3(scale.x, scale.y, 1.0));
         }
         
         
@@ -192,7 +210,8 @@ namespace vi
                     {
                         vi::animation::basicAnimation<vi::common::vector2> *animation = new vi::animation::basicAnimation<vi::common::vector2>();
                         animation->setValues(temporaryScale, tscale);
-                        animation->setApplyProperty(&scale);
+                        animation->setApplyCallback(std::tr1::bind(&vi::scene::sceneNode::forceSetScale, this, std::tr1::placeholders::_1));
+                        animation->setApplyProperty(&temporaryScale);
                         
                         stack->addAnimation(animation);
                         temporaryScale = tscale;
@@ -202,6 +221,8 @@ namespace vi
                 
                 scale = tscale;
                 temporaryScale = tscale;
+                
+                update();
             }
         }
         
@@ -232,6 +253,7 @@ namespace vi
             
             rotation = trotation;
             temporaryRotation = trotation;
+            update();
             
 #ifdef ViPhysicsChipmunk
             if(body)
@@ -277,6 +299,7 @@ namespace vi
         void sceneNode::forceSetRotation(GLfloat trotation)
         {
             rotation = trotation;
+            update();
             
 #ifdef ViPhysicsChipmunk
             if(body)
@@ -284,6 +307,12 @@ namespace vi
 #endif
         }
         
+        void sceneNode::forceSetScale(vi::common::vector2 const& tscale)
+        {
+            scale = tscale;
+            update();
+        }
+        
 
         uint32_t sceneNode::getFlags()
         {
@@ -303,6 +332,14 @@ namespace vi
         
         void sceneNode::update()
         {
+            invalidateBounds();
+            
+            // The transform of a node is part of the content of its parent, but not of its own content
+            if(parent)
+                parent->setNeedsContentUpdate();
+            else if(scene)
+                scene->setNeedsContentUpdate();
+            
             if((flags & sceneNodeFlagDynamic) && knownDynamic)
                 return;
                 
@@ -347,6 +384,9 @@ namespace vi
             childs.push_back(child);
             child->parent = this;
             child->setScene(scene);
+            
+            invalidateBounds();
+            setNeedsContentUpdate();
         }
         
         void sceneNode::removeChild(vi::scene::sceneNode *child)
@@ -361,6 +401,9 @@ namespace vi
                 {
                     child->parent = NULL;
                     childs.erase(iterator);
+                    
+                    invalidateBounds();
+                    setNeedsContentUpdate();
                     break;
                 }
             }
@@ -376,6 +419,352 @@ namespace vi
             deleteDebugName = deleteAutomatically;
         }
         
+        void sceneNode::setNeedsContentUpdate()
+        {
+            // The parents contain the node, so their content changed as well
+            sceneNode *node = this;
+            for(; node->parent; node = node->parent)
+                node->contentRevision ++;
+            
+            node->contentRevision ++;
+            
+            if(node->scene)
+                node->scene->setNeedsContentUpdate();
+        }
+        
+        uint32_t sceneNode::getContentRevision()
+        {
+            return contentRevision;
+        }
+        
+        
+        void sceneNode::invalidateBounds()
+        {
+            // A dirty node always has dirty parents, so the walk can stop at the first one
+            for(sceneNode *node = this; node && !node->boundsDirty; node = node->parent)
+            {
+                node->boundsDirty = true;
+                
+                if(!node->parent && node->tree && node->scene && !node->boundsQueued)
+                {
+                    // The quadtree places the root by the bounds of its subtree, the scene reinserts it before it is queried the next time
+                    node->scene->queueBoundsUpdate(node);
+                }
+            }
+        }
+        
+        vi::common::rect sceneNode::calculateBounds()
+        {
+            if(size.length() <= kViEpsilonFloat)
+                return vi::common::rect();
+            
+            bool rotated = (rotation > kViEpsilonFloat || rotation < -kViEpsilonFloat);
+            if(!rotated && scale.x == 1.0f && scale.y == 1.0f)
+                return vi::common::rect(position, size);
+            
+            // Transform the corners of the node the same way visit() does, the matrix maps into OpenGL space where y points up
+            vi::common::matrix4x4 tmatrix;
+            makeMatrix(tmatrix);
+            
+            const GLfloat *m = tmatrix.matrix;
+            float corners[4][2] = { { 0.0f, 0.0f }, { size.x, 0.0f }, { size.x, size.y }, { 0.0f, size.y } };
+            float left = 0.0f, right = 0.0f, top = 0.0f, bottom = 0.0f;
+            
+            for(int i=0; i<4; i++)
+            {
+                float x = m[0] * corners[i][0] + m[4] * corners[i][1] + m[12];
+                float y = -(m[1] * corners[i][0] + m[5] * corners[i][1] + m[13]);
+                
+                left   = (i == 0) ? x : MIN(left, x);
+                right  = (i == 0) ? x : MAX(right, x);
+                top    = (i == 0) ? y : MIN(top, y);
+                bottom = (i == 0) ? y : MAX(bottom, y);
+            }
+            
+            return vi::common::rect(left, top, right - left, bottom - top);
+        }
+        
+        vi::common::rect sceneNode::getBounds()
+        {
+            if(boundsDirty)
+                getSubtreeBounds();
+            
+            return bounds;
+        }
+        
+        vi::common::rect sceneNode::getSubtreeBounds()
+        {
+            if(!boundsDirty)
+                return subtreeBounds;
+            
+            bounds = calculateBounds();
+            
+            bool empty   = (bounds.size.length() <= kViEpsilonFloat);
+            bool bounded = !(mesh && !meshWithinSize && empty);
+            
+            vi::common::rect result = bounds;
+            
+            std::vector<vi::scene::sceneNode *>::iterator iterator;
+            for(iterator=childs.begin(); iterator!=childs.end(); iterator++)
+            {
+                // Every child is updated, even if the subtree is already known to be unbounded, so that dirty childs always have dirty parents
+                vi::common::rect childBounds = (*iterator)->getSubtreeBounds();
+                if(!(*iterator)->subtreeBounded)
+                {
+                    bounded = false;
+                    continue;
+                }
+                
+                // The subtree draws nothing
+                if(childBounds.size.length() <= kViEpsilonFloat)
+                    continue;
+                
+                childBounds.origin += position;
+                
+                result = empty ? childBounds : result.unionRect(childBounds);
+                empty  = false;
+            }
+            
+            subtreeBounds  = (bounded && !empty) ? result : vi::common::rect();
+            subtreeBounded = bounded;
+            boundsDirty = false;
+            
+            return subtreeBounds;
+        }
+        
+        
+        
+        bool frozenMaterialUsesAtlas(vi::graphic::material *material);
+        bool frozenMaterialUsesAtlas(vi::graphic::material *material)
+        {
+            // Materials of sprites only differ in the atlas translation, which can be baked into the texture coordinates
+            if(material->drawMode != GL_TRIANGLES || material->attributes.size() > 0 || material->parameter.size() != 1)
+                return false;
+            
+            vi::graphic::materialParameter& parameter = material->parameter[0];
+            return (parameter.name.compare("atlasTranslation") == 0 && parameter.type == vi::graphic::materialParameterTypeFloat);
+        }
+        
+        bool frozenMaterialsMatch(vi::graphic::material *materialA, vi::graphic::material *materialB);
+        bool frozenMaterialsMatch(vi::graphic::material *materialA, vi::graphic::material *materialB)
+        {
+            return (materialA->shader == materialB->shader && materialA->textures == materialB->textures && materialA->texlocations == materialB->texlocations &&
+                    materialA->blending == materialB->blending && materialA->blendSource == materialB->blendSource && materialA->blendDestination == materialB->blendDestination &&
+                    materialA->culling == materialB->culling && materialA->cullMode == materialB->cullMode && materialA->drawMode == materialB->drawMode);
+        }
+        
+        
+        void sceneNode::freeze()
+        {
+            unfreeze();
+            
+            bakeNode(this, -position);
+            
+            std::vector<vi::scene::frozenMesh *>::iterator iterator;
+            for(iterator=frozenMeshes.begin(); iterator!=frozenMeshes.end(); iterator++)
+            {
+                vi::scene::frozenMesh *frozenMesh = *iterator;
+                frozenMesh->mesh->generateVBO();
+            }
+            
+            frozen = true;
+            setNeedsContentUpdate();
+        }
+        
+        void sceneNode::unfreeze()
+        {
+            std::vector<vi::scene::frozenMesh *>::iterator iterator;
+            for(iterator=frozenMeshes.begin(); iterator!=frozenMeshes.end(); iterator++)
+            {
+                vi::scene::frozenMesh *frozenMesh = *iterator;
+                
+                if(frozenMesh->ownsMaterial)
+                    delete frozenMesh->material;
+                
+                delete frozenMesh->mesh;
+                delete frozenMesh;
+            }
+            
+            if(frozen)
+                setNeedsContentUpdate();
+            
+            frozenMeshes.clear();
+            frozen = false;
+        }
+        
+        bool sceneNode::isFrozen()
+        {
+            return frozen;
+        }
+        
+        std::vector<vi::scene::frozenMesh *> *sceneNode::getFrozenMeshes()
+        {
+            return &frozenMeshes;
+        }
+        
+        
+        void sceneNode::bakeNode(vi::scene::sceneNode *node, vi::common::vector2 offset)
+        {
+            if(node->flags & sceneNodeFlagHidden)
+                return;
+            
+            // Build the matrix from the stored transform, the offset takes the place of the translation of the parents
+            if(node->mesh && node->material)
+            {
+                vi::common::matrix4x4 nodeMatrix;
+                node->makeMatrix(nodeMatrix);
+                
+                vi::common::matrix4x4 tmatrix;
+                tmatrix.makeTranslate(vi::common::vector3(offset.x, -offset.y, 0.0f));
+                tmatrix *= nodeMatrix;
+                
+                bakeMesh(node->mesh, node->material, tmatrix);
+            }
+            
+            bakeChilds(node, offset + node->position);
+        }
+        
+        void sceneNode::bakeChilds(vi::scene::sceneNode *node, vi::common::vector2 offset)
+        {
+            std::vector<vi::scene::sceneNode *>::iterator iterator;
+            
+            if(!(node->flags & sceneNodeFlagConcatenateChildren))
+            {
+                for(iterator=node->childs.begin(); iterator!=node->childs.end(); iterator++)
+                    bakeNode(*iterator, offset);
+                
+                return;
+            }
+            
+            // Concatenated childs are drawn with the material and matrix of their parent, just like the renderers batch list does
+            vi::common::matrix4x4 nodeMatrix;
+            node->makeMatrix(nodeMatrix);
+            
+            for(iterator=node->childs.begin(); iterator!=node->childs.end(); iterator++)
+            {
+                vi::scene::sceneNode *child = *iterator;
+                if(child->flags & sceneNodeFlagHidden)
+                    continue;
+                
+                if(child->mesh && node->material)
+                {
+                    vi::common::vector2 childPosition = child->position;
+                    childPosition.y = -childPosition.y + node->size.y - child->size.y;
+                    
+                    vi::common::matrix4x4 tmatrix;
+                    tmatrix.makeTranslate(vi::common::vector3(offset.x, -offset.y, 0.0f));
+                    tmatrix *= nodeMatrix;
+                    tmatrix.translate(vi::common::vector3(childPosition.x, childPosition.y, 0.0f));
+                    
+                    bakeMesh(child->mesh, node->material, tmatrix);
+                }
+                
+                bakeChilds(child, offset + child->position);
+            }
+        }
+        
+        void sceneNode::bakeMesh(vi::common::mesh *mesh, vi::graphic::material *material, vi::common::matrix4x4 const& tmatrix)
+        {
+            if(mesh->vertexCount == 0 || mesh->indexCount == 0)
+                return;
+            
+            bool bakesAtlas = frozenMaterialUsesAtlas(material);
+            const GLfloat *atlas = bakesAtlas ? (const GLfloat *)material->parameter[0].data : NULL;
+            
+            // Transform the vertices into the space of the frozen node, which has y pointing down like the scene
+            std::vector<vi::common::vertex> vertices(mesh->vertexCount);
+            for(uint32_t i=0; i<mesh->vertexCount; i++)
+                vertices[i] = mesh->getVertex(i);
+            
+            const GLfloat *m = tmatrix.matrix;
+            
+            float left = 0.0f, right = 0.0f, top = 0.0f, bottom = 0.0f;
+            for(uint32_t i=0; i<mesh->vertexCount; i++)
+            {
+                vi::common::vertex& vertex = vertices[i];
+                
+                float x = m[0] * vertex.x + m[4] * vertex.y + m[12];
+                float y = m[1] * vertex.x + m[5] * vertex.y + m[13];
+                
+                vertex.x = x;
+                vertex.y = y;
+                
+                if(atlas)
+                {
+                    vertex.u = vertex.u * atlas[2] + atlas[0];
+                    vertex.v = vertex.v * atlas[3] + atlas[1];
+                }
+                
+                left   = (i == 0) ? x : MIN(left, x);
+                right  = (i == 0) ? x : MAX(right, x);
+                top    = (i == 0) ? -y : MIN(top, -y);
+                bottom = (i == 0) ? -y : MAX(bottom, -y);
+            }
+            
+            vi::common::rect bounds = vi::common::rect(left, top, right - left, bottom - top);
+            
+            
+            // Look for a mesh with the same material, meshes can only be merged into an earlier one if they don't overlap anything drawn in between
+            vi::scene::frozenMesh *target = NULL;
+            
+            if(material->drawMode == GL_TRIANGLES)
+            {
+                std::vector<vi::scene::frozenMesh *>::reverse_iterator iterator;
+                for(iterator=frozenMeshes.rbegin(); iterator!=frozenMeshes.rend(); iterator++)
+                {
+                    vi::scene::frozenMesh *frozenMesh = *iterator;
+                    
+                    bool matches = bakesAtlas ? (frozenMesh->ownsMaterial && frozenMaterialsMatch(frozenMesh->material, material)) : (frozenMesh->material == material);
+                    if(matches && frozenMesh->mesh->vertexCount + mesh->vertexCount <= 65535)
+                    {
+                        target = frozenMesh;
+                        break;
+                    }
+                    
+                    if(frozenMesh->bounds.intersectsRect(bounds))
+                        break;
+                }
+            }
+            
+            if(!target)
+            {
+                target = new vi::scene::frozenMesh;
+                target->mesh   = new vi::common::mesh(mesh->vertexCount, mesh->indexCount);
+                target->bounds = bounds;
+                target->ownsMaterial = bakesAtlas;
+                target->material = material;
+                
+                if(bakesAtlas)
+                {
+                    target->atlas[0] = target->atlas[1] = 0.0f;
+                    target->atlas[2] = target->atlas[3] = 1.0f;
+                    
+                    target->material = new vi::graphic::material(NULL, material->shader);
+                    target->material->textures     = material->textures;
+                    target->material->texlocations = material->texlocations;
+                    target->material->blending     = material->blending;
+                    target->material->blendSource  = material->blendSource;
+                    target->material->blendDestination = material->blendDestination;
+                    target->material->culling  = material->culling;
+                    target->material->cullMode = material->cullMode;
+                    target->material->drawMode = material->drawMode;
+                    target->material->addParameter("atlasTranslation", target->atlas, vi::graphic::materialParameterTypeFloat, 4, 1);
+                }
+                
+                frozenMeshes.push_back(target);
+            }
+            else
+            {
+                target->bounds = target->bounds.unionRect(bounds);
+            }
+            
+            
+            uint32_t first = target->mesh->vertexCount;
+            target->mesh->addMesh(mesh);
+            
+            std::copy(vertices.begin(), vertices.end(), target->mesh->getVertices() + first);
+        }
+        
         
 #ifdef ViPhysicsChipmunk
         GLfloat sceneNode::suggestedInertia()
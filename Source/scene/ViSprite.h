@@ -6,9 +6,11 @@
 //  Unauthorized use is punishable by torture, mutilation, and vivisection.
 //
 
+#include <vector>
 #import "ViBase.h"
 #import "ViSceneNode.h"
 #import "ViTexture.h"
+#import "ViTextureAtlas.h"
 #import "ViRenderer.h"
 
 namespace vi
@@ -68,6 +70,26 @@ namespace vi
              * Sets new atlas informations. The atlas information is used to render only a part of the texture, defined by begin and size.
              **/
             void setAtlas(vi::common::vector2 const& begin, vi::common::vector2 const& size);
+            /**
+             * Sets the page of the region as texture and updates the atlas information and the size of the sprite to match the region.
+             * @remark If the sprite shares its material, the material must already use the page of the region as texture.
+             **/
+            void setTextureRegion(vi::graphic::textureRegion const& region);
+            /**
+             * Sets a convex polygon that replaces the quad of the sprite, normalized to the size of the sprite with y pointing down. An empty hull
+             * restores the quad. Used to skip the transparent parts of the texture, see vi::graphic::alphaHull.
+             * @remark Only works if the sprite owns its mesh. setTextureRegion() automatically uses the hull of the region.
+             **/
+            void setHull(std::vector<vi::common::vector2> const& hull);
+            /**
+             * Sets the layer of the vi::graphic::textureArray that is used as texture, which is written into the texture coordinates of the mesh.
+             * @remark Only works if the sprite writes its atlas information into the mesh, like the sprites of a sprite batch.
+             **/
+            void setTextureLayer(uint32_t layer);
+            /**
+             * Returns the texture array layer of the sprite.
+             **/
+            uint32_t getTextureLayer();
             /**
              * Sets a new color, which is written into the mesh if the sprite owns the mesh.
              * @remark Animatable
@@ -108,15 +130,19 @@ namespace vi
         private:
             void createFromMeshAndMaterial(vi::graphic::texture *texture, vi::common::mesh *sharedMesh, vi::graphic::material *sharedMaterial);
             void forceSetColor(vi::common::color const& color);
+            vi::common::vector2 shapePoint(uint32_t index);
             
             bool writeAtlasInfoIntoMesh;
             bool writeSizeInformationIntoMesh;
             
             bool isUpsideDown;
             bool ownsMesh;
+            
+            uint32_t textureLayer;
             bool ownsMaterial;
             
             vi::common::color tempColor;
+            std::vector<vi::common::vector2> hull;
         };
     }
 }
@@ -9,6 +9,7 @@
 #import "ViSprite.h"
 #import "ViVector3.h"
 #import "ViContext.h"
+#import "ViTextureArray.h"
 #import "ViScene.h"
 #import "ViAnimationServer.h"
 
@@ -62,6 +63,7 @@ namespace vi
             writeAtlasInfoIntoMesh = false;
             writeSizeInformationIntoMesh = false;
             isUpsideDown = false;
+            textureLayer = 0;
             
             if(!sharedMaterial)
             {
@@ -89,6 +91,8 @@ namespace vi
                 sharedMesh->addIndex(1);
                 sharedMesh->addIndex(3);
                 
+                // Packed sprites are copied into packed batches without converting every vertex each frame
+                sharedMesh->setVertexFormat(vi::common::vertexFormatPacked);
                 ownsMesh = true;
             }
             
@@ -115,18 +119,18 @@ namespace vi
             {                
                 vi::common::vertex *vertices = ((vi::common::mesh *)mesh)->getVertices();
                 
-                vertices[0].x = 0.0;
-                vertices[0].y = size.y;
-                
-                vertices[1].x = size.x;
-                vertices[1].y = size.y;
-                
-                vertices[2].x = size.x;
-                vertices[2].y = 0.0;
+                for(uint32_t i=0; i<mesh->vertexCount; i++)
+                {
+                    vi::common::vector2 point = shapePoint(i);
+                    
+                    vertices[i].x = point.x * size.x;
+                    vertices[i].y = (1.0f - point.y) * size.y;
+                }
                 
-                vertices[3].x = 0.0;
-                vertices[3].y = 0.0;
+                mesh->dirty = true;
             }
+            
+            setNeedsContentUpdate();
         }
         
         void sprite::visit(double timestep)
@@ -173,28 +177,112 @@ namespace vi
                 
                 if(writeAtlasInfoIntoMesh && ownsMesh)
                 {
-                    CGFloat endU = (begin.x + size.x) / texture->getWidth();
-                    CGFloat endV = (begin.y + size.y) / texture->getHeight();
+                    // The layer offset moves u past 1.0, which the normalized texture coordinates of packed vertices can't hold
+                    if(textureLayer > 0)
+                        ((vi::common::mesh *)mesh)->setVertexFormat(vi::common::vertexFormatFloat);
                     
                     vi::common::vertex *vertices = ((vi::common::mesh *)mesh)->getVertices();
+                    GLfloat layerOffset = vi::graphic::textureArray::layerOffset(textureLayer);
                     
-                    vertices[0].u = atlasX;
-                    vertices[0].v = atlasY;
+                    for(uint32_t i=0; i<mesh->vertexCount; i++)
+                    {
+                        vi::common::vector2 point = shapePoint(i);
+                        
+                        vertices[i].u = atlasX + point.x * atlasZ + layerOffset;
+                        vertices[i].v = atlasY + point.y * atlasW;
+                    }
                     
-                    vertices[1].u = endU;
-                    vertices[1].v = atlasY;
-                    
-                    vertices[2].u = endU;
-                    vertices[2].v = endV;
-                    
-                    vertices[3].u = atlasX;
-                    vertices[3].v = endV;
+                    mesh->dirty = true;
                 }
             }
             
             this->setSize(size);
         }
         
+        void sprite::setTextureRegion(vi::graphic::textureRegion const& region)
+        {
+            setTexture(region.page);
+            setAtlas(region.origin, region.size);
+            setSize(region.size);
+            setHull(region.hull);
+        }
+        
+        void sprite::setHull(std::vector<vi::common::vector2> const& thull)
+        {
+            if(!mesh || !ownsMesh || (hull.empty() && thull.empty()))
+                return;
+            
+            hull = thull;
+            
+            mesh->vertexCount = 0;
+            mesh->indexCount  = 0;
+            
+            if(hull.size() < 3)
+            {
+                hull.clear();
+                
+                for(uint32_t i=0; i<4; i++)
+                {
+                    vi::common::vector2 point = shapePoint(i);
+                    mesh->addVertex(point.x, 1.0f - point.y, point.x, point.y);
+                }
+                
+                mesh->addIndex(0);
+                mesh->addIndex(3);
+                mesh->addIndex(1);
+                mesh->addIndex(2);
+                mesh->addIndex(1);
+                mesh->addIndex(3);
+            }
+            else
+            {
+                for(uint32_t i=0; i<hull.size(); i++)
+                {
+                    vi::common::vector2 point = shapePoint(i);
+                    mesh->addVertex(point.x, 1.0f - point.y, point.x, point.y);
+                }
+                
+                // The hull has a positive area with y pointing down, so the fan is flipped to keep the winding of the quad
+                for(uint32_t i=1; i+1<hull.size(); i++)
+                {
+                    mesh->addIndex(0);
+                    mesh->addIndex(i + 1);
+                    mesh->addIndex(i);
+                }
+            }
+            
+            for(uint32_t i=0; i<mesh->vertexCount; i++)
+                mesh->updateColor(i, tempColor);
+            
+            // Writes the atlas and size information into the new vertices if needed
+            setAtlas(atlasBegin, atlasSize);
+            setSize(size);
+        }
+        
+        void sprite::setTextureLayer(uint32_t layer)
+        {
+            if(textureLayer == layer)
+                return;
+            
+            textureLayer = layer;
+            setAtlas(atlasBegin, atlasSize);
+        }
+        
+        uint32_t sprite::getTextureLayer()
+        {
+            return textureLayer;
+        }
+        
+        vi::common::vector2 sprite::shapePoint(uint32_t index)
+        {
+            if(hull.size() > 0)
+                return hull[index];
+            
+            // The corners of the quad in the order of its vertices
+            static const float quad[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+            return vi::common::vector2(quad[index][0], quad[index][1]);
+        }
+        
         void sprite::setColor(vi::common::color const& color)
         {
             if(mesh && ownsMesh && scene)
@@ -217,10 +305,10 @@ namespace vi
         
         void sprite::forceSetColor(vi::common::color const& color)
         {
-            mesh->updateColor(0, color);
-            mesh->updateColor(1, color);
-            mesh->updateColor(2, color);
-            mesh->updateColor(3, color);
+            for(uint32_t i=0; i<mesh->vertexCount; i++)
+                mesh->updateColor(i, color);
+            
+            setNeedsContentUpdate();
         }
         
         void sprite::setWriteAtlasInformationIntoMesh()
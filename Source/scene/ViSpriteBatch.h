@@ -11,6 +11,7 @@
 #import "ViTexture.h"
 #import "ViSceneNode.h"
 #import "ViSprite.h"
+#import "ViNineSliceSprite.h"
 
 namespace vi
 {
@@ -43,6 +44,19 @@ namespace vi
              * @sa generateMesh()
              **/
             vi::scene::sprite *addSprite();
+            /**
+             * Adds a new sprite showing the given region of a texture atlas and returns it. If the sprite batch has no texture yet, the page of the region
+             * becomes its texture, otherwise the region must be part of the sprite batches texture. If the sprite batch uses a vi::graphic::textureArray,
+             * the page is added to the array if needed and the sprite uses its layer.
+             * @remark Use one sprite batch per atlas page to draw all sprites of the page with one draw call, or a texture array to combine equally sized pages.
+             **/
+            vi::scene::sprite *addSprite(vi::graphic::textureRegion const& region);
+            /**
+             * Adds a new nine slice sprite showing the given region of a texture atlas and returns it. The same rules as for addSprite() apply to the region,
+             * including the layer of a vi::graphic::textureArray.
+             * @remark Nine slice sprites are removed with removeChild() and must be deleted by the caller.
+             **/
+            vi::scene::nineSliceSprite *addNineSliceSprite(vi::graphic::textureRegion const& region, float left, float top, float right, float bottom);
             /**
              * Removes the given sprite.
              * @sa generateMesh()
@@ -50,7 +64,8 @@ namespace vi
             void removeSprite(vi::scene::sprite *sprite);
             
             /**
-             * Sets a new texture.
+             * Sets a new texture. If the texture is a vi::graphic::textureArray, the sprite batch switches to the vi::graphic::defaultShaderTextureArray
+             * shader and its sprites select their layer with vi::scene::sprite::setTextureLayer().
              * @sa generateMesh()
              **/
             void setTexture(vi::graphic::texture *texture);
@@ -59,6 +74,9 @@ namespace vi
              * Deprecated in Vinter 0.4.0
              **/
             ViDeprecated void generateMesh(bool generateVBO=true);
+            
+        private:
+            int32_t layerForRegion(vi::graphic::textureRegion const& region);
         };
     }
 }
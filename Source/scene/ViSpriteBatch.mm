@@ -9,6 +9,7 @@
 #import "ViSpriteBatch.h"
 #import "ViContext.h"
 #import "ViMaterial.h"
+#import "ViTextureArray.h"
 
 namespace vi
 {
@@ -24,6 +25,9 @@ namespace vi
             material->blendSource = GL_ONE;
             material->blendDestination = GL_ONE_MINUS_SRC_ALPHA;
             
+            if(texture)
+                setTexture(texture);
+            
             setFlags(flags | vi::scene::sceneNodeFlagConcatenateChildren);
         }
         
@@ -43,6 +47,51 @@ namespace vi
             return sprite;
         }
         
+        vi::scene::sprite *spriteBatch::addSprite(vi::graphic::textureRegion const& region)
+        {
+            int32_t layer = layerForRegion(region);
+            
+            vi::scene::sprite *sprite = addSprite();
+            sprite->setTextureLayer(layer);
+            sprite->setTextureRegion(region);
+            
+            return sprite;
+        }
+        
+        vi::scene::nineSliceSprite *spriteBatch::addNineSliceSprite(vi::graphic::textureRegion const& region, float left, float top, float right, float bottom)
+        {
+            int32_t layer = layerForRegion(region);
+            
+            vi::scene::nineSliceSprite *sprite = new vi::scene::nineSliceSprite(region, left, top, right, bottom, material);
+            sprite->setTextureLayer(layer);
+            
+            addChild(sprite);
+            return sprite;
+        }
+        
+        int32_t spriteBatch::layerForRegion(vi::graphic::textureRegion const& region)
+        {
+            if(material->textures.size() == 0 || material->textures[0] == NULL)
+            {
+                setTexture(region.page);
+                return 0;
+            }
+            
+            if(material->textures[0]->getTarget() != GL_TEXTURE_2D)
+            {
+                int32_t layer = ((vi::graphic::textureArray *)material->textures[0])->addTexture(region.page);
+                if(layer == -1)
+                    throw "The region can't be added to the sprite batches texture array!";
+                
+                return layer;
+            }
+            
+            if(material->textures[0] != region.page)
+                throw "The region isn't part of the sprite batches texture!";
+            
+            return 0;
+        }
+        
         void spriteBatch::removeSprite(vi::scene::sprite *sprite)
         {
             removeChild(sprite);
@@ -61,7 +110,13 @@ namespace vi
                 material->textures[0] = texture;
             }
             
-            // Apply texture...
+            vi::common::context *context = vi::common::context::getActiveContext();
+            assert(context);
+            
+            bool isArray = (texture && texture->getTarget() != GL_TEXTURE_2D);
+            material->shader = context->getShader(isArray ? vi::graphic::defaultShaderTextureArray : vi::graphic::defaultShaderTexture);
+            
+            setNeedsContentUpdate();
         }
         
         void spriteBatch::generateMesh(bool generateVBO)
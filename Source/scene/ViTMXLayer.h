@@ -30,7 +30,11 @@ namespace vi
             tmxTileset(vi::common::xmlElement *element);
             ~tmxTileset();
             
+            bool isTileOpaque(uint32_t gid);
+            
         private:            
+            void findOpaqueTiles();
+            
             std::string name;
             
             uint32_t firstGid;
@@ -39,6 +43,8 @@ namespace vi
             uint32_t tileHeight;
             
             vi::graphic::texture *texture;
+            int32_t arrayLayer;
+            std::vector<bool> opaqueTiles;
         };
         /**
          * @endcond
@@ -68,7 +74,44 @@ namespace vi
              **/
             std::string getName();
             
+            /**
+             * Returns the global id of the tile at the given position, or 0 if the position is empty or outside of the layer.
+             **/
+            uint32_t getTile(uint32_t x, uint32_t y);
+            /**
+             * Sets the tile at the given position, 0 removes the tile. The tile must be part of the tileset that is used by the layer, unless the
+             * tilesets of the map share a texture array, in which case tiles of all tilesets can be used.
+             * @remark The tiles of the other layers at this position are hidden or shown again depending on whether they are covered now. Tiles that
+             * are placed on an empty position are drawn after the other tiles of the layer.
+             **/
+            void setTile(uint32_t x, uint32_t y, uint32_t gid);
+            /**
+             * Returns true if every pixel of the tile at the given position is opaque.
+             * @remark Opacity is only known for tilesets whose texture has no alpha channel, or which were loaded from an image other than PVR.
+             **/
+            bool isTileOpaque(uint32_t x, uint32_t y);
+            /**
+             * Returns true if the tile at the given position is hidden because an opaque tile of a layer above covers it.
+             **/
+            bool isTileHidden(uint32_t x, uint32_t y);
+            
+            /**
+             * Returns the width of the layer in tiles
+             **/
+            uint32_t getWidth();
+            /**
+             * Returns the height of the layer in tiles
+             **/
+            uint32_t getHeight();
+            
         private:
+            friend class tmxNode;
+            
+            void placeTile(uint32_t x, uint32_t y, uint32_t gid);
+            void setTileHidden(uint32_t x, uint32_t y, bool hidden);
+            vi::common::vector2 getTileSize(uint32_t x, uint32_t y);
+            tmxTileset *tilesetForGid(uint32_t gid);
+            
             tmxTileset *tileset;
             tmxNode *node;
             
@@ -76,6 +119,9 @@ namespace vi
             
             uint32_t width;
             uint32_t height;
+            
+            std::vector<uint32_t> tiles;
+            std::vector<vi::scene::sprite *> sprites;
         };
     }
     
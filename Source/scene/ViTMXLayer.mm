@@ -11,6 +11,7 @@
 #import "ViDataPool.h"
 #import "ViTexture.h"
 #import "ViTexturePVR.h"
+#import "ViTextureArray.h"
 
 namespace vi
 {
@@ -23,6 +24,7 @@ namespace vi
             std::string _tileWidth = element->valueOfAttributeNamed("tilewidth");
             std::string _tileHeight = element->valueOfAttributeNamed("tileheight");
             
+            arrayLayer  = -1;
             firstGid    = (uint32_t)atol(_firstgid.c_str());
             tileWidth   = (uint32_t)atol(_tileWidth.c_str());
             tileHeight  = (uint32_t)atol(_tileHeight.c_str());
@@ -31,8 +33,19 @@ namespace vi
             std::string textureName = image->valueOfAttributeNamed("source");
             bool isPVR = (textureName.find("pvr") != std::string::npos);
             
+            // The pixels are only needed to find the opaque tiles
+            bool keepsPixelData = vi::graphic::texture::getKeepsPixelData();
+            vi::graphic::texture::setKeepsPixelData(true);
+            
             texture = (isPVR == false) ? new vi::graphic::texture(textureName) : new vi::graphic::texturePVR(textureName);
-            lastGid = (texture->getWidth() / tileWidth) * (texture->getHeight() / tileHeight);
+            lastGid = firstGid + (texture->getWidth() / tileWidth) * (texture->getHeight() / tileHeight) - 1;
+            
+            vi::graphic::texture::setKeepsPixelData(keepsPixelData);
+            
+            findOpaqueTiles();
+            
+            if(!keepsPixelData)
+                texture->purgePixelData();
         }
         
         tmxTileset::~tmxTileset()
@@ -41,6 +54,55 @@ namespace vi
         }
         
         
+        void tmxTileset::findOpaqueTiles()
+        {
+            uint32_t columns = texture->getWidth() / tileWidth;
+            uint32_t rows    = texture->getHeight() / tileHeight;
+            
+            opaqueTiles.assign(columns * rows, !texture->hasAlphaChannel());
+            
+            const uint8_t *pixels = texture->getPixelData();
+            if(!pixels || !texture->hasAlphaChannel())
+                return;
+            
+            float factor = texture->getScaleFactor();
+            uint32_t rowLength = (uint32_t)lroundf(texture->getWidth() * factor);
+            uint32_t width  = (uint32_t)lroundf(tileWidth * factor);
+            uint32_t height = (uint32_t)lroundf(tileHeight * factor);
+            
+            for(uint32_t tile=0; tile<opaqueTiles.size(); tile++)
+            {
+                uint32_t left = (tile % columns) * width;
+                uint32_t top  = (tile / columns) * height;
+                bool opaque = true;
+                
+                for(uint32_t y=top; y<top + height && opaque; y++)
+                {
+                    const uint8_t *row = pixels + ((size_t)y * rowLength + left) * 4;
+                    
+                    for(uint32_t x=0; x<width; x++)
+                    {
+                        if(row[x * 4 + 3] != 255)
+                        {
+                            opaque = false;
+                            break;
+                        }
+                    }
+                }
+                
+                opaqueTiles[tile] = opaque;
+            }
+        }
+        
+        bool tmxTileset::isTileOpaque(uint32_t gid)
+        {
+            if(gid < firstGid || gid - firstGid >= opaqueTiles.size())
+                return false;
+            
+            return opaqueTiles[gid - firstGid];
+        }
+        
+        
         
         
         tmxLayer::tmxLayer(vi::common::xmlElement *element, tmxNode *tnode)
@@ -85,55 +147,24 @@ namespace vi
             } while(gid == 0);
             
             tileset = node->tilesetContainingGid(gid);
-            setTexture(tileset->texture);
+            setTexture(node->getTilesetArray() ? node->getTilesetArray() : tileset->texture);
             
-            vi::common::vector2 textureSize = vi::common::vector2(tileset->texture->getWidth(), tileset->texture->getHeight());
             vi::common::vector2 tileSize = vi::common::vector2(node->getTileWidth(), node->getTileHeight());
-            
-            
             setSize(vi::common::vector2(width, height) * tileSize);
             
-            i = 0;
-            vi::scene::tmxNodeOrientation orientation = node->getOrientation();
-            int32_t origin = width * tileSize.x / 2;
+            tiles.resize(width * height, 0);
+            sprites.resize(width * height, NULL);
             
-            for(int32_t y=0; y<height; y++)
+            i = 0;
+            for(uint32_t y=0; y<height; y++)
             {
-                for(int32_t x=0; x<width; x++)
+                for(uint32_t x=0; x<width; x++)
                 {
                     memcpy(&gid, &data[i], sizeof(uint32_t));
                     gid = CFSwapInt32LittleToHost(gid);
                     
                     if(gid > 0) 
-                    {
-                        gid -= tileset->firstGid;
-                        
-                        vi::scene::sprite *sprite = addSprite();
-                        vi::common::vector2 spritePos;
-                        vi::common::vector2 texSize = vi::common::vector2(tileset->tileWidth, tileset->tileHeight);
-                        vi::common::vector2 atlas = vi::common::vector2(gid % (uint32_t)(tileset->texture->getWidth() / texSize.x),
-                                                                        gid / (uint32_t)(tileset->texture->getWidth() / texSize.y));
-                        
-
-                        switch(orientation)
-                        {
-                            case tmxNodeOrientationOrthogonal:
-                                spritePos = vi::common::vector2(x * tileSize.x, y * tileSize.y);
-                                break;
-                                
-                            case tmxNodeOrientationIsometric:
-                                spritePos = vi::common::vector2(((x - y) * (tileSize.x * 0.5)) + origin,
-                                                                (x + y) * tileSize.y * 0.5);
-                                break;
-                                
-                            default:
-                                break;
-                        }
-                        
-                        
-                        sprite->setPosition(spritePos);
-                        sprite->setAtlas(atlas * texSize, texSize);
-                    }
+                        placeTile(x, y, gid);
                     
                     i += sizeof(uint32_t);
                 }
@@ -148,5 +179,154 @@ namespace vi
         {
             return name;
         }
+        
+        uint32_t tmxLayer::getWidth()
+        {
+            return width;
+        }
+        
+        uint32_t tmxLayer::getHeight()
+        {
+            return height;
+        }
+        
+        
+        
+        uint32_t tmxLayer::getTile(uint32_t x, uint32_t y)
+        {
+            if(x >= width || y >= height || tiles.size() == 0)
+                return 0;
+            
+            return tiles[y * width + x];
+        }
+        
+        void tmxLayer::setTile(uint32_t x, uint32_t y, uint32_t gid)
+        {
+            if(x >= width || y >= height || tiles.size() == 0)
+                return;
+            
+            if(gid > 0 && node->tilesetContainingGid(gid) != tilesetForGid(gid))
+            {
+                ViLog(@"Tile %u isn't part of the tileset of TMX layer %s!", gid, name.c_str());
+                return;
+            }
+            
+            if(tiles[y * width + x] == gid)
+                return;
+            
+            placeTile(x, y, gid);
+            setNeedsContentUpdate();
+            
+            node->updateHiddenTiles(x, y);
+        }
+        
+        bool tmxLayer::isTileOpaque(uint32_t x, uint32_t y)
+        {
+            uint32_t gid = getTile(x, y);
+            return (gid > 0 && tilesetForGid(gid)->isTileOpaque(gid));
+        }
+        
+        bool tmxLayer::isTileHidden(uint32_t x, uint32_t y)
+        {
+            if(getTile(x, y) == 0)
+                return false;
+            
+            return (sprites[y * width + x]->getFlags() & vi::scene::sceneNodeFlagHidden);
+        }
+        
+        
+        
+        void tmxLayer::placeTile(uint32_t x, uint32_t y, uint32_t gid)
+        {
+            uint32_t index = y * width + x;
+            vi::scene::sprite *sprite = sprites[index];
+            
+            tiles[index] = gid;
+            
+            if(gid == 0)
+            {
+                if(sprite)
+                    removeSprite(sprite);
+                
+                sprites[index] = NULL;
+                return;
+            }
+            
+            if(!sprite)
+            {
+                vi::common::vector2 tileSize = vi::common::vector2(node->getTileWidth(), node->getTileHeight());
+                vi::common::vector2 spritePos;
+                
+                switch(node->getOrientation())
+                {
+                    case tmxNodeOrientationOrthogonal:
+                        spritePos = vi::common::vector2(x * tileSize.x, y * tileSize.y);
+                        break;
+                        
+                    case tmxNodeOrientationIsometric:
+                        spritePos = vi::common::vector2((((int32_t)x - (int32_t)y) * (tileSize.x * 0.5)) + (int32_t)(width * tileSize.x / 2),
+                                                        (x + y) * tileSize.y * 0.5);
+                        break;
+                        
+                    default:
+                        break;
+                }
+                
+                sprite = addSprite();
+                sprite->setPosition(spritePos);
+                
+                sprites[index] = sprite;
+            }
+            
+            tmxTileset *tset = tilesetForGid(gid);
+            gid -= tset->firstGid;
+            
+            vi::common::vector2 texSize = vi::common::vector2(tset->tileWidth, tset->tileHeight);
+            vi::common::vector2 atlas = vi::common::vector2(gid % (uint32_t)(tset->texture->getWidth() / texSize.x),
+                                                            gid / (uint32_t)(tset->texture->getWidth() / texSize.x));
+            
+            if(tset->arrayLayer != -1)
+                sprite->setTextureLayer(tset->arrayLayer);
+            
+            sprite->setAtlas(atlas * texSize, texSize);
+        }
+        
+        void tmxLayer::setTileHidden(uint32_t x, uint32_t y, bool hidden)
+        {
+            vi::scene::sprite *sprite = (getTile(x, y) > 0) ? sprites[y * width + x] : NULL;
+            if(!sprite)
+                return;
+            
+            uint32_t flags = sprite->getFlags();
+            uint32_t tflags = hidden ? (flags | vi::scene::sceneNodeFlagHidden) : (flags & ~vi::scene::sceneNodeFlagHidden);
+            
+            if(flags != tflags)
+            {
+                sprite->setFlags(tflags);
+                setNeedsContentUpdate();
+            }
+        }
+        
+        vi::common::vector2 tmxLayer::getTileSize(uint32_t x, uint32_t y)
+        {
+            if(getTile(x, y) == 0)
+                return vi::common::vector2();
+            
+            tmxTileset *tset = tilesetForGid(getTile(x, y));
+            return vi::common::vector2(tset->tileWidth, tset->tileHeight);
+        }
+        
+        tmxTileset *tmxLayer::tilesetForGid(uint32_t gid)
+        {
+            // Layers using the texture array of the map can mix tiles of all tilesets
+            if(node->getTilesetArray())
+            {
+                tmxTileset *tset = node->tilesetContainingGid(gid);
+                if(tset)
+                    return tset;
+            }
+            
+            return tileset;
+        }
     }
 }
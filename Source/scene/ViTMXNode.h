@@ -11,6 +11,7 @@
 #import "ViBase.h"
 #import "ViXML.h"
 #import "ViTMXLayer.h"
+#import "ViTextureArray.h"
 #import "ViSceneNode.h"
 
 namespace vi
@@ -41,6 +42,10 @@ namespace vi
          *
          * A tmxNode can be created from an TMX file created by tiled ( http://www.mapeditor.org ), it automatically parses the TMX file
          * and creates the needed layers. You can simply add the node to your scene hierarchy.
+         * Tiles that are completely covered by an opaque tile of an upper layer are hidden, so that the fill rate isn't wasted on pixels that
+         * are overdrawn anyway.
+         * On a OpenGL 3.2 Core Profile context, the textures of the tilesets are copied into a vi::graphic::textureArray if they all have the same size.
+         * Layers can then use tiles from every tileset and are still drawn with a single draw call.
          **/
         class tmxNode : public sceneNode
         {
@@ -60,6 +65,7 @@ namespace vi
              **/
             tmxTileset *tilesetContainingGid(uint32_t gid);
             tmxTileset *tilesetWithName(std::string const& name);
+            vi::graphic::textureArray *getTilesetArray();
             /**
              * @endcond
              **/
@@ -86,7 +92,37 @@ namespace vi
              **/
             uint32_t getTileHeight();
             
+            /**
+             * Sets whether tiles that are covered by an opaque tile of an upper layer are hidden. A tile covers another tile if all of its pixels
+             * are opaque and it is at least as large as the other tile.
+             * @remark With linear texture filtering, the borders of opaque tiles can blend with their neighbours in the tileset, which might
+             * reveal slight seams that were previously hidden by the tiles below.
+             * @default true
+             **/
+            void setHidesCoveredTiles(bool hides);
+            /**
+             * Returns whether covered tiles are hidden.
+             **/
+            bool getHidesCoveredTiles();
+            /**
+             * Recomputes which tiles are covered. Changing a tile with tmxLayer::setTile() updates its position automatically, but this
+             * needs to be called after hiding a whole layer with vi::scene::sceneNodeFlagHidden.
+             **/
+            void updateHiddenTiles();
+            /**
+             * @cond
+             **/
+            void updateHiddenTiles(uint32_t x, uint32_t y);
+            /**
+             * @endcond
+             **/
+            
         private:
+            void createTilesetArray();
+            
+            bool hidesCoveredTiles;
+            vi::graphic::textureArray *tilesetArray;
+
             std::vector<vi::scene::tmxLayer *> _tmxLayer;
             std::vector<vi::scene::tmxTileset *> tmxTilesets;
             
@@ -19,6 +19,9 @@ namespace vi
     {             
         tmxNode::tmxNode(std::string const& file)
         {
+            hidesCoveredTiles = true;
+            tilesetArray = NULL;
+            
             vi::common::xmlParser *parser = new vi::common::xmlParser(file);
             vi::common::xmlElement *map = parser->getRootElement();
             if(map)
@@ -69,6 +72,9 @@ namespace vi
                     tilesetElement = tilesetElement->siblingNamed("tileset");
                 }
                 
+                if(tmxTilesets.size() > 1 && vi::graphic::textureArray::isSupported())
+                    createTilesetArray();
+                
                 // And all layers
                 vi::common::xmlElement *layerElement = map->childNamed("layer");
                 while(layerElement)
@@ -79,6 +85,8 @@ namespace vi
                     addChild(layer);
                     layerElement = layerElement->siblingNamed("layer");
                 }
+                
+                updateHiddenTiles();
             }
             
             delete parser;
@@ -103,6 +111,48 @@ namespace vi
                     delete layer;
                 }
             } while (0);
+            
+            if(tilesetArray)
+                delete tilesetArray;
+        }
+        
+        
+        void tmxNode::createTilesetArray()
+        {
+            vi::graphic::texture *texture = tmxTilesets[0]->texture;
+            float factor = texture->getScaleFactor();
+            
+            std::vector<vi::scene::tmxTileset *>::iterator iterator;
+            for(iterator=tmxTilesets.begin(); iterator!=tmxTilesets.end(); iterator++)
+            {
+                tmxTileset *tileset = *iterator;
+                
+                if(tileset->texture->getWidth() != texture->getWidth() || tileset->texture->getHeight() != texture->getHeight() || tileset->texture->getScaleFactor() != factor)
+                    return;
+            }
+            
+            uint32_t width  = (uint32_t)lroundf(texture->getWidth() * factor);
+            uint32_t height = (uint32_t)lroundf(texture->getHeight() * factor);
+            
+            tilesetArray = new vi::graphic::textureArray(width, height, (uint32_t)tmxTilesets.size(), factor);
+            
+            for(iterator=tmxTilesets.begin(); iterator!=tmxTilesets.end(); iterator++)
+            {
+                tmxTileset *tileset = *iterator;
+                tileset->arrayLayer = tilesetArray->addTexture(tileset->texture);
+                
+                if(tileset->arrayLayer == -1)
+                {
+                    // Compressed textures can't be copied, the layers fall back to one texture per layer
+                    delete tilesetArray;
+                    tilesetArray = NULL;
+                    
+                    for(iterator=tmxTilesets.begin(); iterator!=tmxTilesets.end(); iterator++)
+                        (*iterator)->arrayLayer = -1;
+                    
+                    return;
+                }
+            }
         }
         
         
@@ -134,6 +184,11 @@ namespace vi
             return NULL;
         }
         
+        vi::graphic::textureArray *tmxNode::getTilesetArray()
+        {
+            return tilesetArray;
+        }
+        
         tmxLayer *tmxNode::layerAtIndex(uint32_t index)
         {
             if(index >= _tmxLayer.size())
@@ -161,5 +216,58 @@ namespace vi
         {
             return tileHeight;
         }
+        
+        
+        
+        void tmxNode::setHidesCoveredTiles(bool hides)
+        {
+            if(hidesCoveredTiles == hides)
+                return;
+            
+            hidesCoveredTiles = hides;
+            updateHiddenTiles();
+        }
+        
+        bool tmxNode::getHidesCoveredTiles()
+        {
+            return hidesCoveredTiles;
+        }
+        
+        void tmxNode::updateHiddenTiles()
+        {
+            for(uint32_t y=0; y<mapHeight; y++)
+            {
+                for(uint32_t x=0; x<mapWidth; x++)
+                {
+                    updateHiddenTiles(x, y);
+                }
+            }
+        }
+        
+        void tmxNode::updateHiddenTiles(uint32_t x, uint32_t y)
+        {
+            for(size_t i=0; i<_tmxLayer.size(); i++)
+            {
+                tmxLayer *layer = _tmxLayer[i];
+                if(layer->getTile(x, y) == 0)
+                    continue;
+                
+                vi::common::vector2 size = layer->getTileSize(x, y);
+                bool hidden = false;
+                
+                // Only layers that are drawn above this one can cover its tile
+                for(size_t j=i+1; j<_tmxLayer.size() && hidesCoveredTiles && !hidden; j++)
+                {
+                    tmxLayer *upper = _tmxLayer[j];
+                    if((upper->getFlags() & vi::scene::sceneNodeFlagHidden) || !upper->isTileOpaque(x, y))
+                        continue;
+                    
+                    vi::common::vector2 upperSize = upper->getTileSize(x, y);
+                    hidden = (upperSize.x >= size.x && upperSize.y >= size.y);
+                }
+                
+                layer->setTileHidden(x, y, hidden);
+            }
+        }
     }
 }
@@ -0,0 +1,102 @@
+//
+//  ViTextNode.h
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <string>
+#import "ViBase.h"
+#import "ViSceneNode.h"
+#import "ViFont.h"
+#import "ViColor.h"
+
+namespace vi
+{
+    namespace scene
+    {
+        /**
+         * Possible alignments of the lines of a text node
+         **/
+        typedef enum
+        {
+            /**
+             * The lines start at the left edge of the node. This is the default.
+             **/
+            textAlignmentLeft,
+            /**
+             * The lines are centered inside the node.
+             **/
+            textAlignmentCenter,
+            /**
+             * The lines end at the right edge of the node.
+             **/
+            textAlignmentRight
+        } textAlignment;
+
+        /**
+         * @brief A scene node that renders a string with a bitmap font
+         *
+         * A text node lays out its UTF-8 string into one mesh with a quad per glyph, which is only rebuilt when the string, the color or the alignment
+         * changes. The material is the shared material of the font, so all text nodes using the same font are rendered without state changes in between.
+         * The size of the node is the size of the laid out text, line breaks are started with '\n'.
+         * @remark To draw many text nodes with a single draw call, add them as childs to a node with the sceneNodeFlagConcatenateChildren flag and the
+         * material of the font.
+         **/
+        class textNode : public sceneNode
+        {
+        public:
+            /**
+             * Constructor
+             * @param font The font used to render the text, must not be NULL. The font isn't owned by the node and must outlive it.
+             * @param text The initial text
+             **/
+            textNode(vi::graphic::font *font, std::string const& text="");
+            /**
+             * Destructor, deletes the mesh.
+             **/
+            virtual ~textNode();
+
+            /**
+             * Sets a new text. The mesh is only rebuilt if the text is different from the current one.
+             **/
+            void setText(std::string const& text);
+            /**
+             * Returns the current text
+             **/
+            std::string const& getText();
+
+            /**
+             * Sets the color of the text, which is written into the vertices of the mesh.
+             **/
+            void setColor(vi::common::color const& color);
+            /**
+             * Returns the color of the text
+             **/
+            vi::common::color getColor();
+
+            /**
+             * Sets the alignment of the lines.
+             **/
+            void setAlignment(vi::scene::textAlignment alignment);
+            /**
+             * Returns the alignment of the lines.
+             **/
+            vi::scene::textAlignment getAlignment();
+
+            /**
+             * Returns the font of the node
+             **/
+            vi::graphic::font *getFont();
+
+        private:
+            void layoutText();
+
+            vi::graphic::font *font;
+            std::string text;
+            vi::common::color color;
+            vi::scene::textAlignment alignment;
+        };
+    }
+}
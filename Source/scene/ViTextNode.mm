@@ -0,0 +1,273 @@
+//
+//  ViTextNode.mm
+//  Vinter
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <vector>
+#import "ViTextNode.h"
+
+#define kViTextNodeMaxGlyphs 16383
+
+namespace vi
+{
+    namespace scene
+    {
+        static void textNodeDecodeUTF8(std::string const& text, std::vector<uint32_t>& characters)
+        {
+            const uint8_t *bytes = (const uint8_t *)text.c_str();
+            size_t length = text.length();
+
+            for(size_t i=0; i<length;)
+            {
+                uint8_t byte = bytes[i];
+                uint32_t character;
+                size_t count;
+
+                if(byte < 0x80)
+                {
+                    character = byte;
+                    count = 0;
+                }
+                else if((byte & 0xe0) == 0xc0)
+                {
+                    character = byte & 0x1f;
+                    count = 1;
+                }
+                else if((byte & 0xf0) == 0xe0)
+                {
+                    character = byte & 0x0f;
+                    count = 2;
+                }
+                else if((byte & 0xf8) == 0xf0)
+                {
+                    character = byte & 0x07;
+                    count = 3;
+                }
+                else
+                {
+                    // Stray continuation byte
+                    i ++;
+                    continue;
+                }
+
+                i ++;
+
+                for(size_t j=0; j<count && i<length && (bytes[i] & 0xc0) == 0x80; j++, i++)
+                    character = (character << 6) | (bytes[i] & 0x3f);
+
+                characters.push_back(character);
+            }
+        }
+
+
+
+        textNode::textNode(vi::graphic::font *tfont, std::string const& ttext) : color(1.0, 1.0, 1.0, 1.0)
+        {
+            assert(tfont);
+
+            font = tfont;
+            alignment = textAlignmentLeft;
+
+            mesh = new vi::common::mesh(MAX(ttext.length(), 1) * 4, MAX(ttext.length(), 1) * 6);
+            material = font->getMaterial();
+            meshWithinSize = true;
+
+            text = ttext;
+            layoutText();
+        }
+
+        textNode::~textNode()
+        {
+            delete mesh;
+        }
+
+
+
+        void textNode::setText(std::string const& ttext)
+        {
+            if(text == ttext)
+                return;
+
+            text = ttext;
+            layoutText();
+        }
+
+        std::string const& textNode::getText()
+        {
+            return text;
+        }
+
+        void textNode::setColor(vi::common::color const& tcolor)
+        {
+            color = tcolor;
+
+            for(uint32_t i=0; i<mesh->vertexCount; i++)
+                mesh->updateColor(i, color);
+            
+            setNeedsContentUpdate();
+        }
+
+        vi::common::color textNode::getColor()
+        {
+            return color;
+        }
+
+        void textNode::setAlignment(vi::scene::textAlignment talignment)
+        {
+            if(alignment == talignment)
+                return;
+
+            alignment = talignment;
+            layoutText();
+        }
+
+        vi::scene::textAlignment textNode::getAlignment()
+        {
+            return alignment;
+        }
+
+        vi::graphic::font *textNode::getFont()
+        {
+            return font;
+        }
+
+
+
+        void textNode::layoutText()
+        {
+            std::vector<uint32_t> characters;
+            textNodeDecodeUTF8(text, characters);
+
+            // Measure the lines first, the alignment and the vertical position of the glyphs depend on the size of the whole text
+            std::vector<float> lineWidths;
+            float width = 0.0f;
+            float lineWidth = 0.0f;
+            uint32_t previous = 0;
+
+            std::vector<uint32_t>::iterator iterator;
+            for(iterator=characters.begin(); iterator!=characters.end(); iterator++)
+            {
+                uint32_t character = *iterator;
+
+                if(character == '\n')
+                {
+                    lineWidths.push_back(lineWidth);
+                    width = MAX(width, lineWidth);
+
+                    lineWidth = 0.0f;
+                    previous  = 0;
+                    continue;
+                }
+
+                const vi::graphic::fontGlyph *glyph = font->getGlyph(character);
+                if(!glyph)
+                    continue;
+
+                lineWidth += font->getKerning(previous, character) + glyph->advance;
+                previous = character;
+            }
+
+            lineWidths.push_back(lineWidth);
+            width = MAX(width, lineWidth);
+
+            float lineHeight = font->getLineHeight();
+            float height = text.length() > 0 ? lineWidths.size() * lineHeight : 0.0f;
+
+
+            vi::graphic::texture *texture = font->getTexture();
+            float textureWidth  = texture->getWidth();
+            float textureHeight = texture->getHeight();
+
+            mesh->vertexCount = 0;
+            mesh->indexCount  = 0;
+            mesh->dirty = true;
+
+            size_t line = 0;
+            float penX = 0.0f;
+            float penY = height;
+            uint32_t glyphCount = 0;
+            bool truncated = false;
+
+            if(lineWidths[0] < width)
+                penX = (alignment == textAlignmentCenter) ? roundf((width - lineWidths[0]) * 0.5f) : (alignment == textAlignmentRight) ? width - lineWidths[0] : 0.0f;
+
+            previous = 0;
+
+            for(iterator=characters.begin(); iterator!=characters.end(); iterator++)
+            {
+                uint32_t character = *iterator;
+
+                if(character == '\n')
+                {
+                    line ++;
+                    penY -= lineHeight;
+                    previous = 0;
+
+                    float offset = width - lineWidths[line];
+                    penX = (alignment == textAlignmentCenter) ? roundf(offset * 0.5f) : (alignment == textAlignmentRight) ? offset : 0.0f;
+                    continue;
+                }
+
+                const vi::graphic::fontGlyph *glyph = font->getGlyph(character);
+                if(!glyph)
+                    continue;
+
+                penX += font->getKerning(previous, character);
+                previous = character;
+
+                if(glyphCount >= kViTextNodeMaxGlyphs)
+                {
+                    truncated = true;
+                    break;
+                }
+
+                if(glyph->size.x > 0.0f && glyph->size.y > 0.0f)
+                {
+                    // The mesh has its origin at the bottom left, the glyph offsets are measured downwards from the top of the line
+                    float left   = penX + glyph->offset.x;
+                    float top    = penY - glyph->offset.y;
+                    float right  = left + glyph->size.x;
+                    float bottom = top - glyph->size.y;
+
+                    float beginU = glyph->origin.x / textureWidth;
+                    float beginV = glyph->origin.y / textureHeight;
+                    float endU   = (glyph->origin.x + glyph->size.x) / textureWidth;
+                    float endV   = (glyph->origin.y + glyph->size.y) / textureHeight;
+
+                    uint16_t index = (uint16_t)mesh->vertexCount;
+
+                    mesh->addVertex(left, top, beginU, beginV);
+                    mesh->addVertex(right, top, endU, beginV);
+                    mesh->addVertex(right, bottom, endU, endV);
+                    mesh->addVertex(left, bottom, beginU, endV);
+
+                    mesh->addIndex(index + 0);
+                    mesh->addIndex(index + 3);
+                    mesh->addIndex(index + 1);
+                    mesh->addIndex(index + 2);
+                    mesh->addIndex(index + 1);
+                    mesh->addIndex(index + 3);
+
+                    glyphCount ++;
+                }
+
+                penX += glyph->advance;
+            }
+
+            if(truncated)
+                ViLog(@"Text node contains more than %i glyphs, the remaining glyphs are skipped!", kViTextNodeMaxGlyphs);
+
+            if(color.r != 1.0f || color.g != 1.0f || color.b != 1.0f || color.a != 1.0f)
+            {
+                for(uint32_t i=0; i<mesh->vertexCount; i++)
+                    mesh->updateColor(i, color);
+            }
+
+            setNeedsContentUpdate();
+            sceneNode::setSize(vi::common::vector2(width, height));
+        }
+    }
+}
@@ -0,0 +1,169 @@
+//
+//  main.mm
+//  TraceReplay
+//
+//  Copyright 2011 by Nils Daumann and Sidney Just. All rights reserved.
+//  Unauthorized use is punishable by torture, mutilation, and vivisection.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#import <Foundation/Foundation.h>
+#import "Vinter.h"
+
+// Replays a render trace captured with vi::graphic::commandRenderer::captureTrace() and prints the time of the whole trace and of every draw.
+//
+// TraceReplay <trace> [-renderer gl|software|null] [-iterations n] [-draws file.csv]
+
+static bool compareTimings(vi::graphic::renderTraceTiming const& a, vi::graphic::renderTraceTiming const& b)
+{
+    return (a.time > b.time);
+}
+
+static void printUsage()
+{
+    printf("Usage: TraceReplay <trace> [-renderer gl|software|null] [-iterations n] [-draws file.csv]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    @autoreleasepool
+    {
+        if(argc < 2)
+        {
+            printUsage();
+            return 1;
+        }
+        
+        const char *path = argv[1];
+        const char *rendererName = "gl";
+        const char *drawsPath = NULL;
+        uint32_t iterations = 10;
+        
+        for(int i=2; i<argc; i++)
+        {
+            if(strcmp(argv[i], "-renderer") == 0 && i + 1 < argc)
+            {
+                rendererName = argv[++ i];
+            }
+            else if(strcmp(argv[i], "-iterations") == 0 && i + 1 < argc)
+            {
+                iterations = (uint32_t)MAX(atoi(argv[++ i]), 1);
+            }
+            else if(strcmp(argv[i], "-draws") == 0 && i + 1 < argc)
+            {
+                drawsPath = argv[++ i];
+            }
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        
+        
+        vi::graphic::commandRenderer *renderer = NULL;
+        
+        if(strcmp(rendererName, "gl") == 0)
+            renderer = new vi::graphic::rendererOSX();
+        
+        if(strcmp(rendererName, "software") == 0)
+            renderer = new vi::graphic::rendererSoftware();
+        
+        if(strcmp(rendererName, "null") == 0)
+            renderer = new vi::graphic::rendererNull();
+        
+        if(!renderer)
+        {
+            printUsage();
+            return 1;
+        }
+        
+        
+        // The trace has to be loaded first to know which GLSL version the context needs, the kernel takes ownership of the renderer
+        vi::graphic::renderTrace *trace = new vi::graphic::renderTrace();
+        vi::common::kernel *kernel = NULL;
+        
+        if(!trace->load(path))
+        {
+            delete trace;
+            delete renderer;
+            
+            return 1;
+        }
+        
+        vi::common::context *context = new vi::common::context(trace->getGLSLVersion());
+        context->activateContext();
+        
+        kernel = new vi::common::kernel(NULL, renderer, context);
+        
+        printf("%s: %u frames, %u command lists, %s renderer\n", path, trace->getFrameCount(), trace->getListCount(), rendererName);
+        
+        
+        // The first replay creates the resources and warms up the driver, it isn't measured
+        trace->replay(renderer);
+        
+        std::vector<double> times;
+        for(uint32_t i=0; i<iterations; i++)
+        {
+            times.push_back(trace->replay(renderer));
+        }
+        
+        std::sort(times.begin(), times.end());
+        
+        double average = 0.0;
+        for(size_t i=0; i<times.size(); i++)
+            average += times[i];
+        
+        average /= times.size();
+        
+        printf("Trace: min %.3f ms, median %.3f ms, average %.3f ms, max %.3f ms\n", times.front() * 1000.0, times[times.size() / 2] * 1000.0, average * 1000.0, times.back() * 1000.0);
+        
+        
+        // Per draw timings synchronize after every draw, so they are measured separately from the trace time
+        std::vector<vi::graphic::renderTraceTiming> timings;
+        trace->replay(renderer, &timings);
+        
+        if(timings.size() > 0)
+        {
+            if(drawsPath)
+            {
+                FILE *file = fopen(drawsPath, "w");
+                if(file)
+                {
+                    fprintf(file, "frame,list,command,indices,time_ms\n");
+                    
+                    for(size_t i=0; i<timings.size(); i++)
+                        fprintf(file, "%u,%u,%u,%u,%.6f\n", timings[i].frame, timings[i].list, timings[i].command, timings[i].indices, timings[i].time * 1000.0);
+                    
+                    fclose(file);
+                }
+                else
+                {
+                    printf("Couldn't write %s\n", drawsPath);
+                }
+            }
+            
+            std::vector<vi::graphic::renderTraceTiming> slowest = timings;
+            std::sort(slowest.begin(), slowest.end(), compareTimings);
+            
+            printf("%lu draws, slowest:\n", timings.size());
+            
+            for(size_t i=0; i<slowest.size() && i<10; i++)
+                printf("  frame %u, list %u, command %u: %u indices, %.3f ms\n", slowest[i].frame, slowest[i].list, slowest[i].command, slowest[i].indices, slowest[i].time * 1000.0);
+        }
+        else
+        {
+            printf("The %s renderer doesn't measure single draws\n", rendererName);
+        }
+        
+        delete trace;
+        delete kernel;
+        delete context;
+    }
+    
+    return 0;
+}